@@ -72,6 +72,10 @@ typedef struct {
     char init_script[MAX_SCRIPT_CONTENT];
     int iterations;
     double expected_time;  // in milliseconds
+    int cores[MAX_PARAMS];  // core counts to run with (--cores=1,8,32), no pool if empty
+    int cores_count;
+    int threads;  // core count of the current run
+    long rows;    // rows processed per iteration (--rows=N), to report throughput
 } bench_script_t;
 
 typedef struct {
@@ -80,6 +84,7 @@ typedef struct {
     double max_time;
     double avg_time;
     double expected_time;  // in milliseconds
+    long rows;             // rows processed per iteration, 0 if unknown
     char timestamp[MAX_TIMESTAMP];
     char os_info[MAX_OS_INFO];
     char cpu_info[MAX_CPU_INFO];
@@ -152,6 +157,7 @@ void get_git_commit(char* commit_hash, size_t hash_size) {
 void parse_script_params(const char* content, bench_script_t* script) {
     script->iterations = DEFAULT_ITERATIONS;
     script->expected_time = 0.0;
+    script->rows = 0;
 
     // Find the first line that starts with ;;
     const char* line = strstr(content, ";;");
@@ -175,10 +181,21 @@ void parse_script_params(const char* content, bench_script_t* script) {
     // Split the line into tokens and parse each parameter
     char* token = strtok(line_copy, " \t");
     while (token) {
-        if (strncmp(token, "--iterations=", 12) == 0) {
-            sscanf(token + 12, "%d", &script->iterations);
+        if (strncmp(token, "--iterations=", 13) == 0) {
+            sscanf(token + 13, "%d", &script->iterations);
         } else if (strncmp(token, "--expected-time=", 16) == 0) {
             sscanf(token + 16, "%lf", &script->expected_time);
+        } else if (strncmp(token, "--rows=", 7) == 0) {
+            sscanf(token + 7, "%ld", &script->rows);
+        } else if (strncmp(token, "--cores=", 8) == 0) {
+            char* cores = token + 8;
+            while (*cores && script->cores_count < MAX_PARAMS) {
+                script->cores[script->cores_count++] = atoi(cores);
+                cores = strchr(cores, ',');
+                if (!cores)
+                    break;
+                cores++;
+            }
         }
         token = strtok(NULL, " \t");
     }
@@ -189,6 +206,7 @@ void run_benchmark(bench_script_t* script, bench_result_t* result) {
     strncpy(result->script_name, script->name, sizeof(result->script_name) - 1);
     result->script_name[sizeof(result->script_name) - 1] = '\0';
     result->expected_time = script->expected_time;
+    result->rows = script->rows;
 
     // Get system info
     get_system_info(result->os_info, sizeof(result->os_info), result->cpu_info, sizeof(result->cpu_info));
@@ -209,6 +227,10 @@ void run_benchmark(bench_script_t* script, bench_result_t* result) {
     // Initialize runtime environment once for all iterations
     runtime_create(0, NULL);
 
+    // Executors pool for multi-core runs (-1 for the main thread)
+    if (script->threads > 1)
+        runtime_get()->pool = pool_create(script->threads - 1);
+
     // Run initialization script if present
     if (script->init_script[0] != '\0') {
         printf("Evaluating init script for %s (%zu bytes)\n", script->name, strlen(script->init_script));
@@ -465,6 +487,10 @@ void compare_and_print_results(bench_result_t* current, bench_result_t* previous
         printf("\n%sSummary:%s First run of this benchmark\n", MAGENTA, RESET);
     }
 
+    // Throughput is only known for the current run
+    if (current->rows > 0 && current->avg_time > 0.0)
+        printf("  %sThroughput:%s %.2f Mrows/s\n", BLUE, RESET, current->rows / current->avg_time / 1000.0);
+
     // Always show expected time comparison if it's set
     if (current->expected_time > 0.0) {
         printf("\n%sExpected Time:%s %.3f ms ", BLUE, RESET, current->expected_time);
@@ -579,13 +605,22 @@ void process_script_file(const char* filename, bench_results_t* results) {
     // Parse script parameters
     parse_script_params(script.content, &script);
 
-    // Run benchmark and store results if there's space
-    if (results->result_count < MAX_RESULTS) {
-        bench_result_t result = {0};  // Initialize to zero
-        run_benchmark(&script, &result);
-        results->results[results->result_count++] = result;
-    } else {
-        printf("Warning: Maximum number of results reached, skipping %s\n", script_name);
+    // Run once without a pool, or once per requested core count (results are named script@cores)
+    int runs = script.cores_count > 0 ? script.cores_count : 1;
+    for (int r = 0; r < runs; r++) {
+        if (script.cores_count > 0) {
+            script.threads = script.cores[r];
+            snprintf(script.name, sizeof(script.name), "%s@%d", script_name, script.threads);
+        }
+
+        // Run benchmark and store results if there's space
+        if (results->result_count < MAX_RESULTS) {
+            bench_result_t result = {0};  // Initialize to zero
+            run_benchmark(&script, &result);
+            results->results[results->result_count++] = result;
+        } else {
+            printf("Warning: Maximum number of results reached, skipping %s\n", script.name);
+        }
     }
 }
 
@@ -668,7 +703,7 @@ int main(int argc, char* argv[]) {
     // Update only the results that were run
     if (specific_tests) {
         // For each result we just ran
-        for (int i = 1; i < results.result_count; i++) {
+        for (int i = 0; i < results.result_count; i++) {
             // Find matching previous result
             bench_result_t* previous = NULL;
             for (int j = 0; j < previous_results.result_count; j++) {
@@ -698,7 +733,7 @@ int main(int argc, char* argv[]) {
     if (results.result_count > 0) {
         // If running specific tests, only update those tests in the previous results
         if (specific_tests) {
-            for (int i = 1; i < results.result_count; i++) {
+            for (int i = 0; i < results.result_count; i++) {
                 for (int j = 0; j < previous_results.result_count; j++) {
                     if (strcmp(results.results[i].script_name, previous_results.results[j].script_name) == 0) {
                         previous_results.results[j] = results.results[i];
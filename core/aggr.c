@@ -21,6 +21,7 @@
  *   SOFTWARE.
  */
 
+#include <math.h>
 #include "aggr.h"
 #include "math.h"
 #include "ops.h"
@@ -33,44 +34,12 @@
 #include "runtime.h"
 #include "index.h"
 #include "pool.h"
-
-i64_t indexr_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
-    i64_t left, right, mid, idx;
-    left = 0, right = len - 1, idx = 0;
-    vals += offset;
-    while (left <= right) {
-        mid = left + (right - left) / 2;
-        if (vals[mid] <= val) {
-            idx = mid;
-            left = mid + 1;
-        } else {
-            right = mid - 1;
-        }
-    }
-
-    return idx + offset;
-}
-
-i64_t indexl_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
-    i64_t left, right, mid, idx;
-    left = 0, right = len - 1, idx = 0;
-    vals += offset;
-    while (left <= right) {
-        mid = left + (right - left) / 2;
-        if (vals[mid] < val) {
-            left = mid + 1;
-        } else {
-            idx = mid;
-            right = mid - 1;
-        }
-    }
-
-    return idx + offset;
-}
+#include "serde.h"  // for size_of_type
+#include "io.h"
 
 #define AGGR_ITER(Index, Len, Offset, Val, Res, Incoerce, Outcoerse, Ini, Aggr, Null)                  \
     ({                                                                                                 \
-        i64_t $i, $x, $y, $n, $o, $li, $ri, $fi, $ti, $kl, $kr, $it;                                   \
+        i64_t $i, $x, $y, $n, $o, $li, $ri;                                                            \
         i64_t *group_ids, *source, *filter, shift;                                                     \
         obj_p $rn;                                                                                     \
         index_type_t index_type;                                                                       \
@@ -129,26 +98,14 @@ i64_t indexl_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
                 }                                                                                      \
                 break;                                                                                 \
             case INDEX_TYPE_WINDOW:                                                                    \
-                $it = index_group_meta(Index)->i64;                                                    \
+                $rn = AS_LIST(Index)[5];                                                               \
                 for ($i = Offset; $i < Offset + Len; ++$i) {                                           \
                     $y = $i;                                                                           \
-                    $rn = AS_LIST(AS_LIST(Index)[5])[$i];                                              \
-                    if ($rn != NULL_OBJ) {                                                             \
-                        $fi = AS_I64($rn)[0];                                                          \
-                        $ti = AS_I64($rn)[1];                                                          \
-                        $kl = AS_I32(AS_LIST(AS_LIST(Index)[4])[0])[$i];                               \
-                        $kr = AS_I32(AS_LIST(AS_LIST(Index)[4])[1])[$i];                               \
-                        if ($it == 0) {                                                                \
-                            $li = indexr_bin_i32_($kl, AS_I32(AS_LIST(Index)[3]), $fi, $ti - $fi + 1); \
-                        } else {                                                                       \
-                            $li = indexl_bin_i32_($kl, AS_I32(AS_LIST(Index)[3]), $fi, $ti - $fi + 1); \
-                        }                                                                              \
-                        $ri = indexr_bin_i32_($kr, AS_I32(AS_LIST(Index)[3]), $fi, $ti - $fi + 1);     \
-                    }                                                                                  \
-                    if ($rn == NULL_OBJ || AS_I32(AS_LIST(Index)[3])[$li] > $kr ||                     \
-                        ($it == 1 && AS_I32(AS_LIST(Index)[3])[$ri] < $kl)) {                          \
+                    $li = AS_I64(AS_LIST($rn)[0])[$i];                                                 \
+                    if ($li == NULL_I64) {                                                             \
                         Null;                                                                          \
                     } else {                                                                           \
+                        $ri = AS_I64(AS_LIST($rn)[1])[$i];                                             \
                         for ($x = $li; $x <= $ri; ++$x) {                                              \
                             Aggr;                                                                      \
                         }                                                                              \
@@ -178,6 +135,21 @@ i64_t indexl_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
         $res;                                                  \
     })
 
+// A partition is about to be scanned in full: read it sequentially and prefetch the next selected one
+static nil_t aggr_parted_advise(obj_p val, obj_p filter, i64_t i) {
+    i64_t l;
+
+    io_advise(AS_LIST(val)[i], MMAP_ADVICE_SEQUENTIAL);
+
+    l = val->len;
+    for (i = i + 1; i < l; i++) {
+        if (filter == NULL_OBJ || AS_LIST(filter)[i] != NULL_OBJ) {
+            io_advise(AS_LIST(val)[i], MMAP_ADVICE_WILLNEED);
+            return;
+        }
+    }
+}
+
 #define PARTED_MAP(groups, val, index, preaggr, incoerse, outcoerse, postaggr)                        \
     ({                                                                                                \
         i64_t $$i, $$j, $$l;                                                                          \
@@ -187,9 +159,11 @@ i64_t indexl_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
         $$res = __v_##outcoerse(groups);                                                              \
         for ($$i = 0, $$j = 0; $$i < $$l; $$i++) {                                                    \
             if ($$filter == NULL_OBJ || AS_LIST($$filter)[$$i] != NULL_OBJ) {                         \
+                aggr_parted_advise(val, $$filter, $$i);                                               \
                 $$parts = aggr_map(preaggr, AS_LIST(val)[$$i], AS_LIST(val)[$$i]->type, index);       \
                 $$v = AGGR_COLLECT($$parts, 1, incoerse, outcoerse, postaggr);                        \
                 drop_obj($$parts);                                                                    \
+                io_advise(AS_LIST(val)[$$i], MMAP_ADVICE_DONTNEED);                                   \
                 memcpy(__AS_##outcoerse($$res) + $$j++, __AS_##incoerse($$v), __SIZE_OF_##outcoerse); \
                 drop_obj($$v);                                                                        \
             }                                                                                         \
@@ -197,6 +171,186 @@ i64_t indexl_bin_i32_(i32_t val, i32_t vals[], i64_t offset, i64_t len) {
         $$res;                                                                                        \
     })
 
+nil_t destroy_partial_result(obj_p res) {
+    res->len = 0;
+    drop_obj(res);
+}
+
+#define AGGR_RADIX_PARTITION_GROUPS (1 << 16)  // Groups per partition: keeps partial tables cache sized
+
+typedef struct __aggr_radix_ctx_t {
+    obj_p index;
+    i64_t shift;        // log2 of groups per partition
+    i64_t partitions;
+    i64_t *counts;      // rows of this chunk per partition, then its write cursors
+    i64_t *gids;        // group id of each index position
+    i64_t *rows;        // out: row ids, grouped by partition
+    i64_t *ids;         // out: partition local group ids
+}* aggr_radix_ctx_p;
+
+obj_p aggr_radix_count(aggr_radix_ctx_p ctx, i64_t len, i64_t offset) {
+    i64_t i, l, shift, *gids, *counts, *group_ids, *source, *filter;
+
+    l = offset + len;
+    gids = ctx->gids;
+    counts = ctx->counts;
+    memset(counts, 0, ctx->partitions * sizeof(i64_t));
+
+    // shifted index keeps ids per key, so resolve them per row first
+    if (index_group_type(ctx->index) == INDEX_TYPE_SHIFT) {
+        group_ids = index_group_ids(ctx->index);
+        source = index_group_source(ctx->index);
+        filter = index_group_filter_ids(ctx->index);
+        shift = index_group_shift(ctx->index);
+
+        if (filter != NULL) {
+            for (i = offset; i < l; i++)
+                gids[i] = group_ids[source[filter[i]] - shift];
+        } else {
+            for (i = offset; i < l; i++)
+                gids[i] = group_ids[source[i] - shift];
+        }
+    }
+
+    shift = ctx->shift;
+    for (i = offset; i < l; i++)
+        counts[gids[i] >> shift]++;
+
+    return NULL_OBJ;
+}
+
+obj_p aggr_radix_scatter(aggr_radix_ctx_p ctx, i64_t len, i64_t offset) {
+    i64_t i, l, g, j, shift, mask, *gids, *counts, *filter, *rows, *ids;
+
+    l = offset + len;
+    shift = ctx->shift;
+    mask = (1ll << shift) - 1;
+    gids = ctx->gids;
+    counts = ctx->counts;
+    rows = ctx->rows;
+    ids = ctx->ids;
+    filter = index_group_filter_ids(ctx->index);
+
+    if (filter != NULL) {
+        for (i = offset; i < l; i++) {
+            g = gids[i];
+            j = counts[g >> shift]++;
+            rows[j] = filter[i];
+            ids[j] = g & mask;
+        }
+    } else {
+        for (i = offset; i < l; i++) {
+            g = gids[i];
+            j = counts[g >> shift]++;
+            rows[j] = i;
+            ids[j] = g & mask;
+        }
+    }
+
+    return NULL_OBJ;
+}
+
+// Too many groups for a full partial table per chunk: scatter rows by group id range (stable, so first/last still
+// see rows in order), then aggregate every range on its own and glue the results together
+static obj_p aggr_map_radix(raw_p aggr, obj_p val, i8_t outype, obj_p index, i64_t chunks) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, j, c, l, n, p, chunk, shift, range, size, group_count, group_len;
+    i64_t *counts, *starts;
+    obj_p gids, rows, ids, cnts, pindex, parts, res, v;
+
+    group_count = index_group_count(index);
+    group_len = index_group_len(index);
+
+    p = MAXI64(chunks, (group_count + AGGR_RADIX_PARTITION_GROUPS - 1) / AGGR_RADIX_PARTITION_GROUPS);
+    range = (group_count + p - 1) / p;
+    for (shift = 0; (1ll << shift) < range; shift++)
+        ;
+    range = 1ll << shift;
+    p = (group_count + range - 1) >> shift;
+
+    gids = (index_group_type(index) == INDEX_TYPE_SHIFT) ? I64(group_len) : NULL_OBJ;
+    rows = I64(group_len);
+    ids = I64(group_len);
+    cnts = I64(chunks * p + p + 1);
+    counts = AS_I64(cnts);
+    starts = counts + chunks * p;
+
+    struct __aggr_radix_ctx_t ctx[chunks];
+
+    for (c = 0; c < chunks; c++) {
+        ctx[c].index = index;
+        ctx[c].shift = shift;
+        ctx[c].partitions = p;
+        ctx[c].counts = counts + c * p;
+        ctx[c].gids = (gids != NULL_OBJ) ? AS_I64(gids) : index_group_ids(index);
+        ctx[c].rows = AS_I64(rows);
+        ctx[c].ids = AS_I64(ids);
+    }
+
+    chunk = group_len / chunks;
+
+    pool_prepare(pool);
+    for (c = 0; c < chunks - 1; c++)
+        pool_add_task(pool, (raw_p)aggr_radix_count, 3, &ctx[c], chunk, c * chunk);
+    pool_add_task(pool, (raw_p)aggr_radix_count, 3, &ctx[c], group_len - c * chunk, c * chunk);
+    drop_obj(pool_run(pool));
+
+    // turn per chunk counts into write cursors: partitions are laid out in order, chunks in order within each
+    for (i = 0, n = 0; i < p; i++) {
+        starts[i] = n;
+        for (c = 0; c < chunks; c++) {
+            l = counts[c * p + i];
+            counts[c * p + i] = n;
+            n += l;
+        }
+    }
+    starts[p] = n;
+
+    pool_prepare(pool);
+    for (c = 0; c < chunks - 1; c++)
+        pool_add_task(pool, (raw_p)aggr_radix_scatter, 3, &ctx[c], chunk, c * chunk);
+    pool_add_task(pool, (raw_p)aggr_radix_scatter, 3, &ctx[c], group_len - c * chunk, c * chunk);
+    drop_obj(pool_run(pool));
+
+    drop_obj(gids);
+
+    // every partition gets its own index, so partials can map local ids back to global ones
+    pindex = LIST(p);
+    for (i = 0; i < p; i++)
+        AS_LIST(pindex)[i] = index_group_from_ids(range, clone_obj(ids), clone_obj(rows), i * range);
+
+    drop_obj(ids);
+    drop_obj(rows);
+
+    pool_prepare(pool);
+    for (i = 0; i < p; i++)
+        pool_add_task(pool, aggr, 5, starts[i + 1] - starts[i], starts[i], val, AS_LIST(pindex)[i],
+                      vector(outype, range));
+    parts = pool_run(pool);
+
+    drop_obj(cnts);
+    drop_obj(pindex);
+
+    if (IS_ERR(parts))
+        return parts;
+
+    res = vector(outype, group_count);
+    size = size_of_type(res->type);
+
+    for (i = 0, j = 0; i < p; i++, j += range) {
+        v = AS_LIST(parts)[i];
+        l = MINI64(range, group_count - j);
+        memcpy(res->raw + j * size, v->raw, l * size);
+        // elements are moved into res now
+        destroy_partial_result(v);
+        AS_LIST(parts)[i] = NULL_OBJ;
+    }
+
+    drop_obj(parts);
+
+    return vn_list(1, res);
+}
+
 static obj_p aggr_map_other(raw_p aggr, obj_p val, i8_t outype, obj_p index) {
     pool_p pool = runtime_get()->pool;
     i64_t i, l, n, group_count, group_len, out_len, chunk;
@@ -207,6 +361,12 @@ static obj_p aggr_map_other(raw_p aggr, obj_p val, i8_t outype, obj_p index) {
     group_len = index_group_len(index);
     out_len = group_count;
 
+    if (group_count >= GROUP_SPLIT_THRESHOLD) {
+        n = pool_split_by(pool, group_len, 0);
+        if (n > 1)
+            return aggr_map_radix(aggr, val, outype, index, n);
+    }
+
     n = pool_split_by(pool, group_len, group_count);
 
     if (n == 1) {
@@ -323,11 +483,6 @@ static obj_p aggr_map(raw_p aggr, obj_p val, i8_t outype, obj_p index) {
     }
 }
 
-nil_t destroy_partial_result(obj_p res) {
-    res->len = 0;
-    drop_obj(res);
-}
-
 obj_p aggr_first_partial(raw_p arg1, raw_p arg2, raw_p arg3, raw_p arg4, raw_p arg5) {
     i64_t len = (i64_t)arg1, offset = (i64_t)arg2;
     obj_p val = (obj_p)arg3, index = (obj_p)arg4, res = (obj_p)arg5;
@@ -375,6 +530,29 @@ obj_p aggr_first_partial(raw_p arg1, raw_p arg2, raw_p arg3, raw_p arg4, raw_p a
     }
 }
 
+// String vectors aggregate their row ids, then gather the picked rows at once
+static obj_p aggr_strings_rows(obj_p val, obj_p index, obj_p (*aggr)(obj_p, obj_p)) {
+    i64_t i, l;
+    obj_p rows, res;
+
+    l = val->len;
+    rows = I64(l);
+    for (i = 0; i < l; i++)
+        AS_I64(rows)[i] = i;
+
+    res = aggr(rows, index);
+    drop_obj(rows);
+
+    if (IS_ERR(res))
+        return res;
+
+    rows = res;
+    res = strings_at_ids(val, AS_I64(rows), rows->len);
+    drop_obj(rows);
+
+    return res;
+}
+
 obj_p aggr_first(obj_p val, obj_p index) {
     i64_t i, j, n, l;
     i64_t *xo, *xe;
@@ -471,6 +649,8 @@ obj_p aggr_first(obj_p val, obj_p index) {
             res = AGGR_COLLECT(parts, n, list, list, if ($out[$y] == NULL_OBJ) $out[$y] = clone_obj($in[$x]));
             drop_obj(parts);
             return res;
+        case TYPE_STRINGS:
+            return aggr_strings_rows(val, index, aggr_first);
         // TODO: implement anymap
         // case TYPE_MAPLIST:
         //     res = AGGR_COLLECT(parts, n, list, list, if ($out[$y] == NULL_OBJ) $out[$y] = clone_obj($in[$x]));
@@ -630,6 +810,8 @@ obj_p aggr_last(obj_p val, obj_p index) {
             res = AGGR_COLLECT(parts, n, list, list, if ($out[$y] == NULL_OBJ) $out[$y] = clone_obj($in[$x]));
             drop_obj(parts);
             return res;
+        case TYPE_STRINGS:
+            return aggr_strings_rows(val, index, aggr_last);
         case TYPE_PARTEDLIST:
             res = LIST(n);
             for (i = 0; i < n; i++)
@@ -905,110 +1087,500 @@ obj_p aggr_avg(obj_p val, obj_p index) {
     }
 }
 
-obj_p aggr_med(obj_p val, obj_p index) {
-    obj_p res;
+// Counts non null values per group: med and dev skip nulls, like their vector versions
+obj_p aggr_valid_count_partial(raw_p arg1, raw_p arg2, raw_p arg3, raw_p arg4, raw_p arg5) {
+    i64_t len = (i64_t)arg1, offset = (i64_t)arg2;
+    obj_p val = (obj_p)arg3, index = (obj_p)arg4, res = (obj_p)arg5;
+
+    switch (val->type) {
+        case TYPE_I64:
+            AGGR_ITER(index, len, offset, val, res, i64, i64, $out[$y] = 0, $out[$y] += ($in[$x] != NULL_I64), );
+            return res;
+        case TYPE_F64:
+            AGGR_ITER(index, len, offset, val, res, f64, i64, $out[$y] = 0, $out[$y] += !ISNANF64($in[$x]), );
+            return res;
+        default:
+            destroy_partial_result(res);
+            return error(ERR_TYPE, "count partial: unsupported type: '%s'", type_name(val->type));
+    }
+}
+
+obj_p aggr_valid_sum_partial(raw_p arg1, raw_p arg2, raw_p arg3, raw_p arg4, raw_p arg5) {
+    i64_t len = (i64_t)arg1, offset = (i64_t)arg2;
+    obj_p val = (obj_p)arg3, index = (obj_p)arg4, res = (obj_p)arg5;
+
+    switch (val->type) {
+        case TYPE_I64:
+            AGGR_ITER(index, len, offset, val, res, i64, f64, $out[$y] = 0.0,
+                      if ($in[$x] != NULL_I64) $out[$y] += (f64_t)$in[$x], );
+            return res;
+        case TYPE_F64:
+            AGGR_ITER(index, len, offset, val, res, f64, f64, $out[$y] = 0.0,
+                      if (!ISNANF64($in[$x])) $out[$y] += $in[$x], );
+            return res;
+        default:
+            destroy_partial_result(res);
+            return error(ERR_TYPE, "sum partial: unsupported type: '%s'", type_name(val->type));
+    }
+}
+
+// Sum of squared deviations from the group means, val is (values; means)
+obj_p aggr_sqdev_partial(raw_p arg1, raw_p arg2, raw_p arg3, raw_p arg4, raw_p arg5) {
+    i64_t len = (i64_t)arg1, offset = (i64_t)arg2;
+    obj_p val = AS_LIST((obj_p)arg3)[0], index = (obj_p)arg4, res = (obj_p)arg5;
+    f64_t *means = AS_F64(AS_LIST((obj_p)arg3)[1]) + index_group_base(index);
+
+    switch (val->type) {
+        case TYPE_I64:
+            AGGR_ITER(index, len, offset, val, res, i64, f64, $out[$y] = 0.0,
+                      if ($in[$x] != NULL_I64) $out[$y] += ((f64_t)$in[$x] - means[$y]) * ((f64_t)$in[$x] - means[$y]), );
+            return res;
+        case TYPE_F64:
+            AGGR_ITER(index, len, offset, val, res, f64, f64, $out[$y] = 0.0,
+                      if (!ISNANF64($in[$x])) $out[$y] += ($in[$x] - means[$y]) * ($in[$x] - means[$y]), );
+            return res;
+        default:
+            destroy_partial_result(res);
+            return error(ERR_TYPE, "dev partial: unsupported type: '%s'", type_name(val->type));
+    }
+}
+
+// Population variance per group in two parallel passes: means first, then squared deviations from them.
+// Both passes merge plain sums, so no group ever materializes its values.
+static obj_p aggr_var(obj_p val, obj_p index) {
+    i64_t i, n, *cnt;
+    f64_t *sum, *out;
+    obj_p parts, cnts, sums, args, res;
+
+    n = index_group_count(index);
+
+    parts = aggr_map((raw_p)aggr_valid_count_partial, val, TYPE_I64, index);
+    if (IS_ERR(parts))
+        return parts;
+    cnts = AGGR_COLLECT(parts, n, i64, i64, $out[$y] += $in[$x]);
+    drop_obj(parts);
+
+    parts = aggr_map((raw_p)aggr_valid_sum_partial, val, TYPE_F64, index);
+    if (IS_ERR(parts)) {
+        drop_obj(cnts);
+        return parts;
+    }
+    sums = AGGR_COLLECT(parts, n, f64, f64, $out[$y] += $in[$x]);
+    drop_obj(parts);
+
+    cnt = AS_I64(cnts);
+    sum = AS_F64(sums);
+    for (i = 0; i < n; i++)
+        sum[i] = (cnt[i] == 0) ? 0.0 : sum[i] / (f64_t)cnt[i];
+
+    args = vn_list(2, clone_obj(val), sums);
+    parts = aggr_map((raw_p)aggr_sqdev_partial, args, TYPE_F64, index);
+    drop_obj(args);
+    if (IS_ERR(parts)) {
+        drop_obj(cnts);
+        return parts;
+    }
+    res = AGGR_COLLECT(parts, n, f64, f64, $out[$y] += $in[$x]);
+    drop_obj(parts);
+
+    out = AS_F64(res);
+    for (i = 0; i < n; i++)
+        out[i] = (cnt[i] == 0) ? NULL_F64 : out[i] / (f64_t)cnt[i];
+
+    drop_obj(cnts);
+
+    return res;
+}
+
+// Moves the K-th smallest of Vals[0..Len) to Vals[K], with no greater value before and no smaller one after it
+#define AGGR_SELECT(Type, Vals, Len, K)                             \
+    ({                                                              \
+        Type##_t *$v = (Vals), $p, $t;                              \
+        i64_t $l = 0, $r = (Len) - 1, $i, $j;                       \
+        while ($l < $r) {                                           \
+            $p = $v[$l + ($r - $l) / 2];                            \
+            $i = $l;                                                \
+            $j = $r;                                                \
+            while ($i <= $j) {                                      \
+                while ($v[$i] < $p)                                 \
+                    $i++;                                           \
+                while ($v[$j] > $p)                                 \
+                    $j--;                                           \
+                if ($i <= $j) {                                     \
+                    $t = $v[$i];                                    \
+                    $v[$i++] = $v[$j];                              \
+                    $v[$j--] = $t;                                  \
+                }                                                   \
+            }                                                       \
+            if ((K) <= $j)                                          \
+                $r = $j;                                            \
+            else if ((K) >= $i)                                     \
+                $l = $i;                                            \
+            else                                                    \
+                break;                                              \
+        }                                                           \
+    })
+
+// Interpolated Q-quantile of a group slice, selected in place
+#define AGGR_QUANTILE(Type, Vals, Len, Q)                           \
+    ({                                                              \
+        Type##_t *$q = (Vals), $hi;                                 \
+        i64_t $k, $m;                                               \
+        f64_t $pos, $res;                                           \
+        $pos = (Q) * (f64_t)((Len) - 1);                            \
+        $k = (i64_t)$pos;                                           \
+        AGGR_SELECT(Type, $q, Len, $k);                             \
+        $res = (f64_t)$q[$k];                                       \
+        if ($pos > (f64_t)$k) {                                     \
+            $hi = $q[$k + 1];                                       \
+            for ($m = $k + 2; $m < (Len); $m++)                     \
+                if ($q[$m] < $hi)                                   \
+                    $hi = $q[$m];                                   \
+            $res += ($pos - (f64_t)$k) * ((f64_t)$hi - $res);       \
+        }                                                           \
+        $res;                                                       \
+    })
+
+// Counts rows per group, whatever their values are
+obj_p aggr_group_count_partial(raw_p arg1, raw_p arg2, raw_p arg3, raw_p arg4, raw_p arg5) {
+    i64_t len = (i64_t)arg1, offset = (i64_t)arg2;
+    obj_p val = (obj_p)arg3, index = (obj_p)arg4, res = (obj_p)arg5;
+
+    AGGR_ITER(
+        index, len, offset, val, res, i64, i64, $out[$y] = 0,
+        {
+            UNUSED($in);
+            $out[$y]++;
+        }, );
+
+    return res;
+}
+
+// Runs a scatter over the row chunks aggr_map counted: cursors hold one vector of group write positions per chunk
+// (aggr_map chunks rows evenly whenever it returns partials per chunk), or a single one for the whole index
+static obj_p aggr_scatter(raw_p scatter, obj_p val, obj_p index, obj_p cursors, obj_p out, raw_p extra) {
+    pool_p pool = runtime_get()->pool;
+    i64_t c, n, len, chunk;
+    raw_p argv[7];
+
+    len = index_group_len(index);
+    n = cursors->len;
+
+    if (n == 1) {
+        argv[0] = (raw_p)len;
+        argv[1] = (raw_p)0;
+        argv[2] = val;
+        argv[3] = index;
+        argv[4] = AS_LIST(cursors)[0];
+        argv[5] = out;
+        argv[6] = extra;
+        return pool_call_task_fn(scatter, 7, argv);
+    }
+
+    chunk = len / n;
+    pool_prepare(pool);
+    for (c = 0; c < n - 1; c++)
+        pool_add_task(pool, scatter, 7, chunk, c * chunk, val, index, AS_LIST(cursors)[c], out, extra);
+    pool_add_task(pool, scatter, 7, len - c * chunk, c * chunk, val, index, AS_LIST(cursors)[c], out, extra);
+
+    return pool_run(pool);
+}
+
+// Copies the non null values of a chunk next to the rest of their group in buf
+obj_p aggr_valid_scatter_partial(i64_t len, i64_t offset, obj_p val, obj_p index, obj_p cursors, obj_p buf,
+                                 raw_p extra) {
+    UNUSED(extra);
 
-    // TODO: implement incremental median
-    val = aggr_collect(val, index);
-    res = ray_med(val);
-    drop_obj(val);
+    switch (val->type) {
+        case TYPE_I64:
+            AGGR_ITER(index, len, offset, val, cursors, i64, i64, ,
+                      if ($in[$x] != NULL_I64) AS_I64(buf)[$out[$y]++] = $in[$x], );
+            return NULL_OBJ;
+        case TYPE_F64:
+            AGGR_ITER(index, len, offset, val, cursors, f64, i64, ,
+                      if (!ISNANF64($in[$x])) AS_F64(buf)[$out[$y]++] = $in[$x], );
+            return NULL_OBJ;
+        default:
+            THROW(ERR_TYPE, "scatter: unsupported type: '%s'", type_name(val->type));
+    }
+}
+
+obj_p aggr_quantile_partial(i64_t len, i64_t offset, obj_p buf, i64_t starts[], f64_t *q, f64_t out[]) {
+    i64_t i, l;
+
+    for (i = offset; i < offset + len; i++) {
+        l = starts[i + 1] - starts[i];
+        if (l == 0)
+            out[i] = NULL_F64;
+        else if (buf->type == TYPE_I64)
+            out[i] = AGGR_QUANTILE(i64, AS_I64(buf) + starts[i], l, *q);
+        else
+            out[i] = AGGR_QUANTILE(f64, AS_F64(buf) + starts[i], l, *q);
+    }
+
+    return NULL_OBJ;
+}
+
+// Quantile per group without per group vectors: count, lay the groups out in one buffer, scatter the values
+// there and select inside every group slice
+static obj_p aggr_quantile(obj_p val, obj_p index, f64_t q) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, c, g, n, l, chunk, *cur, *starts;
+    obj_p parts, bounds, buf, res, v;
+
+    n = index_group_count(index);
+
+    // per chunk counts, unless the group table was built in one piece
+    parts = aggr_map((raw_p)aggr_valid_count_partial, val, TYPE_I64, index);
+    if (IS_ERR(parts))
+        return parts;
+
+    // turn the counts into write cursors: groups are laid out in order, chunks in order within each
+    bounds = I64(n + 1);
+    starts = AS_I64(bounds);
+    for (g = 0, l = 0; g < n; g++) {
+        starts[g] = l;
+        for (c = 0; c < parts->len; c++) {
+            cur = AS_I64(AS_LIST(parts)[c]);
+            i = cur[g];
+            cur[g] = l;
+            l += i;
+        }
+    }
+    starts[n] = l;
+
+    buf = vector(val->type, l);
+
+    v = aggr_scatter((raw_p)aggr_valid_scatter_partial, val, index, parts, buf, NULL);
+    drop_obj(parts);
+
+    if (IS_ERR(v)) {
+        drop_obj(bounds);
+        drop_obj(buf);
+        return v;
+    }
+
+    drop_obj(v);
+
+    res = F64(n);
+    c = MINI64(pool_split_by(pool, l, 0), n);
+
+    if (c <= 1) {
+        v = aggr_quantile_partial(n, 0, buf, starts, &q, AS_F64(res));
+    } else {
+        chunk = n / c;
+        pool_prepare(pool);
+        for (i = 0; i < c - 1; i++)
+            pool_add_task(pool, (raw_p)aggr_quantile_partial, 6, chunk, i * chunk, buf, starts, &q, AS_F64(res));
+        pool_add_task(pool, (raw_p)aggr_quantile_partial, 6, n - i * chunk, i * chunk, buf, starts, &q, AS_F64(res));
+        v = pool_run(pool);
+    }
+
+    drop_obj(v);
+    drop_obj(bounds);
+    drop_obj(buf);
 
     return res;
 }
 
+obj_p aggr_med(obj_p val, obj_p index) {
+    obj_p res;
+
+    switch (val->type) {
+        case TYPE_I64:
+        case TYPE_F64:
+            return aggr_quantile(val, index, 0.5);
+        default:
+            val = aggr_collect(val, index);
+            res = ray_med(val);
+            drop_obj(val);
+            return res;
+    }
+}
+
 obj_p aggr_dev(obj_p val, obj_p index) {
+    i64_t i, l;
     obj_p res;
 
-    // TODO: implement incremental stddev
-    val = aggr_collect(val, index);
-    res = ray_dev(val);
-    drop_obj(val);
+    switch (val->type) {
+        case TYPE_I64:
+        case TYPE_F64:
+            res = aggr_var(val, index);
+            if (IS_ERR(res))
+                return res;
+            l = res->len;
+            for (i = 0; i < l; i++)
+                AS_F64(res)[i] = sqrt(AS_F64(res)[i]);
+            return res;
+        default:
+            val = aggr_collect(val, index);
+            res = ray_dev(val);
+            drop_obj(val);
+            return res;
+    }
+}
 
-    return res;
+// Copies the values of a chunk into their group vectors, syms resolves enums
+obj_p aggr_collect_scatter_partial(i64_t len, i64_t offset, obj_p val, obj_p index, obj_p cursors, obj_p res,
+                                   i64_t syms[]) {
+    obj_p *groups = AS_LIST(res);
+
+    switch (val->type) {
+        case TYPE_B8:
+        case TYPE_U8:
+            AGGR_ITER(index, len, offset, val, cursors, u8, i64, , AS_U8(groups[$y])[$out[$y]++] = $in[$x], );
+            return NULL_OBJ;
+        case TYPE_I16:
+            AGGR_ITER(index, len, offset, val, cursors, i16, i64, , AS_I16(groups[$y])[$out[$y]++] = $in[$x], );
+            return NULL_OBJ;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            AGGR_ITER(index, len, offset, val, cursors, i32, i64, , AS_I32(groups[$y])[$out[$y]++] = $in[$x], );
+            return NULL_OBJ;
+        case TYPE_I64:
+        case TYPE_SYMBOL:
+        case TYPE_TIMESTAMP:
+            AGGR_ITER(index, len, offset, val, cursors, i64, i64, , AS_I64(groups[$y])[$out[$y]++] = $in[$x], );
+            return NULL_OBJ;
+        case TYPE_F64:
+            AGGR_ITER(index, len, offset, val, cursors, f64, i64, , AS_F64(groups[$y])[$out[$y]++] = $in[$x], );
+            return NULL_OBJ;
+        case TYPE_ENUM:
+            AGGR_ITER(index, len, offset, val, cursors, i64, i64, ,
+                      AS_I64(groups[$y])[$out[$y]++] = syms[$in[$x]], );
+            return NULL_OBJ;
+        case TYPE_GUID:
+            AGGR_ITER(index, len, offset, val, cursors, guid, i64, ,
+                      memcpy(AS_GUID(groups[$y])[$out[$y]++], $in[$x], sizeof(guid_t)), );
+            return NULL_OBJ;
+        case TYPE_LIST:
+            AGGR_ITER(index, len, offset, val, cursors, list, i64, ,
+                      AS_LIST(groups[$y])[$out[$y]++] = clone_obj($in[$x]), );
+            return NULL_OBJ;
+        default:
+            THROW(ERR_TYPE, "collect: unsupported type: '%s", type_name(val->type));
+    }
 }
 
-obj_p aggr_collect(obj_p val, obj_p index) {
-    i64_t i, l, n;
-    obj_p k, v, res;
+obj_p aggr_row_scatter_partial(i64_t len, i64_t offset, obj_p val, obj_p index, obj_p cursors, obj_p res,
+                               raw_p extra) {
+    obj_p *groups = AS_LIST(res);
+
+    UNUSED(extra);
+    AGGR_ITER(
+        index, len, offset, val, cursors, i64, i64, ,
+        {
+            UNUSED($in);
+            AS_I64(groups[$y])[$out[$y]++] = $x;
+        }, );
+
+    return NULL_OBJ;
+}
+
+// Counts the rows of every group per chunk, allocates each group at its final size and turns the counts into
+// the chunks' write positions inside the groups: a scatter then fills them without ever growing a vector
+static obj_p aggr_group_layout(obj_p val, obj_p index, i8_t type, obj_p *cursors) {
+    i64_t c, g, l, n, k, *cur;
+    obj_p parts, res;
 
-    l = index_group_len(index);
     n = index_group_count(index);
+    parts = aggr_map((raw_p)aggr_group_count_partial, val, TYPE_I64, index);
+    if (IS_ERR(parts))
+        return parts;
 
     res = LIST(n);
-    for (i = 0; i < n; i++)
-        AS_LIST(res)[i] = vector(val->type, 0);
+    for (g = 0; g < n; g++) {
+        for (c = 0, l = 0; c < parts->len; c++) {
+            cur = AS_I64(AS_LIST(parts)[c]);
+            k = cur[g];
+            cur[g] = l;
+            l += k;
+        }
+        AS_LIST(res)[g] = vector(type, l);
+    }
+
+    *cursors = parts;
+
+    return res;
+}
+
+obj_p aggr_collect(obj_p val, obj_p index) {
+    obj_p k, v, syms, cursors, res;
 
     switch (val->type) {
         case TYPE_B8:
-            AGGR_ITER(index, l, 0, val, res, b8, list, , push_raw($out + $y, $in + $x), );
-            return res;
         case TYPE_U8:
-            AGGR_ITER(index, l, 0, val, res, u8, list, , push_raw($out + $y, $in + $x), );
-            return res;
         case TYPE_I16:
-            AGGR_ITER(index, l, 0, val, res, i16, list, , push_raw($out + $y, $in + $x), );
-            return res;
         case TYPE_I32:
         case TYPE_DATE:
         case TYPE_TIME:
-            AGGR_ITER(index, l, 0, val, res, i32, list, , push_raw($out + $y, $in + $x), );
-            return res;
         case TYPE_I64:
         case TYPE_SYMBOL:
         case TYPE_TIMESTAMP:
-            AGGR_ITER(index, l, 0, val, res, i64, list, , push_raw($out + $y, $in + $x), );
-            return res;
         case TYPE_F64:
-            AGGR_ITER(index, l, 0, val, res, f64, list, , push_raw($out + $y, $in + $x), );
-            return res;
+        case TYPE_GUID:
+        case TYPE_LIST:
+            syms = NULL_OBJ;
+            break;
         case TYPE_ENUM:
             k = ray_key(val);
             if (IS_ERR(k))
                 return k;
 
-            v = ray_get(k);
+            syms = ray_get(k);
             drop_obj(k);
 
-            if (IS_ERR(v))
-                return v;
+            if (IS_ERR(syms))
+                return syms;
 
-            if (v->type != TYPE_SYMBOL) {
-                drop_obj(v);
-                drop_obj(res);
-                return error(ERR_TYPE, "enum: '%s' is not a 'Symbol'", type_name(v->type));
+            if (syms->type != TYPE_SYMBOL) {
+                v = error(ERR_TYPE, "enum: '%s' is not a 'Symbol'", type_name(syms->type));
+                drop_obj(syms);
+                return v;
             }
-
-            AGGR_ITER(index, l, 0, val, res, i64, list, , push_raw($out + $y, AS_SYMBOL(v) + $in[$x]), );
-            drop_obj(v);
-            return res;
-        case TYPE_GUID:
-            AGGR_ITER(index, l, 0, val, res, guid, list, , push_raw($out + $y, $in + $x), );
-            return res;
-        case TYPE_LIST:
-            AGGR_ITER(index, l, 0, val, res, list, list, , push_obj($out + $y, clone_obj($in[$x])), );
-            return res;
+            break;
         default:
-            drop_obj(res);
             THROW(ERR_TYPE, "collect: unsupported type: '%s", type_name(val->type));
     }
+
+    res = aggr_group_layout(val, index, val->type, &cursors);
+    if (IS_ERR(res)) {
+        drop_obj(syms);
+        return res;
+    }
+
+    v = aggr_scatter((raw_p)aggr_collect_scatter_partial, val, index, cursors, res,
+                     (syms != NULL_OBJ) ? (raw_p)AS_SYMBOL(syms) : NULL);
+    drop_obj(cursors);
+    drop_obj(syms);
+
+    if (IS_ERR(v)) {
+        drop_obj(res);
+        return v;
+    }
+
+    drop_obj(v);
+
+    return res;
 }
 
 obj_p aggr_row(obj_p val, obj_p index) {
-    i64_t i, l, n;
-    obj_p res;
+    obj_p v, cursors, res;
 
-    l = index_group_len(index);
-    n = index_group_count(index);
+    res = aggr_group_layout(val, index, TYPE_I64, &cursors);
+    if (IS_ERR(res))
+        return res;
 
-    res = LIST(n);
-    for (i = 0; i < n; i++)
-        AS_LIST(res)[i] = I64(0);
+    v = aggr_scatter((raw_p)aggr_row_scatter_partial, val, index, cursors, res, NULL);
+    drop_obj(cursors);
 
-    AGGR_ITER(
-        index, l, 0, val, res, i64, list, , {
-            UNUSED($in);
-            push_raw($out + $y, &$x);
-        }, );
+    if (IS_ERR(v)) {
+        drop_obj(res);
+        return v;
+    }
+
+    drop_obj(v);
 
     return res;
 }
@@ -32,6 +32,7 @@
 #include "string.h"
 #include "io.h"
 #include "iter.h"
+#include "compress.h"
 
 obj_p binary_call(obj_p f, obj_p x, obj_p y) {
     binary_f fn;
@@ -56,10 +57,11 @@ obj_p binary_set(obj_p x, obj_p y) {
     u8_t *b, mmod;
     obj_p res, col, s, p, k, v, e, path, buf;
     c8_t objbuf[RAY_PAGE_SIZE] = {0};
+    ipc_header_t header;
 
     switch (x->type) {
         case -TYPE_SYMBOL:
-            res = set_obj(&runtime_get()->env.variables, x, clone_obj(y));
+            res = env_set(&runtime_get()->env, x, clone_obj(y));
 
             if (y && y->type == TYPE_LAMBDA) {
                 if (is_null(AS_LAMBDA(y)->name))
@@ -147,6 +149,7 @@ obj_p binary_set(obj_p x, obj_p y) {
                     }
 
                     p->type = TYPE_ENUM;
+                    p->attrs = y->attrs;
                     p->len = AS_LIST(y)[1]->len;
 
                     c = fs_fwrite(fd, objbuf, sizeof(struct obj_t));
@@ -262,7 +265,7 @@ obj_p binary_set(obj_p x, obj_p y) {
                     return clone_obj(x);
 
                 default:
-                    if (IS_VECTOR(y)) {
+                    if (IS_VECTOR(y) || y->type == TYPE_STRINGS) {
                         path = cstring_from_obj(x);
                         fd = fs_fopen(AS_C8(path), ATTR_WRONLY | ATTR_CREAT);
 
@@ -274,6 +277,41 @@ obj_p binary_set(obj_p x, obj_p y) {
 
                         size = size_of(y);
 
+                        // compressed columns are stored as a serialized header followed by a frame
+                        if (compress_columns() && y->type != TYPE_STRINGS && y->type != TYPE_LIST &&
+                            size >= COMPRESS_MIN_SIZE) {
+                            buf = compress_vector(y);
+                            if (IS_ERR(buf)) {
+                                drop_obj(path);
+                                fs_fclose(fd);
+                                return buf;
+                            }
+
+                            header.prefix = SERDE_PREFIX;
+                            header.version = RAYFORCE_VERSION;
+                            header.flags = SERDE_FLAG_COMPRESSED;
+                            header.endian = 0;
+                            header.msgtype = 0;
+                            header.size = buf->len;
+
+                            c = fs_fwrite(fd, (str_p)&header, sizeof(ipc_header_t));
+                            if (c != -1)
+                                c = fs_fwrite(fd, (str_p)AS_U8(buf), buf->len);
+                            drop_obj(buf);
+
+                            if (c == -1) {
+                                e = sys_error(ERROR_TYPE_SYS, AS_C8(path));
+                                drop_obj(path);
+                                fs_fclose(fd);
+                                return e;
+                            }
+
+                            drop_obj(path);
+                            fs_fclose(fd);
+
+                            return clone_obj(x);
+                        }
+
                         c = fs_fwrite(fd, (str_p)y, size);
 
                         if (c == -1) {
@@ -29,6 +29,8 @@
 #include "items.h"
 #include "runtime.h"
 #include "pool.h"
+#include "zone.h"
+#include "grouped.h"
 
 typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
 
@@ -67,6 +69,19 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
         NULL_OBJ;                                                          \
     })
 
+// Rows of a string vector against a string or the rows of another one, lhs and rhs are given by the row $i
+#define __CMP_S(lhs, lhs_len, rhs, rhs_len, op, ln, of, ov) \
+    ({                                                     \
+        b8_t *$out;                                        \
+        $out = AS_B8(ov);                                  \
+        for (i64_t $i = of; $i < of + ln; $i++)            \
+            $out[$i] = op(lhs, lhs_len, rhs, rhs_len);     \
+        NULL_OBJ;                                          \
+    })
+
+#define __S_AT(x) STRINGS_DATA(x) + STRINGS_OFFS(x)[$i]
+#define __S_LEN(x) (STRINGS_OFFS(x)[$i + 1] - STRINGS_OFFS(x)[$i])
+
 #define __DECLARE_CMP_FN(op)                                                                                \
     obj_p ray_##op##_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p res) {                        \
         i64_t i;                                                                                            \
@@ -91,6 +106,16 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
                 return b8(op##STR(AS_C8(x), x->len, (lit_p)(&y->c8), 1));                                   \
             case MTYPE2(TYPE_C8, TYPE_C8):                                                                  \
                 return b8(op##STR(AS_C8(x), x->len, AS_C8(y), y->len));                                     \
+            case MTYPE2(TYPE_STRINGS, TYPE_C8):                                                             \
+                return __CMP_S(__S_AT(x), __S_LEN(x), AS_C8(y), y->len, op##STR, len, offset, res);         \
+            case MTYPE2(TYPE_STRINGS, -TYPE_C8):                                                            \
+                return __CMP_S(__S_AT(x), __S_LEN(x), (lit_p)(&y->c8), 1, op##STR, len, offset, res);       \
+            case MTYPE2(TYPE_C8, TYPE_STRINGS):                                                             \
+                return __CMP_S(AS_C8(x), x->len, __S_AT(y), __S_LEN(y), op##STR, len, offset, res);         \
+            case MTYPE2(-TYPE_C8, TYPE_STRINGS):                                                            \
+                return __CMP_S((lit_p)(&x->c8), 1, __S_AT(y), __S_LEN(y), op##STR, len, offset, res);       \
+            case MTYPE2(TYPE_STRINGS, TYPE_STRINGS):                                                        \
+                return __CMP_S(__S_AT(x), __S_LEN(x), __S_AT(y), __S_LEN(y), op##STR, len, offset, res);    \
                                                                                                             \
             case MTYPE2(-TYPE_I16, -TYPE_I16):                                                              \
                 return b8(op##I16(x->i16, y->i16));                                                         \
@@ -278,7 +303,7 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
                     out[i] = xi[ei[i]] == si;                                                               \
                                                                                                             \
                 drop_obj(sym);                                                                              \
-                return res;                                                                                 \
+                return NULL_OBJ;                                                                            \
             case MTYPE2(-TYPE_SYMBOL, TYPE_ENUM):                                                           \
                 return ray_##op##_partial(y, x, len, offset, res);                                          \
             case MTYPE2(TYPE_ENUM, TYPE_SYMBOL):                                                            \
@@ -302,7 +327,7 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
                     out[i] = xi[i] == ei[si];                                                               \
                                                                                                             \
                 drop_obj(sym);                                                                              \
-                return res;                                                                                 \
+                return NULL_OBJ;                                                                            \
             case MTYPE2(TYPE_SYMBOL, TYPE_ENUM):                                                            \
                 return ray_##op##_partial(y, x, len, offset, res);                                          \
                                                                                                             \
@@ -312,17 +337,17 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
                 out = AS_B8(res) + offset;                                                                  \
                 for (i = 0; i < len; i++)                                                                   \
                     out[i] = op##GUID(AS_GUID(x)[0], AS_GUID(y)[i]);                                        \
-                return res;                                                                                 \
+                return NULL_OBJ;                                                                            \
             case MTYPE2(TYPE_GUID, -TYPE_GUID):                                                             \
                 out = AS_B8(res) + offset;                                                                  \
                 for (i = 0; i < len; i++)                                                                   \
                     out[i] = op##GUID(AS_GUID(x)[i], AS_GUID(y)[0]);                                        \
-                return res;                                                                                 \
+                return NULL_OBJ;                                                                            \
             case MTYPE2(TYPE_GUID, TYPE_GUID):                                                              \
                 out = AS_B8(res) + offset;                                                                  \
                 for (i = 0; i < len; i++)                                                                   \
                     out[i] = op##GUID(AS_GUID(x)[i], AS_GUID(y)[i]);                                        \
-                return res;                                                                                 \
+                return NULL_OBJ;                                                                            \
             case MTYPE2(TYPE_ERR, TYPE_ERR):                                                                \
                 return b8(cmp_obj(x, y) == 0);                                                              \
             case MTYPE2(TYPE_NULL, TYPE_NULL):                                                              \
@@ -332,10 +357,180 @@ typedef obj_p (*ray_cmp_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
         }                                                                                                   \
     }
 
-obj_p cmp_map(raw_p op, obj_p x, obj_p y) {
+// First row of an ascending vector where x[i] < y (x[i] <= y if upper) no longer holds, -1 if they do not compare
+static i64_t cmp_bound(obj_p x, obj_p y, b8_t upper) {
+    i64_t lo, hi, mid;
+    b8_t hit;
+    obj_p v, r;
+
+    lo = 0;
+    hi = x->len;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        v = at_idx(x, mid);
+        r = upper ? ray_le(v, y) : ray_lt(v, y);
+        drop_obj(v);
+
+        if (r->type != -TYPE_B8) {
+            drop_obj(r);
+            return -1;
+        }
+
+        hit = r->b8;
+        drop_obj(r);
+
+        if (hit)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/*
+ * Rows [from, to) of an ascending vector where (op x y) holds for an atom y, found with binary searches instead of
+ * a comparison pass. Returns B8_FALSE if x is not known to be sorted or the rows do not form a single range.
+ */
+b8_t cmp_range(obj_p x, obj_p y, zone_op_t op, i64_t *from, i64_t *to) {
+    i64_t lo = 0, hi;
+
+    if (!(x->attrs & ATTR_ASC) || y->type >= 0 || op == ZONE_OP_NE)
+        return B8_FALSE;
+
+    // symbols are sorted by their names but compared by their ids
+    switch (x->type) {
+        case TYPE_I16:
+        case TYPE_I32:
+        case TYPE_I64:
+        case TYPE_DATE:
+        case TYPE_TIME:
+        case TYPE_TIMESTAMP:
+        case TYPE_F64:
+            break;
+        default:
+            return B8_FALSE;
+    }
+
+    hi = x->len;
+
+    if (op == ZONE_OP_EQ || op == ZONE_OP_LT || op == ZONE_OP_GE) {
+        lo = cmp_bound(x, y, B8_FALSE);
+        if (lo == -1)
+            return B8_FALSE;
+    }
+
+    if (op == ZONE_OP_EQ || op == ZONE_OP_LE || op == ZONE_OP_GT) {
+        hi = cmp_bound(x, y, B8_TRUE);
+        if (hi == -1)
+            return B8_FALSE;
+    }
+
+    switch (op) {
+        case ZONE_OP_LT:
+            *from = 0;
+            *to = lo;
+            break;
+        case ZONE_OP_LE:
+            *from = 0;
+            *to = hi;
+            break;
+        case ZONE_OP_GT:
+            *from = hi;
+            *to = x->len;
+            break;
+        case ZONE_OP_GE:
+            *from = lo;
+            *to = x->len;
+            break;
+        default:
+            *from = lo;
+            *to = hi;
+            break;
+    }
+
+    return B8_TRUE;
+}
+
+/*
+ * Compare a mapped column having a zone map against an atom: blocks whose outcome is known from their
+ * min and max are filled right away and only the remaining ones get scanned.
+ */
+static obj_p cmp_zone(raw_p op, zone_op_t zop, obj_p x, obj_p y, obj_p zone, obj_p res) {
+    pool_p pool = runtime_get()->pool;
+    i64_t i, l, n, m, len;
+    obj_p val, hits, v;
+    ray_cmp_f cmp_fn = (ray_cmp_f)op;
+
+    // atom on the left: look at the column from its side
+    if (IS_VECTOR(x))
+        val = y;
+    else {
+        val = x;
+        zop = zone_flip(zop);
+    }
+
+    l = res->len;
+    n = ops_count(zone);
+    hits = U8(n);
+
+    for (i = 0, m = 0; i < n; i++) {
+        AS_U8(hits)[i] = zone_cmp(zone, i, zop, val);
+        len = (i + 1 < n) ? ZONE_BLOCK : l - i * ZONE_BLOCK;
+        switch (AS_U8(hits)[i]) {
+            case ZONE_NONE:
+                memset(AS_B8(res) + i * ZONE_BLOCK, B8_FALSE, len);
+                break;
+            case ZONE_ALL:
+                memset(AS_B8(res) + i * ZONE_BLOCK, B8_TRUE, len);
+                break;
+            default:
+                m++;
+                break;
+        }
+    }
+
+    // blocks are page aligned in the result, so they can be scanned by different executors
+    if (m > 1 && pool_split_by(pool, l, 0) > 1) {
+        pool_prepare(pool);
+        for (i = 0; i < n; i++) {
+            if (AS_U8(hits)[i] != ZONE_SOME)
+                continue;
+            len = (i + 1 < n) ? ZONE_BLOCK : l - i * ZONE_BLOCK;
+            pool_add_task(pool, op, 5, x, y, len, i * ZONE_BLOCK, res);
+        }
+
+        drop_obj(hits);
+        v = pool_run(pool);
+        if (IS_ERR(v))
+            return v;
+
+        drop_obj(v);
+        return NULL_OBJ;
+    }
+
+    for (i = 0; i < n; i++) {
+        if (AS_U8(hits)[i] != ZONE_SOME)
+            continue;
+        len = (i + 1 < n) ? ZONE_BLOCK : l - i * ZONE_BLOCK;
+        v = cmp_fn(x, y, len, i * ZONE_BLOCK, res);
+        if (IS_ERR(v)) {
+            drop_obj(hits);
+            return v;
+        }
+    }
+
+    drop_obj(hits);
+
+    return NULL_OBJ;
+}
+
+obj_p cmp_map(raw_p op, zone_op_t zop, obj_p x, obj_p y) {
     pool_p pool = runtime_get()->pool;
-    i64_t i, l, n;
-    obj_p v, map, res;
+    i64_t i, l, n, from, to;
+    zone_op_t sop;
+    obj_p v, map, res, zone;
     ray_cmp_f cmp_fn = (ray_cmp_f)op;
 
     if (x->type == TYPE_MAPCOMMON) {
@@ -386,7 +581,13 @@ obj_p cmp_map(raw_p op, obj_p x, obj_p y) {
             return b8(cmp_obj(x, y) == 0);
     }
 
-    if (IS_VECTOR(x) && IS_VECTOR(y)) {
+    if (x->type == TYPE_STRINGS || y->type == TYPE_STRINGS) {
+        // a string vector compares by rows, the strings it is compared with are single values
+        if (x->type == TYPE_STRINGS && y->type == TYPE_STRINGS && x->len != y->len)
+            THROW(ERR_LENGTH, "vectors must have the same length");
+
+        l = (x->type == TYPE_STRINGS) ? x->len : y->len;
+    } else if (IS_VECTOR(x) && IS_VECTOR(y)) {
         if (x->len != y->len)
             THROW(ERR_LENGTH, "vectors must have the same length");
 
@@ -403,6 +604,34 @@ obj_p cmp_map(raw_p op, obj_p x, obj_p y) {
     if (l == 0)
         return res;
 
+    if ((IS_VECTOR(x) && y->type < 0) || (x->type < 0 && IS_VECTOR(y))) {
+        // sorted values: the rows matching are a single range, or all but one for !=
+        sop = IS_VECTOR(x) ? zop : zone_flip(zop);
+        if (IS_VECTOR(x) ? cmp_range(x, y, (sop == ZONE_OP_NE) ? ZONE_OP_EQ : sop, &from, &to)
+                         : cmp_range(y, x, (sop == ZONE_OP_NE) ? ZONE_OP_EQ : sop, &from, &to)) {
+            memset(AS_B8(res), sop == ZONE_OP_NE, l);
+            memset(AS_B8(res) + from, sop != ZONE_OP_NE, to - from);
+            return res;
+        }
+
+        // grouped values: the rows holding the one looked for are known
+        if ((sop == ZONE_OP_EQ || sop == ZONE_OP_NE) &&
+            (IS_VECTOR(x) ? grouped_mask(x, y, sop == ZONE_OP_EQ, res) : grouped_mask(y, x, sop == ZONE_OP_EQ, res)))
+            return res;
+
+        zone = IS_VECTOR(x) ? zone_get(x) : zone_get(y);
+        if (zone != NULL_OBJ) {
+            v = cmp_zone(op, zop, x, y, zone, res);
+            drop_obj(zone);
+            if (IS_ERR(v)) {
+                drop_obj(res);
+                return v;
+            }
+
+            return res;
+        }
+    }
+
     n = pool_split_by(pool, l, 0);
 
     if (n == 1) {
@@ -456,9 +685,9 @@ __DECLARE_CMP_FN(GT)
 __DECLARE_CMP_FN(LE)
 __DECLARE_CMP_FN(GE)
 
-obj_p ray_eq(obj_p x, obj_p y) { return cmp_map(ray_EQ_partial, x, y); }
-obj_p ray_ne(obj_p x, obj_p y) { return cmp_map(ray_NE_partial, x, y); }
-obj_p ray_lt(obj_p x, obj_p y) { return cmp_map(ray_LT_partial, x, y); }
-obj_p ray_gt(obj_p x, obj_p y) { return cmp_map(ray_GT_partial, x, y); }
-obj_p ray_le(obj_p x, obj_p y) { return cmp_map(ray_LE_partial, x, y); }
-obj_p ray_ge(obj_p x, obj_p y) { return cmp_map(ray_GE_partial, x, y); }
+obj_p ray_eq(obj_p x, obj_p y) { return cmp_map(ray_EQ_partial, ZONE_OP_EQ, x, y); }
+obj_p ray_ne(obj_p x, obj_p y) { return cmp_map(ray_NE_partial, ZONE_OP_NE, x, y); }
+obj_p ray_lt(obj_p x, obj_p y) { return cmp_map(ray_LT_partial, ZONE_OP_LT, x, y); }
+obj_p ray_gt(obj_p x, obj_p y) { return cmp_map(ray_GT_partial, ZONE_OP_GT, x, y); }
+obj_p ray_le(obj_p x, obj_p y) { return cmp_map(ray_LE_partial, ZONE_OP_LE, x, y); }
+obj_p ray_ge(obj_p x, obj_p y) { return cmp_map(ray_GE_partial, ZONE_OP_GE, x, y); }
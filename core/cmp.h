@@ -25,6 +25,7 @@
 #define CMP_H
 
 #include "rayforce.h"
+#include "zone.h"
 
 obj_p ray_eq(obj_p x, obj_p y);
 obj_p ray_ne(obj_p x, obj_p y);
@@ -32,5 +33,14 @@ obj_p ray_lt(obj_p x, obj_p y);
 obj_p ray_gt(obj_p x, obj_p y);
 obj_p ray_le(obj_p x, obj_p y);
 obj_p ray_ge(obj_p x, obj_p y);
+b8_t cmp_range(obj_p x, obj_p y, zone_op_t op, i64_t *from, i64_t *to);
+
+// Comparisons of the rows [offset, offset + len) of their operands, into res
+obj_p ray_EQ_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p res);
+obj_p ray_NE_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p res);
+obj_p ray_LT_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p res);
+obj_p ray_GT_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p res);
+obj_p ray_LE_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p res);
+obj_p ray_GE_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p res);
 
 #endif  // CMP_H
@@ -247,6 +247,7 @@ obj_p ray_table(obj_p x, obj_p y) {
             case TYPE_SYMBOL:
             case TYPE_LIST:
             case TYPE_GUID:
+            case TYPE_STRINGS:
                 j = AS_LIST(y)[i]->len;
                 if (cl != 0 && j != cl)
                     return error(ERR_LENGTH, "table: values must be of the same length");
@@ -828,6 +829,8 @@ obj_p ray_distinct(obj_p x) {
             l = x->len;
             res = index_distinct_guid(AS_GUID(x), l);
             return res;
+        case TYPE_STRINGS:
+            return index_distinct_strings(x);
         default:
             THROW(ERR_TYPE, "distinct: invalid type: '%s", type_name(x->type));
     }
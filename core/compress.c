@@ -0,0 +1,670 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+
+#include "compress.h"
+#include "error.h"
+#include "ops.h"
+#include "pool.h"
+#include "runtime.h"
+#include "serde.h"
+
+/*
+ * Block compression of serialized payloads and of the columns of splayed tables.
+ *
+ * A frame is a header, the end offset of every compressed block and the blocks themselves. The data is cut into
+ * blocks of COMPRESS_BLOCK_SIZE bytes, each compressed on its own with an LZ77 scheme close to LZ4: a sequence is a
+ * token holding the number of literals and the match length in its nibbles, the literals, a 2 byte offset back into
+ * the block and the rest of the lengths that did not fit the token. Blocks do not refer to each other, so they are
+ * compressed and decompressed in parallel. A block that does not shrink is stored as it is.
+ *
+ * Values of a vector go through a filter first, turning them into small numbers or runs of zero bytes the LZ stage
+ * then packs well: neighbour differences for sorted integers, differences of differences for timestamps, xor with
+ * the previous value for floats and offsets from the minimum packed into a few bits for other integers.
+ */
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 14
+#define LZ_MAX_OFFSET 65535
+#define LZ_TAIL 8  // last bytes of a block always go as literals
+
+typedef struct compress_frame_t {
+    u8_t codec;    // filter applied to the values before compressing them
+    u8_t width;    // size of a value the filter works on
+    i8_t type;     // type of the vector, 0 when the frame holds a serialized object
+    u8_t attrs;    // attributes of the vector
+    u32_t blocks;  // number of blocks
+    i64_t len;     // size of the data once decompressed and decoded (in bytes)
+    i64_t size;    // size of the data the blocks decompress to (in bytes)
+} compress_frame_t;
+
+RAYASSERT(sizeof(compress_frame_t) == 24, compress_frame_t)
+
+typedef struct compress_ctx_t {
+    u8_t *src;     // data to compress or compressed blocks
+    u8_t *dst;     // compressed blocks or decompressed data
+    i64_t *offs;   // size of every compressed block, or their end offsets when decompressing
+    i64_t size;    // size of the uncompressed data (in bytes)
+    i64_t stride;  // room left for every block while compressing
+    b8_t failed;   // a block did not decompress to its size
+} compress_ctx_t;
+
+typedef obj_p (*compress_partial_f)(compress_ctx_t *, i64_t, i64_t);
+
+static b8_t COMPRESS_COLUMNS = B8_FALSE;
+
+b8_t compress_columns(nil_t) { return COMPRESS_COLUMNS; }
+
+i64_t compress_set_columns(i64_t x) {
+    COMPRESS_COLUMNS = (x != 0);
+    return 0;
+}
+
+// ============================================================================
+// LZ blocks
+// ============================================================================
+
+static i64_t lz_bound(i64_t len) { return len + len / 255 + 16; }
+
+static u8_t *lz_put_len(u8_t *op, i64_t n) {
+    while (n >= 255) {
+        *op++ = 255;
+        n -= 255;
+    }
+
+    *op++ = (u8_t)n;
+
+    return op;
+}
+
+static u8_t *lz_put_literals(u8_t *op, u8_t *lit, i64_t len) {
+    *op = (u8_t)((len < 15 ? len : 15) << 4);
+    op = (len >= 15) ? lz_put_len(op + 1, len - 15) : op + 1;
+    memcpy(op, lit, len);
+
+    return op + len;
+}
+
+static i64_t lz_compress(u8_t *src, i64_t len, u8_t *dst, i32_t *tab) {
+    i64_t ip, anchor, ref, ml, limit;
+    u32_t seq, h;
+    u8_t *op, *tok;
+
+    memset(tab, 0xff, sizeof(i32_t) << LZ_HASH_BITS);
+
+    op = dst;
+    ip = 0;
+    anchor = 0;
+    limit = len - LZ_TAIL;
+
+    while (ip + LZ_MIN_MATCH <= limit) {
+        memcpy(&seq, src + ip, sizeof(u32_t));
+        h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+        ref = tab[h];
+        tab[h] = (i32_t)ip;
+
+        // the longer nothing matches the faster we skip, so that incompressible data costs little
+        if (ref < 0 || ip - ref > LZ_MAX_OFFSET || memcmp(src + ref, src + ip, LZ_MIN_MATCH) != 0) {
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        ml = LZ_MIN_MATCH;
+        while (ip + ml < limit && src[ref + ml] == src[ip + ml])
+            ml++;
+
+        tok = op;
+        op = lz_put_literals(op, src + anchor, ip - anchor);
+        *op++ = (u8_t)(ip - ref);
+        *op++ = (u8_t)((ip - ref) >> 8);
+        ml -= LZ_MIN_MATCH;
+        *tok |= (u8_t)(ml < 15 ? ml : 15);
+        if (ml >= 15)
+            op = lz_put_len(op, ml - 15);
+
+        ip += ml + LZ_MIN_MATCH;
+        anchor = ip;
+    }
+
+    op = lz_put_literals(op, src + anchor, len - anchor);
+
+    return op - dst;
+}
+
+static i64_t lz_decompress(u8_t *src, i64_t len, u8_t *dst, i64_t cap) {
+    i64_t i, lit, ml, off;
+    u8_t tok, b, *ip, *iend, *op, *oend, *ref;
+
+    ip = src;
+    iend = src + len;
+    op = dst;
+    oend = dst + cap;
+
+    while (ip < iend) {
+        tok = *ip++;
+
+        lit = tok >> 4;
+        if (lit == 15) {
+            do {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+
+        if (lit > iend - ip || lit > oend - op)
+            return -1;
+
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        // the last sequence has literals only
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return -1;
+
+        off = ip[0] | ((i64_t)ip[1] << 8);
+        ip += 2;
+
+        ml = tok & 15;
+        if (ml == 15) {
+            do {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                ml += b;
+            } while (b == 255);
+        }
+
+        ml += LZ_MIN_MATCH;
+
+        if (off == 0 || off > op - dst || ml > oend - op)
+            return -1;
+
+        // a match may overlap the bytes it produces, repeating them
+        ref = op - off;
+        if (off >= ml)
+            memcpy(op, ref, ml);
+        else
+            for (i = 0; i < ml; i++)
+                op[i] = ref[i];
+
+        op += ml;
+    }
+
+    return op - dst;
+}
+
+// ============================================================================
+// Filters
+// ============================================================================
+
+/*
+ * Filter len bytes of values into dst, which has room for 16 bytes more than that.
+ * Returns the size of the filtered data, or -1 if the filter does not suit the values.
+ */
+static i64_t codec_encode(u8_t codec, u8_t width, u8_t *src, i64_t len, u8_t *dst) {
+    i64_t i, n, bits, fill, base;
+    u64_t v, acc, range, *x64, *y64;
+    u32_t *x32, *y32;
+    i64_t min, max;
+    u8_t *op;
+
+    n = len / width;
+
+    switch (codec) {
+        case COMPRESS_CODEC_DELTA:
+            if (width == 4) {
+                x32 = (u32_t *)src;
+                y32 = (u32_t *)dst;
+                for (i = n - 1; i > 0; i--)
+                    y32[i] = x32[i] - x32[i - 1];
+                if (n > 0)
+                    y32[0] = x32[0];
+                return len;
+            }
+
+            if (width == 8) {
+                x64 = (u64_t *)src;
+                y64 = (u64_t *)dst;
+                for (i = n - 1; i > 0; i--)
+                    y64[i] = x64[i] - x64[i - 1];
+                if (n > 0)
+                    y64[0] = x64[0];
+                return len;
+            }
+
+            return -1;
+
+        case COMPRESS_CODEC_DELTA2:
+            if (width != 8)
+                return -1;
+
+            x64 = (u64_t *)src;
+            y64 = (u64_t *)dst;
+            for (i = n - 1; i > 1; i--)
+                y64[i] = x64[i] - 2 * x64[i - 1] + x64[i - 2];
+            if (n > 1)
+                y64[1] = x64[1] - x64[0];
+            if (n > 0)
+                y64[0] = x64[0];
+            return len;
+
+        case COMPRESS_CODEC_XOR:
+            if (width != 8)
+                return -1;
+
+            x64 = (u64_t *)src;
+            y64 = (u64_t *)dst;
+            for (i = n - 1; i > 0; i--)
+                y64[i] = x64[i] ^ x64[i - 1];
+            if (n > 0)
+                y64[0] = x64[0];
+            return len;
+
+        case COMPRESS_CODEC_FOR:
+            if ((width != 4 && width != 8) || n == 0)
+                return -1;
+
+            min = max = (width == 4) ? ((i32_t *)src)[0] : ((i64_t *)src)[0];
+            for (i = 1; i < n; i++) {
+                v = (width == 4) ? (u64_t)(i64_t)((i32_t *)src)[i] : ((u64_t *)src)[i];
+                min = ((i64_t)v < min) ? (i64_t)v : min;
+                max = ((i64_t)v > max) ? (i64_t)v : max;
+            }
+
+            // packing pays off only when it saves at least a byte a value
+            range = (u64_t)max - (u64_t)min;
+            bits = (range == 0) ? 0 : 64 - __builtin_clzll(range);
+            if (bits > width * 8 - 8)
+                return -1;
+
+            base = min;
+            memcpy(dst, &base, sizeof(i64_t));
+            memcpy(dst + sizeof(i64_t), &bits, sizeof(i64_t));
+            op = dst + 2 * sizeof(i64_t);
+
+            acc = 0;
+            fill = 0;
+            for (i = 0; i < n; i++) {
+                v = (width == 4) ? (u64_t)(i64_t)((i32_t *)src)[i] : ((u64_t *)src)[i];
+                v -= (u64_t)base;
+                acc |= v << fill;
+                fill += bits;
+                if (fill >= 64) {
+                    memcpy(op, &acc, sizeof(u64_t));
+                    op += sizeof(u64_t);
+                    fill -= 64;
+                    acc = fill ? v >> (bits - fill) : 0;
+                }
+            }
+
+            memcpy(op, &acc, (fill + 7) / 8);
+            op += (fill + 7) / 8;
+
+            return op - dst;
+
+        default:
+            return -1;
+    }
+}
+
+// Undo a filter, src has 8 bytes of room past size
+static b8_t codec_decode(u8_t codec, u8_t width, u8_t *src, i64_t size, u8_t *dst, i64_t len) {
+    i64_t i, n, bits, base, pos;
+    u64_t v, mask, *x64, *y64;
+    u32_t *x32, *y32;
+
+    n = len / width;
+
+    switch (codec) {
+        case COMPRESS_CODEC_DELTA:
+            if (size != len || (width != 4 && width != 8))
+                return B8_FALSE;
+
+            if (width == 4) {
+                x32 = (u32_t *)src;
+                y32 = (u32_t *)dst;
+                for (i = 0; i < n; i++)
+                    y32[i] = x32[i] + (i > 0 ? y32[i - 1] : 0);
+                return B8_TRUE;
+            }
+
+            x64 = (u64_t *)src;
+            y64 = (u64_t *)dst;
+            for (i = 0; i < n; i++)
+                y64[i] = x64[i] + (i > 0 ? y64[i - 1] : 0);
+            return B8_TRUE;
+
+        case COMPRESS_CODEC_DELTA2:
+            if (size != len || width != 8)
+                return B8_FALSE;
+
+            x64 = (u64_t *)src;
+            y64 = (u64_t *)dst;
+            for (i = 0; i < n; i++)
+                y64[i] = x64[i] + (i > 1 ? 2 * y64[i - 1] - y64[i - 2] : i > 0 ? y64[i - 1] : 0);
+            return B8_TRUE;
+
+        case COMPRESS_CODEC_XOR:
+            if (size != len || width != 8)
+                return B8_FALSE;
+
+            x64 = (u64_t *)src;
+            y64 = (u64_t *)dst;
+            for (i = 0; i < n; i++)
+                y64[i] = x64[i] ^ (i > 0 ? y64[i - 1] : 0);
+            return B8_TRUE;
+
+        case COMPRESS_CODEC_FOR:
+            if (size < 2 * ISIZEOF(i64_t) || (width != 4 && width != 8))
+                return B8_FALSE;
+
+            memcpy(&base, src, sizeof(i64_t));
+            memcpy(&bits, src + sizeof(i64_t), sizeof(i64_t));
+            if (bits < 0 || bits > width * 8 - 8 || size != 2 * ISIZEOF(i64_t) + (n * bits + 7) / 8)
+                return B8_FALSE;
+
+            src += 2 * sizeof(i64_t);
+            mask = (bits == 0) ? 0 : (1ull << bits) - 1;
+
+            // a value spans at most 56 bits, so it always fits a word read from its first byte
+            for (i = 0; i < n; i++) {
+                pos = i * bits;
+                memcpy(&v, src + (pos >> 3), sizeof(u64_t));
+                v = ((v >> (pos & 7)) & mask) + (u64_t)base;
+                if (width == 4)
+                    ((i32_t *)dst)[i] = (i32_t)v;
+                else
+                    ((u64_t *)dst)[i] = v;
+            }
+
+            return B8_TRUE;
+
+        default:
+            if (size != len)
+                return B8_FALSE;
+
+            memcpy(dst, src, len);
+            return B8_TRUE;
+    }
+}
+
+// ============================================================================
+// Frames
+// ============================================================================
+
+static obj_p compress_partial(compress_ctx_t *ctx, i64_t from, i64_t count) {
+    i64_t i, blen, c;
+    i32_t *tab;
+    u8_t *src, *dst;
+
+    tab = (i32_t *)heap_alloc(sizeof(i32_t) << LZ_HASH_BITS);
+
+    for (i = from; i < from + count; i++) {
+        src = ctx->src + i * COMPRESS_BLOCK_SIZE;
+        dst = ctx->dst + i * ctx->stride;
+        blen = MINI64(COMPRESS_BLOCK_SIZE, ctx->size - i * COMPRESS_BLOCK_SIZE);
+        c = lz_compress(src, blen, dst, tab);
+
+        if (c >= blen) {
+            memcpy(dst, src, blen);
+            c = blen;
+        }
+
+        ctx->offs[i] = c;
+    }
+
+    heap_free(tab);
+
+    return NULL_OBJ;
+}
+
+static obj_p decompress_partial(compress_ctx_t *ctx, i64_t from, i64_t count) {
+    i64_t i, blen, start, c;
+    u8_t *dst;
+
+    for (i = from; i < from + count; i++) {
+        start = (i > 0) ? ctx->offs[i - 1] : 0;
+        c = ctx->offs[i] - start;
+        dst = ctx->dst + i * COMPRESS_BLOCK_SIZE;
+        blen = MINI64(COMPRESS_BLOCK_SIZE, ctx->size - i * COMPRESS_BLOCK_SIZE);
+
+        if (c == blen)
+            memcpy(dst, ctx->src + start, blen);
+        else if (lz_decompress(ctx->src + start, c, dst, blen) != blen)
+            ctx->failed = B8_TRUE;
+    }
+
+    return NULL_OBJ;
+}
+
+static nil_t compress_run(compress_partial_f fn, compress_ctx_t *ctx, i64_t blocks) {
+    i64_t i, n, chunk;
+    pool_p pool = runtime_get()->pool;
+
+    n = pool_split_tasks(pool, blocks);
+
+    if (n == 1) {
+        fn(ctx, 0, blocks);
+        return;
+    }
+
+    chunk = (blocks + n - 1) / n;
+
+    pool_prepare(pool);
+    for (i = 0; i < blocks; i += chunk)
+        pool_add_task(pool, (raw_p)fn, 3, ctx, i, MINI64(chunk, blocks - i));
+    drop_obj(pool_run(pool));
+}
+
+static obj_p compress_frame(u8_t *src, compress_frame_t *frame) {
+    i64_t i, blocks, total;
+    compress_ctx_t ctx;
+    obj_p tmp, offs, res;
+    u8_t *data;
+
+    blocks = (frame->size + COMPRESS_BLOCK_SIZE - 1) / COMPRESS_BLOCK_SIZE;
+    frame->blocks = (u32_t)blocks;
+
+    ctx.src = src;
+    ctx.size = frame->size;
+    ctx.stride = lz_bound(MINI64(COMPRESS_BLOCK_SIZE, frame->size));
+    ctx.failed = B8_FALSE;
+
+    tmp = U8(blocks * ctx.stride);
+    offs = I64(blocks);
+    ctx.dst = AS_U8(tmp);
+    ctx.offs = AS_I64(offs);
+
+    compress_run(compress_partial, &ctx, blocks);
+
+    total = 0;
+    for (i = 0; i < blocks; i++)
+        total += ctx.offs[i];
+
+    res = U8(ISIZEOF(compress_frame_t) + blocks * ISIZEOF(i64_t) + total);
+    memcpy(AS_U8(res), frame, sizeof(compress_frame_t));
+    data = AS_U8(res) + ISIZEOF(compress_frame_t) + blocks * ISIZEOF(i64_t);
+
+    total = 0;
+    for (i = 0; i < blocks; i++) {
+        memcpy(data + total, ctx.dst + i * ctx.stride, ctx.offs[i]);
+        total += ctx.offs[i];
+        ((i64_t *)(AS_U8(res) + ISIZEOF(compress_frame_t)))[i] = total;
+    }
+
+    drop_obj(tmp);
+    drop_obj(offs);
+
+    return res;
+}
+
+/*
+ * Compress a serialized object.
+ */
+obj_p compress_bytes(u8_t *buf, i64_t len) {
+    compress_frame_t frame = {COMPRESS_CODEC_NONE, 1, 0, 0, 0, len, len};
+
+    return compress_frame(buf, &frame);
+}
+
+/*
+ * Compress the values of a vector of fixed size ones, through the filter suiting their type.
+ */
+obj_p compress_vector(obj_p vec) {
+    i64_t width, len, size;
+    u8_t codec;
+    obj_p enc, res;
+    compress_frame_t frame;
+
+    if (vec->type < TYPE_B8 || vec->type > TYPE_C8 || vec->type == TYPE_SYMBOL)
+        THROW(ERR_TYPE, "compress: unsupported type: '%s", type_name(vec->type));
+
+    width = size_of_type(vec->type);
+    len = vec->len * width;
+
+    switch (vec->type) {
+        case TYPE_I32:
+        case TYPE_I64:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            codec = (vec->attrs & ATTR_ASC) ? COMPRESS_CODEC_DELTA : COMPRESS_CODEC_FOR;
+            break;
+        case TYPE_TIMESTAMP:
+            codec = COMPRESS_CODEC_DELTA2;
+            break;
+        case TYPE_F64:
+            codec = COMPRESS_CODEC_XOR;
+            break;
+        default:
+            codec = COMPRESS_CODEC_NONE;
+            break;
+    }
+
+    enc = NULL_OBJ;
+    size = -1;
+
+    if (codec != COMPRESS_CODEC_NONE) {
+        enc = U8(len + 2 * ISIZEOF(i64_t));
+        size = codec_encode(codec, (u8_t)width, AS_U8(vec), len, AS_U8(enc));
+    }
+
+    frame.codec = (size == -1) ? COMPRESS_CODEC_NONE : codec;
+    frame.width = (u8_t)width;
+    frame.type = vec->type;
+    frame.attrs = vec->attrs;
+    frame.len = len;
+    frame.size = (size == -1) ? len : size;
+
+    res = compress_frame((size == -1) ? AS_U8(vec) : AS_U8(enc), &frame);
+    drop_obj(enc);
+
+    return res;
+}
+
+/*
+ * Decompress a frame back into the object it was made of.
+ */
+obj_p decompress_obj(u8_t *buf, i64_t len) {
+    i64_t i, l, blocks, hdr;
+    compress_frame_t *frame;
+    compress_ctx_t ctx;
+    obj_p tmp, res;
+
+    if (len < ISIZEOF(compress_frame_t))
+        return error_str(ERR_IO, "decompress: buffer too small to contain a frame");
+
+    frame = (compress_frame_t *)buf;
+    blocks = frame->blocks;
+    hdr = ISIZEOF(compress_frame_t) + blocks * ISIZEOF(i64_t);
+
+    if (frame->size < 0 || frame->len < 0 || blocks != (frame->size + COMPRESS_BLOCK_SIZE - 1) / COMPRESS_BLOCK_SIZE ||
+        len < hdr)
+        return error_str(ERR_IO, "decompress: corrupted frame header");
+
+    if (frame->type != 0 && (frame->type < TYPE_B8 || frame->type > TYPE_C8 || frame->type == TYPE_SYMBOL ||
+                             frame->width != size_of_type(frame->type) || frame->len % frame->width != 0))
+        return error_str(ERR_IO, "decompress: corrupted frame header");
+
+    ctx.src = buf + hdr;
+    ctx.offs = (i64_t *)(buf + ISIZEOF(compress_frame_t));
+    ctx.size = frame->size;
+    ctx.failed = B8_FALSE;
+
+    for (i = 0; i < blocks; i++) {
+        if (ctx.offs[i] < ((i > 0) ? ctx.offs[i - 1] : 0) || ctx.offs[i] > len - hdr)
+            return error_str(ERR_IO, "decompress: corrupted block offsets");
+    }
+
+    // unfiltered vectors decompress right into place
+    if (frame->type != 0 && frame->codec == COMPRESS_CODEC_NONE) {
+        if (frame->size != frame->len)
+            return error_str(ERR_IO, "decompress: corrupted frame header");
+
+        res = vector(frame->type, frame->len / frame->width);
+        ctx.dst = AS_U8(res);
+        compress_run(decompress_partial, &ctx, blocks);
+
+        if (ctx.failed) {
+            drop_obj(res);
+            return error_str(ERR_IO, "decompress: corrupted block");
+        }
+
+        res->attrs = frame->attrs;
+        return res;
+    }
+
+    tmp = U8(frame->size + ISIZEOF(u64_t));
+    ctx.dst = AS_U8(tmp);
+    compress_run(decompress_partial, &ctx, blocks);
+
+    if (ctx.failed) {
+        drop_obj(tmp);
+        return error_str(ERR_IO, "decompress: corrupted block");
+    }
+
+    if (frame->type == 0) {
+        l = frame->size;
+        res = de_raw(AS_U8(tmp), &l);
+        drop_obj(tmp);
+        return res;
+    }
+
+    res = vector(frame->type, frame->len / frame->width);
+
+    if (!codec_decode(frame->codec, frame->width, AS_U8(tmp), frame->size, AS_U8(res), frame->len)) {
+        drop_obj(tmp);
+        drop_obj(res);
+        return error_str(ERR_IO, "decompress: corrupted filtered values");
+    }
+
+    drop_obj(tmp);
+    res->attrs = frame->attrs;
+
+    return res;
+}
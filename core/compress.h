@@ -0,0 +1,48 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include "rayforce.h"
+
+#define COMPRESS_BLOCK_SIZE (1ll << 20)  // bytes per block, blocks are compressed and decompressed independently
+#define COMPRESS_MIN_SIZE (1ll << 16)    // smaller payloads are sent and stored as they are
+
+// Filters applied to the values of a vector before compressing them
+typedef enum compress_codec_t {
+    COMPRESS_CODEC_NONE = 0,
+    COMPRESS_CODEC_DELTA,   // differences between neighbours, for sorted integers
+    COMPRESS_CODEC_DELTA2,  // differences of differences, for timestamps ticking at a steady rate
+    COMPRESS_CODEC_XOR,     // bits xored with the previous value, for floats changing a little at a time
+    COMPRESS_CODEC_FOR,     // offsets from the minimum packed into as few bits as the range needs
+} compress_codec_t;
+
+obj_p compress_bytes(u8_t *buf, i64_t len);
+obj_p compress_vector(obj_p vec);
+obj_p decompress_obj(u8_t *buf, i64_t len);
+b8_t compress_columns(nil_t);
+i64_t compress_set_columns(i64_t x);
+
+#endif  // COMPRESS_H
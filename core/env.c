@@ -29,6 +29,7 @@
 #include "cond.h"
 #include "dynlib.h"
 #include "format.h"
+#include "hash.h"
 #include "io.h"
 #include "items.h"
 #include "iter.h"
@@ -51,6 +52,7 @@
 #include "vary.h"
 #include "os.h"
 #include "proc.h"
+#include "grouped.h"
 
 i64_t SYMBOL_FN;
 i64_t SYMBOL_SELF;
@@ -94,6 +96,58 @@ obj_p ray_env(obj_p *x, i64_t n) {
     return clone_obj(runtime_get()->env.variables);
 }
 
+#define ENV_HT_SIZE 256
+
+// the null symbol marks empty slots of the hash table, while no symbol lives at address 0
+#define ENV_KEY(x) (((x) == NULL_I64) ? 0 : (x))
+
+/*
+ * Slot of a variable in env->variables, NULL_I64 if there is no such variable.
+ * Slots never move: variables are only appended or replaced in place.
+ */
+i64_t env_find(env_t *env, i64_t key) {
+    i64_t idx;
+
+    idx = ht_oa_tab_get_with(env->index, ENV_KEY(key), &hash_fnv1a, &hash_cmp_i64, NULL);
+
+    return (idx == NULL_I64) ? NULL_I64 : AS_I64(AS_LIST(env->index)[1])[idx];
+}
+
+/*
+ * Bind a variable, the value is consumed.
+ */
+obj_p env_set(env_t *env, obj_p key, obj_p val) {
+    i64_t i, idx, k;
+    obj_p res;
+
+    i = env_find(env, key->i64);
+    if (i != NULL_I64) {
+        res = set_idx(&AS_LIST(env->variables)[1], i, val);
+        return IS_ERR(res) ? res : NULL_OBJ;
+    }
+
+    i = AS_LIST(env->variables)[0]->len;
+
+    res = push_obj(&AS_LIST(env->variables)[1], val);
+    if (IS_ERR(res))
+        return res;
+
+    push_raw(&AS_LIST(env->variables)[0], &key->i64);
+
+    k = ENV_KEY(key->i64);
+    idx = ht_oa_tab_next_with(&env->index, k, &hash_fnv1a, &hash_cmp_i64, NULL);
+    AS_I64(AS_LIST(env->index)[0])[idx] = k;
+    AS_I64(AS_LIST(env->index)[1])[idx] = i;
+
+    // keep the table sparse, probes get long long before it is full
+    if (2 * (i + 1) > AS_LIST(env->index)[0]->len)
+        ht_oa_rehash(&env->index, &hash_fnv1a, NULL);
+
+    env->version++;
+
+    return NULL_OBJ;
+}
+
 obj_p ray_memstat(obj_p *x, i64_t n) {
     UNUSED(x);
     UNUSED(n);
@@ -173,6 +227,7 @@ nil_t init_functions(obj_p functions)
     REGISTER_FN(functions,  "unify",               TYPE_UNARY,    FN_NONE,                   ray_unify);
     REGISTER_FN(functions,  "diverse",             TYPE_UNARY,    FN_NONE,                   ray_diverse);
     REGISTER_FN(functions,  "row",                 TYPE_UNARY,    FN_NONE | FN_AGGR,         ray_row);
+    REGISTER_FN(functions,  "grouped",             TYPE_UNARY,    FN_NONE,                   ray_grouped);
     
     // Binary           
     REGISTER_FN(functions,  "try",                 TYPE_BINARY,   FN_NONE | FN_SPECIAL_FORM, try_obj);
@@ -286,6 +341,7 @@ nil_t init_typenames(obj_p typenames)
     REGISTER_TYPE(typenames,    TYPE_F64,             "F64");
     REGISTER_TYPE(typenames,    TYPE_C8,              "String");
     REGISTER_TYPE(typenames,    TYPE_ENUM,            "Enum");
+    REGISTER_TYPE(typenames,    TYPE_STRINGS,         "Strings");
     REGISTER_TYPE(typenames,    TYPE_PARTEDLIST,      "Partedlist");
     REGISTER_TYPE(typenames,    TYPE_PARTEDB8,        "Partedb8");
     REGISTER_TYPE(typenames,    TYPE_PARTEDU8,        "Partedu8");
@@ -360,6 +416,8 @@ env_t env_create(nil_t) {
         .keywords = keywords,
         .functions = functions,
         .variables = variables,
+        .index = ht_oa_create(ENV_HT_SIZE, TYPE_I64),
+        .version = 0,
         .typenames = typenames,
         .internals = internals,
     };
@@ -371,6 +429,7 @@ nil_t env_destroy(env_t *env) {
     drop_obj(env->keywords);
     drop_obj(env->functions);
     drop_obj(env->variables);
+    drop_obj(env->index);
     drop_obj(env->typenames);
     drop_obj(env->internals);
 }
@@ -50,6 +50,8 @@ typedef struct env_t {
     obj_p keywords;   // list of reserved keywords
     obj_p functions;  // dict, containing function primitives
     obj_p variables;  // dict, containing mappings variables names to their values
+    obj_p index;      // hash table, mapping variables names to their slots in variables
+    i64_t version;    // bumped whenever variables change their layout, invalidates slots cached by callers
     obj_p typenames;  // dict, containing mappings type ids to their names
     obj_p internals;  // dict, containing internal functions, variables, descriptors etc.
 } env_t;
@@ -67,6 +69,7 @@ obj_p env_get_internal_function_by_id(i64_t id);
 str_p env_get_internal_function_name(lit_p name, i64_t len, i64_t *index, b8_t exact);
 str_p env_get_internal_keyword_name(lit_p name, i64_t len, i64_t *index, b8_t exact);
 str_p env_get_global_name(lit_p name, i64_t len, i64_t *index, i64_t *sbidx);
+i64_t env_find(env_t *env, i64_t key);
 obj_p env_set(env_t *env, obj_p key, obj_p val);
 obj_p ray_env(obj_p *x, i64_t n);
 obj_p ray_memstat(obj_p *x, i64_t n);
@@ -28,12 +28,15 @@
 #include "vary.h"
 #include "io.h"
 #include "lambda.h"
+#include "vm.h"
 #include "items.h"
 #include "error.h"
 #include "filter.h"
 #include "group.h"
 #include "string.h"
 #include "aggr.h"
+#include "order.h"
+#include "fuse.h"
 
 __thread interpreter_p __INTERPRETER = NULL;
 
@@ -88,6 +91,7 @@ interpreter_p interpreter_create(i64_t id) {
     AS_LAMBDA(f)->nfo = NULL_OBJ;
     AS_LAMBDA(f)->args = NULL_OBJ;
     AS_LAMBDA(f)->body = NULL_OBJ;
+    AS_LAMBDA(f)->code = NULL_OBJ;
 
     ctx_push(f);
 
@@ -124,7 +128,14 @@ obj_p call(obj_p obj, i64_t arity) {
     ctx->sp = sp;
 
     // jump to eval
-    res = (setjmp(ctx->jmp) == 0) ? eval(lambda->body) : stack_pop();
+    if (setjmp(ctx->jmp) == 0)
+        res = (lambda->code != NULL_OBJ) ? vm_exec(lambda->code) : eval(lambda->body);
+    else {
+        res = stack_pop();
+        // drop whatever the frame had on the stack when it was left
+        while (__INTERPRETER->sp > sp + arity + 1)
+            drop_obj(stack_pop());
+    }
 
     // pop context
     ctx_pop();
@@ -184,6 +195,10 @@ __attribute__((hot)) obj_p eval(obj_p obj) {
                         return unwrap(error_str(ERR_ARITY, "binary function must have 2 arguments"), (i64_t)obj);
                     if (car->attrs & FN_SPECIAL_FORM)
                         res = ((binary_f)car->i64)(args[0], args[1]);
+                    else if ((res = fuse_eval(obj)) != NULL)
+                        return res;  // chains of element-wise operators go over the rows once
+                    else if (car->i64 == (i64_t)ray_take && (res = order_take(args[0], args[1])) != NULL)
+                        ;  // take of a sort only orders the rows it keeps
                     else {
                         x = eval(args[0]);
                         if (IS_ERR(x))
@@ -636,7 +651,7 @@ obj_p *resolve(i64_t sym) {
     }
 
     // search globals
-    j = find_raw(AS_LIST(runtime_get()->env.variables)[0], &sym);
+    j = env_find(&runtime_get()->env, sym);
     if (j == NULL_I64)
         return NULL;
 
@@ -48,4 +48,18 @@ obj_p filter_map(obj_p val, obj_p index) {
     }
 }
 
-obj_p filter_collect(obj_p val, obj_p index) { return at_ids(val, AS_I64(index), index->len); }
+obj_p filter_collect(obj_p val, obj_p index) {
+    obj_p res;
+
+    res = at_ids(val, AS_I64(index), index->len);
+
+    // rows picked in order keep the order of the values, distinct rows keep them distinct
+    if (res->type > TYPE_LIST && res->type < TYPE_ENUM) {
+        if (index->attrs & ATTR_ASC)
+            res->attrs |= val->attrs & (ATTR_ASC | ATTR_DESC);
+        if (index->attrs & ATTR_DISTINCT)
+            res->attrs |= val->attrs & ATTR_DISTINCT;
+    }
+
+    return res;
+}
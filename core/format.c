@@ -713,6 +713,7 @@ i64_t raw_fmt_into(obj_p *dst, i64_t indent, i64_t limit, obj_p obj, i64_t i) {
         case TYPE_PARTEDGUID:
         case TYPE_PARTEDENUM:
         case TYPE_MAPCOMMON:
+        case TYPE_STRINGS:
             res = at_idx(obj, i);
             n = obj_fmt_into(dst, indent, limit, B8_FALSE, res);
             drop_obj(res);
@@ -837,6 +838,23 @@ i64_t enum_fmt_into(obj_p *dst, i64_t indent, i64_t limit, obj_p obj) {
     return n;
 }
 
+// Only the rows shown are picked, one more than fits tells the list it is cut
+i64_t strings_fmt_into(obj_p *dst, i64_t indent, i64_t limit, b8_t full, obj_p obj) {
+    i64_t i, l, n;
+    obj_p a;
+
+    l = (obj->len > LIST_MAX_HEIGHT) ? LIST_MAX_HEIGHT + 1 : obj->len;
+    a = LIST(l);
+    for (i = 0; i < l; i++)
+        AS_LIST(a)[i] = at_idx(obj, i);
+
+    n = list_fmt_into(dst, indent, limit, full, a);
+
+    drop_obj(a);
+
+    return n;
+}
+
 i64_t anymap_fmt_into(obj_p *dst, i64_t indent, i64_t limit, b8_t full, obj_p obj) {
     i64_t n;
     obj_p a, idx;
@@ -1177,6 +1195,8 @@ i64_t obj_fmt_into(obj_p *dst, i64_t indent, i64_t limit, b8_t full, obj_p obj)
             return enum_fmt_into(dst, indent, limit, obj);
         case TYPE_MAPLIST:
             return anymap_fmt_into(dst, indent, limit, full, obj);
+        case TYPE_STRINGS:
+            return strings_fmt_into(dst, indent, limit, full, obj);
         case TYPE_DICT:
             return dict_fmt_into(dst, indent, limit, full, obj);
         case TYPE_TABLE:
@@ -0,0 +1,384 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+
+#include "fuse.h"
+#include "eval.h"
+#include "binary.h"
+#include "math.h"
+#include "cmp.h"
+#include "error.h"
+#include "aggr.h"
+#include "filter.h"
+#include "chrono.h"
+#include "pool.h"
+#include "runtime.h"
+#include "serde.h"
+
+/*
+ * Fusion of element-wise operators. A tree of arithmetic operators, possibly under a comparison, over vectors of the
+ * same length is not evaluated an operator at a time, each going over whole vectors and leaving one behind: its
+ * operands are evaluated first, then the rows go through the whole tree in morsels of FUSE_MORSEL rows, the values
+ * of the operators below the top one never leaving the cache. Morsels are spread over the executors.
+ *
+ * Operators run through their own partials, so the types and values they yield are the ones of the operators
+ * applied one by one. Whenever the operands are not plain numeric vectors and atoms, the tree is applied operator by
+ * operator to the operands already evaluated, as the tree walker would.
+ */
+
+typedef obj_p (*fuse_partial_f)(obj_p, obj_p, i64_t, i64_t, obj_p);
+
+typedef struct fuse_op_t {
+    raw_p fn;       // the builtin
+    raw_p partial;  // its partial over a range of rows
+    b8_t cmp;       // a comparison, it yields booleans
+} fuse_op_t;
+
+static const fuse_op_t FUSE_OPS[] = {
+    {(raw_p)ray_add, (raw_p)ray_add_partial, B8_FALSE}, {(raw_p)ray_sub, (raw_p)ray_sub_partial, B8_FALSE},
+    {(raw_p)ray_mul, (raw_p)ray_mul_partial, B8_FALSE}, {(raw_p)ray_div, (raw_p)ray_div_partial, B8_FALSE},
+    {(raw_p)ray_fdiv, (raw_p)ray_fdiv_partial, B8_FALSE}, {(raw_p)ray_mod, (raw_p)ray_mod_partial, B8_FALSE},
+    {(raw_p)ray_xbar, (raw_p)ray_xbar_partial, B8_FALSE}, {(raw_p)ray_eq, (raw_p)ray_EQ_partial, B8_TRUE},
+    {(raw_p)ray_ne, (raw_p)ray_NE_partial, B8_TRUE},      {(raw_p)ray_lt, (raw_p)ray_LT_partial, B8_TRUE},
+    {(raw_p)ray_gt, (raw_p)ray_GT_partial, B8_TRUE},      {(raw_p)ray_le, (raw_p)ray_LE_partial, B8_TRUE},
+    {(raw_p)ray_ge, (raw_p)ray_GE_partial, B8_TRUE},
+};
+
+#define FUSE_OPS_COUNT ((i64_t)(sizeof(FUSE_OPS) / sizeof(FUSE_OPS[0])))
+
+// Operators and operands of a tree, every operator after its operands
+typedef struct fuse_slot_t {
+    obj_p node;           // expression the slot stands for
+    const fuse_op_t *op;  // its operator, NULL for an operand
+    i64_t x, y;           // slots of the operands of the operator
+    obj_p val;            // value of an operand
+    i8_t type;            // type of the values of the slot
+} fuse_slot_t;
+
+typedef struct fuse_t {
+    i64_t n;    // slots used, the top operator being the last one
+    i64_t len;  // rows
+    fuse_slot_t slots[FUSE_MAX_SLOTS];
+} fuse_t;
+
+static b8_t FUSE_ENABLED = B8_TRUE;
+
+b8_t fuse_enabled(nil_t) { return FUSE_ENABLED; }
+
+i64_t fuse_set_enabled(i64_t x) {
+    FUSE_ENABLED = (x != 0);
+    return 0;
+}
+
+// Operator of an expression, if it can be fused; comparisons only go on top of a tree
+static const fuse_op_t *fuse_op(obj_p node, b8_t top) {
+    i64_t i;
+    obj_p car;
+
+    if (node->type != TYPE_LIST || node->len != 3)
+        return NULL;
+
+    car = AS_LIST(node)[0];
+    if (car->type != TYPE_BINARY || !(car->attrs & FN_ATOMIC))
+        return NULL;
+
+    for (i = 0; i < FUSE_OPS_COUNT; i++) {
+        if (FUSE_OPS[i].fn == (raw_p)car->i64)
+            return (FUSE_OPS[i].cmp && !top) ? NULL : &FUSE_OPS[i];
+    }
+
+    return NULL;
+}
+
+/*
+ * Whether an expression is a tree of at least two operators that can be fused.
+ */
+b8_t fuse_tree(obj_p node) {
+    obj_p *args;
+
+    if (node->type != TYPE_LIST || node->len != 3)
+        return B8_FALSE;
+
+    args = AS_LIST(node) + 1;
+    if ((args[0]->type != TYPE_LIST || args[0]->len != 3) && (args[1]->type != TYPE_LIST || args[1]->len != 3))
+        return B8_FALSE;
+
+    return fuse_op(node, B8_TRUE) != NULL &&
+           (fuse_op(args[0], B8_FALSE) != NULL || fuse_op(args[1], B8_FALSE) != NULL);
+}
+
+// Lay a tree out into slots, below limit; subtrees left without room become operands
+static i64_t fuse_plan(fuse_t *f, obj_p node, b8_t top, i64_t limit) {
+    i64_t i, x = 0, y = 0;
+    const fuse_op_t *op;
+
+    op = (f->n + 3 <= limit) ? fuse_op(node, top) : NULL;
+    if (op != NULL) {
+        x = fuse_plan(f, AS_LIST(node)[1], B8_FALSE, limit - 2);
+        y = fuse_plan(f, AS_LIST(node)[2], B8_FALSE, limit - 1);
+    }
+
+    i = f->n++;
+    f->slots[i].node = node;
+    f->slots[i].op = op;
+    f->slots[i].x = x;
+    f->slots[i].y = y;
+    f->slots[i].val = NULL_OBJ;
+    f->slots[i].type = 0;
+
+    return i;
+}
+
+// Whether the operands allow a single pass: numeric atoms and vectors of the same length, long enough for it to pay
+static b8_t fuse_check(fuse_t *f) {
+    i64_t i, l;
+    fuse_slot_t *s;
+
+    l = -1;
+
+    for (i = 0; i < f->n; i++) {
+        s = &f->slots[i];
+
+        if (s->op == NULL) {
+            switch (s->val->type) {
+                case -TYPE_I32:
+                case -TYPE_I64:
+                case -TYPE_F64:
+                    break;
+                case TYPE_I32:
+                case TYPE_I64:
+                case TYPE_F64:
+                    if (l != -1 && s->val->len != l)
+                        return B8_FALSE;
+                    l = s->val->len;
+                    break;
+                default:
+                    return B8_FALSE;
+            }
+
+            s->type = s->val->type;
+            continue;
+        }
+
+        // an operator over two atoms yields an atom, not rows
+        if (f->slots[s->x].type < 0 && f->slots[s->y].type < 0)
+            return B8_FALSE;
+
+        s->type = s->op->cmp ? TYPE_B8 : binop_type(s->op->partial, f->slots[s->x].type, f->slots[s->y].type);
+        if (s->type != TYPE_I32 && s->type != TYPE_I64 && s->type != TYPE_F64 && s->type != TYPE_B8)
+            return B8_FALSE;
+    }
+
+    f->len = l;
+
+    return l >= FUSE_MORSEL;
+}
+
+// Go through the rows [from, from + len) a morsel at a time, into out
+obj_p fuse_partial(fuse_t *f, i64_t from, i64_t len, obj_p out) {
+    i64_t i, m, k, w;
+    obj_p v, res, tmp[FUSE_MAX_SLOTS];
+    fuse_slot_t *s;
+
+    // a morsel of every vector and operator, atoms are used as they are
+    for (i = 0; i < f->n; i++) {
+        s = &f->slots[i];
+        tmp[i] = (s->type < 0) ? s->val : vector(s->type, FUSE_MORSEL);
+    }
+
+    res = NULL_OBJ;
+
+    for (m = from; m < from + len; m += FUSE_MORSEL) {
+        k = MINI64(FUSE_MORSEL, from + len - m);
+
+        for (i = 0; i < f->n; i++) {
+            s = &f->slots[i];
+
+            if (s->type < 0)
+                continue;
+
+            if (s->op == NULL) {
+                w = size_of_type(s->type);
+                memcpy(AS_U8(tmp[i]), AS_U8(s->val) + m * w, k * w);
+                continue;
+            }
+
+            v = ((fuse_partial_f)s->op->partial)(tmp[s->x], tmp[s->y], k, 0, tmp[i]);
+            if (IS_ERR(v)) {
+                res = v;
+                goto done;
+            }
+        }
+
+        w = size_of_type(out->type);
+        memcpy(AS_U8(out) + m * w, AS_U8(tmp[f->n - 1]), k * w);
+    }
+
+done:
+    for (i = 0; i < f->n; i++) {
+        if (f->slots[i].type > 0)
+            drop_obj(tmp[i]);
+    }
+
+    return res;
+}
+
+static obj_p fuse_run(fuse_t *f) {
+    i64_t i, l, n, chunk;
+    obj_p v, out;
+    pool_p pool;
+
+    l = f->len;
+    out = vector(f->slots[f->n - 1].type, l);
+
+    pool = runtime_get()->pool;
+    n = pool_split_by(pool, l, 0);
+
+    if (n == 1)
+        v = fuse_partial(f, 0, l, out);
+    else {
+        // whole morsels for every executor
+        chunk = (l + n - 1) / n;
+        chunk = (chunk + FUSE_MORSEL - 1) / FUSE_MORSEL * FUSE_MORSEL;
+
+        pool_prepare(pool);
+        for (i = 0; i < l; i += chunk)
+            pool_add_task(pool, (raw_p)fuse_partial, 4, f, i, MINI64(chunk, l - i), out);
+
+        v = pool_run(pool);
+    }
+
+    if (IS_ERR(v)) {
+        drop_obj(out);
+        return unwrap(v, (i64_t)f->slots[f->n - 1].node);
+    }
+
+    drop_obj(v);
+
+    return out;
+}
+
+static obj_p fuse_collect(obj_p car, obj_p x) {
+    obj_p y;
+
+    if (!(car->attrs & FN_AGGR) && x->type == TYPE_MAPGROUP) {
+        y = aggr_collect(AS_LIST(x)[0], AS_LIST(x)[1]);
+        drop_obj(x);
+        return y;
+    }
+
+    if (x->type == TYPE_MAPFILTER) {
+        y = filter_collect(AS_LIST(x)[0], AS_LIST(x)[1]);
+        drop_obj(x);
+        return y;
+    }
+
+    return x;
+}
+
+// Apply the operators one by one to the operands, the values of which are taken out of their slots
+static obj_p fuse_apply(fuse_t *f, i64_t i) {
+    fuse_slot_t *s;
+    obj_p car, x, y, res;
+
+    s = &f->slots[i];
+
+    if (s->op == NULL) {
+        res = s->val;
+        s->val = NULL_OBJ;
+        return res;
+    }
+
+    car = AS_LIST(s->node)[0];
+
+    x = fuse_apply(f, s->x);
+    if (IS_ERR(x))
+        return x;
+
+    y = fuse_apply(f, s->y);
+    if (IS_ERR(y)) {
+        drop_obj(x);
+        return y;
+    }
+
+    x = fuse_collect(car, x);
+    y = fuse_collect(car, y);
+
+    res = binary_call(car, x, y);
+    drop_obj(x);
+    drop_obj(y);
+
+    return unwrap(res, (i64_t)s->node);
+}
+
+static nil_t fuse_drop(fuse_t *f) {
+    i64_t i;
+
+    for (i = 0; i < f->n; i++)
+        drop_obj(f->slots[i].val);
+}
+
+/*
+ * Evaluate a tree of element-wise operators, NULL if it is not one that can be fused (nothing is evaluated then).
+ * Errors carry the location of the operator or operand they come from, as with the tree walker.
+ */
+obj_p fuse_eval(obj_p node) {
+    i64_t i;
+    fuse_t f;
+    obj_p res;
+
+    if (!FUSE_ENABLED || !fuse_tree(node))
+        return NULL;
+
+    f.n = 0;
+    f.len = 0;
+    fuse_plan(&f, node, B8_TRUE, FUSE_MAX_SLOTS);
+
+    // operands come first, in the order the tree walker evaluates them
+    for (i = 0; i < f.n; i++) {
+        if (f.slots[i].op != NULL)
+            continue;
+
+        res = eval(f.slots[i].node);
+        if (IS_ERR(res)) {
+            fuse_drop(&f);
+            return res;
+        }
+
+        f.slots[i].val = res;
+    }
+
+    timeit_tick("fuse: eval operands");
+
+    if (fuse_check(&f)) {
+        res = fuse_run(&f);
+        timeit_tick("fuse: single pass");
+    } else {
+        res = fuse_apply(&f, f.n - 1);
+        timeit_tick("fuse: operator by operator");
+    }
+
+    fuse_drop(&f);
+
+    return res;
+}
@@ -0,0 +1,481 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#include "grouped.h"
+#include "ops.h"
+#include "util.h"
+#include "error.h"
+#include "hash.h"
+#include "index.h"
+#include "items.h"
+#include "unary.h"
+#include "runtime.h"
+
+/*
+ * Group indexes: the groups of a symbol column kept along with it, so that grouping by the column does not hash
+ * it again and == or in over it only visit the rows holding the values looked for. An index is a list of
+ *   - the value of every group, in order of first appearance,
+ *   - the group of every row,
+ *   - the rows of every group, ascending,
+ *   - a hash table from values to their groups, rebuilt on load since symbols differ from process to process.
+ * A vector having one carries ATTR_GROUPED, so that changing or releasing it detaches the index.
+ */
+
+#define GROUPED_HT_SIZE 64
+
+// the null symbol marks empty slots of the hash tables, while no symbol lives at address 0
+#define GROUPED_KEY(x) (((x) == NULL_I64) ? 0 : (x))
+
+static obj_p grouped_make(obj_p keys, obj_p ids, obj_p rows) {
+    i64_t i, l;
+    obj_p ht;
+
+    l = keys->len;
+    ht = ht_oa_create(2 * l + GROUPED_HT_SIZE, TYPE_I64);
+    for (i = 0; i < l; i++)
+        ht_oa_tab_insert_with(&ht, GROUPED_KEY(AS_SYMBOL(keys)[i]), i, &hash_fnv1a, &hash_cmp_i64, NULL);
+
+    return vn_list(4, keys, ids, rows, ht);
+}
+
+// Group of a value, -1 if no row holds it
+static i64_t grouped_find(obj_p index, i64_t val) {
+    i64_t idx;
+    obj_p ht;
+
+    ht = AS_LIST(index)[3];
+    idx = ht_oa_tab_get_with(ht, GROUPED_KEY(val), &hash_fnv1a, &hash_cmp_i64, NULL);
+
+    return (idx == NULL_I64) ? -1 : AS_I64(AS_LIST(ht)[1])[idx];
+}
+
+// Group of a value, a new one if no row holds it yet
+static i64_t grouped_next(obj_p *ht, i64_t val, i64_t groups, b8_t *fresh) {
+    i64_t idx, key, g, *keys;
+
+    key = GROUPED_KEY(val);
+    idx = ht_oa_tab_next_with(ht, key, &hash_fnv1a, &hash_cmp_i64, NULL);
+    keys = AS_I64(AS_LIST(*ht)[0]);
+    *fresh = (keys[idx] == NULL_I64);
+
+    if (!*fresh)
+        return AS_I64(AS_LIST(*ht)[1])[idx];
+
+    keys[idx] = key;
+    AS_I64(AS_LIST(*ht)[1])[idx] = groups;
+    g = groups;
+
+    // keep the table sparse, probes get long long before it is full
+    if (2 * (groups + 1) > AS_LIST(*ht)[0]->len)
+        ht_oa_rehash(ht, &hash_fnv1a, NULL);
+
+    return g;
+}
+
+// An object to change in place, the reference to the shared one given up
+static obj_p grouped_own(obj_p obj) {
+    obj_p res;
+
+    res = cow_obj(obj);
+    if (res != obj)
+        drop_obj(obj);
+
+    return res;
+}
+
+obj_p grouped_build(obj_p col) {
+    i64_t i, l, g, c, zero = 0, *codes, *ids, *cnts;
+    b8_t fresh;
+    obj_p vals, ht, keys, counts, idsv, rows, k, dom;
+
+    switch (col->type) {
+        case TYPE_SYMBOL:
+            vals = col;
+            break;
+        case TYPE_ENUM:
+            vals = ENUM_VAL(col);
+            break;
+        default:
+            return NULL_OBJ;
+    }
+
+    l = vals->len;
+    codes = AS_I64(vals);
+    idsv = I64(l);
+    ids = AS_I64(idsv);
+    keys = I64(0);
+    counts = I64(0);
+    ht = ht_oa_create(GROUPED_HT_SIZE, TYPE_I64);
+
+    for (i = 0, g = 0; i < l; i++) {
+        ids[i] = grouped_next(&ht, codes[i], g, &fresh);
+        if (fresh) {
+            push_raw(&keys, &codes[i]);
+            push_raw(&counts, &zero);
+            g++;
+        }
+
+        AS_I64(counts)[ids[i]]++;
+    }
+
+    drop_obj(ht);
+
+    // scatter rows to their groups, counts become write cursors
+    cnts = AS_I64(counts);
+    rows = LIST(g);
+    for (i = 0; i < g; i++) {
+        AS_LIST(rows)[i] = I64(cnts[i]);
+        cnts[i] = 0;
+    }
+
+    for (i = 0; i < l; i++)
+        AS_I64(AS_LIST(rows)[ids[i]])[cnts[ids[i]]++] = i;
+
+    drop_obj(counts);
+
+    // enumerations are grouped by their indices, the index keeps the symbols they stand for
+    if (col->type == TYPE_ENUM) {
+        k = ray_key(col);
+        dom = ray_get(k);
+        drop_obj(k);
+
+        if (dom->type != TYPE_SYMBOL) {
+            drop_obj(dom);
+            drop_obj(keys);
+            drop_obj(idsv);
+            drop_obj(rows);
+            return NULL_OBJ;
+        }
+
+        for (i = 0; i < g; i++) {
+            c = AS_I64(keys)[i];
+            AS_I64(keys)[i] = (c >= 0 && c < (i64_t)dom->len) ? AS_SYMBOL(dom)[c] : NULL_I64;
+        }
+
+        drop_obj(dom);
+    }
+
+    keys->type = TYPE_SYMBOL;
+
+    return grouped_make(keys, idsv, rows);
+}
+
+// Index out of what grouped_save gave, NULL_OBJ if it is not one
+obj_p grouped_load(obj_p saved) {
+    obj_p keys, ids, rows;
+
+    if (saved->type != TYPE_LIST || saved->len != 3)
+        return NULL_OBJ;
+
+    keys = AS_LIST(saved)[0];
+    ids = AS_LIST(saved)[1];
+    rows = AS_LIST(saved)[2];
+
+    if (keys->type != TYPE_SYMBOL || ids->type != TYPE_I64 || rows->type != TYPE_LIST || rows->len != keys->len)
+        return NULL_OBJ;
+
+    return grouped_make(clone_obj(keys), clone_obj(ids), clone_obj(rows));
+}
+
+obj_p grouped_save(obj_p index) {
+    return vn_list(3, clone_obj(AS_LIST(index)[0]), clone_obj(AS_LIST(index)[1]), clone_obj(AS_LIST(index)[2]));
+}
+
+obj_p grouped_get(obj_p col) {
+    if (!IS_VECTOR(col) || !(col->attrs & ATTR_GROUPED))
+        return NULL_OBJ;
+
+    return runtime_grouped_get(runtime_get(), col);
+}
+
+nil_t grouped_set(obj_p col, obj_p index) {
+    col->attrs |= ATTR_GROUPED;
+    runtime_grouped_push(runtime_get(), col, index);
+}
+
+nil_t grouped_drop(obj_p col) {
+    if (!(col->attrs & ATTR_GROUPED))
+        return;
+
+    runtime_grouped_pop(runtime_get(), col);
+    col->attrs &= ~ATTR_GROUPED;
+}
+
+/*
+ * Index of a symbol column about to get rows appended, to be given back with grouped_extend once they are.
+ * A column changed in place loses it meanwhile, so that the append does not discard it.
+ */
+obj_p grouped_take(obj_p col) {
+    obj_p index;
+
+    if (col->type != TYPE_SYMBOL)
+        return NULL_OBJ;
+
+    index = grouped_get(col);
+    if (index != NULL_OBJ && rc_obj(col) == 1)
+        grouped_drop(col);
+
+    return index;
+}
+
+// Attach an index to a column after adding its rows from a given one on
+nil_t grouped_extend(obj_p col, obj_p index, i64_t from) {
+    i64_t i, l, g, *vals;
+    b8_t fresh;
+    obj_p *parts, *row;
+
+    if (col->type != TYPE_SYMBOL) {
+        drop_obj(index);
+        return;
+    }
+
+    index = grouped_own(index);
+    parts = AS_LIST(index);
+    for (i = 0; i < 4; i++)
+        parts[i] = grouped_own(parts[i]);
+
+    l = col->len;
+    vals = AS_I64(col);
+
+    for (i = from; i < l; i++) {
+        g = grouped_next(&parts[3], vals[i], parts[0]->len, &fresh);
+        if (fresh) {
+            push_raw(&parts[0], &vals[i]);
+            push_obj(&parts[2], I64(0));
+        }
+
+        push_raw(&parts[1], &g);
+        row = &AS_LIST(parts[2])[g];
+        *row = grouped_own(*row);
+        push_raw(row, &i);
+    }
+
+    grouped_set(col, index);
+}
+
+// Groups holding a symbol or any of symbols, in order of first appearance among vals
+static obj_p grouped_ids(obj_p index, obj_p vals) {
+    i64_t i, g;
+    obj_p seen, res;
+
+    res = I64(0);
+
+    if (vals->type == -TYPE_SYMBOL) {
+        g = grouped_find(index, vals->i64);
+        if (g != -1)
+            push_raw(&res, &g);
+        return res;
+    }
+
+    seen = B8(AS_LIST(index)[0]->len);
+    memset(AS_B8(seen), B8_FALSE, seen->len);
+
+    for (i = 0; i < (i64_t)vals->len; i++) {
+        g = grouped_find(index, AS_SYMBOL(vals)[i]);
+        if (g == -1 || AS_B8(seen)[g])
+            continue;
+
+        AS_B8(seen)[g] = B8_TRUE;
+        push_raw(&res, &g);
+    }
+
+    drop_obj(seen);
+
+    return res;
+}
+
+// Merge of two ascending rows lists having no row in common
+static obj_p grouped_merge(obj_p x, obj_p y) {
+    i64_t i, j, n, xl, yl, *xi, *yi, *out;
+    obj_p res;
+
+    xl = x->len;
+    yl = y->len;
+    xi = AS_I64(x);
+    yi = AS_I64(y);
+    res = I64(xl + yl);
+    out = AS_I64(res);
+
+    for (i = 0, j = 0, n = 0; i < xl && j < yl;)
+        out[n++] = (xi[i] < yi[j]) ? xi[i++] : yi[j++];
+    while (i < xl)
+        out[n++] = xi[i++];
+    while (j < yl)
+        out[n++] = yi[j++];
+
+    return res;
+}
+
+// Ascending rows of a column holding a symbol or any of symbols, NULL_OBJ if the column has no index
+obj_p grouped_rows(obj_p col, obj_p vals) {
+    i64_t i, n;
+    obj_p index, ids, runs, res;
+
+    if (vals->type != -TYPE_SYMBOL && vals->type != TYPE_SYMBOL)
+        return NULL_OBJ;
+
+    index = grouped_get(col);
+    if (index == NULL_OBJ)
+        return NULL_OBJ;
+
+    ids = grouped_ids(index, vals);
+    n = ids->len;
+
+    if (n == 0)
+        res = I64(0);
+    else if (n == 1)
+        res = clone_obj(AS_LIST(AS_LIST(index)[2])[AS_I64(ids)[0]]);
+    else {
+        // rows of the groups merged pairwise, rounds halve the runs left
+        runs = LIST(n);
+        for (i = 0; i < n; i++)
+            AS_LIST(runs)[i] = clone_obj(AS_LIST(AS_LIST(index)[2])[AS_I64(ids)[i]]);
+
+        while (n > 1) {
+            for (i = 0; i < n / 2; i++) {
+                res = grouped_merge(AS_LIST(runs)[2 * i], AS_LIST(runs)[2 * i + 1]);
+                drop_obj(AS_LIST(runs)[2 * i]);
+                drop_obj(AS_LIST(runs)[2 * i + 1]);
+                AS_LIST(runs)[i] = res;
+            }
+
+            if (n % 2)
+                AS_LIST(runs)[i] = AS_LIST(runs)[n - 1];
+
+            n = (n + 1) / 2;
+        }
+
+        res = AS_LIST(runs)[0];
+        runs->len = 0;
+        drop_obj(runs);
+    }
+
+    drop_obj(ids);
+    drop_obj(index);
+    res->attrs |= ATTR_ASC | ATTR_DISTINCT;
+
+    return res;
+}
+
+// Fill a mask of a column with hit where it holds any of vals and !hit elsewhere, B8_FALSE if it has no index
+b8_t grouped_mask(obj_p col, obj_p vals, b8_t hit, obj_p res) {
+    i64_t i, j, l, *rows;
+    obj_p index, ids, v;
+
+    if (vals->type != -TYPE_SYMBOL && vals->type != TYPE_SYMBOL)
+        return B8_FALSE;
+
+    if (res->type != TYPE_B8 || (i64_t)res->len != ops_count(col))
+        return B8_FALSE;
+
+    index = grouped_get(col);
+    if (index == NULL_OBJ)
+        return B8_FALSE;
+
+    // the order rows get set in does not matter here
+    ids = grouped_ids(index, vals);
+    memset(AS_B8(res), !hit, res->len);
+
+    for (i = 0; i < (i64_t)ids->len; i++) {
+        v = AS_LIST(AS_LIST(index)[2])[AS_I64(ids)[i]];
+        l = v->len;
+        rows = AS_I64(v);
+        for (j = 0; j < l; j++)
+            AS_B8(res)[rows[j]] = hit;
+    }
+
+    drop_obj(ids);
+    drop_obj(index);
+
+    return B8_TRUE;
+}
+
+/*
+ * Group index (as index_group builds) of a column out of its group index, NULL_OBJ if it has none.
+ * Groups of filtered rows are numbered again in order of appearance, the same way grouping them anew does.
+ */
+obj_p grouped_group(obj_p col, obj_p filter) {
+    i64_t i, l, n, g, *ids, *map, *out, *rows;
+    obj_p index, res, m, o;
+
+    index = grouped_get(col);
+    if (index == NULL_OBJ)
+        return NULL_OBJ;
+
+    n = AS_LIST(index)[0]->len;
+
+    if (is_null(filter))
+        res = index_group_from_ids(n, clone_obj(AS_LIST(index)[1]), NULL_OBJ, 0);
+    else if (filter->type == TYPE_I64) {
+        l = filter->len;
+        rows = AS_I64(filter);
+        ids = AS_I64(AS_LIST(index)[1]);
+        m = I64(n);
+        map = AS_I64(m);
+        o = I64(l);
+        out = AS_I64(o);
+
+        for (i = 0; i < n; i++)
+            map[i] = -1;
+
+        for (i = 0, g = 0; i < l; i++) {
+            if (map[ids[rows[i]]] == -1)
+                map[ids[rows[i]]] = g++;
+            out[i] = map[ids[rows[i]]];
+        }
+
+        drop_obj(m);
+        res = index_group_from_ids(g, o, clone_obj(filter), 0);
+    } else
+        res = NULL_OBJ;
+
+    drop_obj(index);
+
+    return res;
+}
+
+obj_p ray_grouped(obj_p x) {
+    obj_p index;
+
+    switch (x->type) {
+        case TYPE_SYMBOL:
+        case TYPE_ENUM:
+            break;
+        default:
+            THROW(ERR_TYPE, "grouped: expected 'Symbol, got '%s", type_name(x->type));
+    }
+
+    index = grouped_get(x);
+    if (index != NULL_OBJ) {
+        drop_obj(index);
+        return clone_obj(x);
+    }
+
+    index = grouped_build(x);
+    if (index == NULL_OBJ)
+        THROW(ERR_TYPE, "grouped: invalid enum");
+
+    grouped_set(x, index);
+
+    return clone_obj(x);
+}
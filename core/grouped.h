@@ -0,0 +1,42 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#ifndef GROUPED_H
+#define GROUPED_H
+
+#include "rayforce.h"
+
+obj_p grouped_build(obj_p col);
+obj_p grouped_load(obj_p saved);
+obj_p grouped_save(obj_p index);
+obj_p grouped_get(obj_p col);
+nil_t grouped_set(obj_p col, obj_p index);
+nil_t grouped_drop(obj_p col);
+obj_p grouped_take(obj_p col);
+nil_t grouped_extend(obj_p col, obj_p index, i64_t from);
+obj_p grouped_rows(obj_p col, obj_p vals);
+b8_t grouped_mask(obj_p col, obj_p vals, b8_t hit, obj_p res);
+obj_p grouped_group(obj_p col, obj_p filter);
+obj_p ray_grouped(obj_p x);
+
+#endif  // GROUPED_H
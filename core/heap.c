@@ -33,6 +33,7 @@
 #include "sys.h"
 #include "os.h"
 #include "log.h"
+#include "atomic.h"
 
 #ifndef __EMSCRIPTEN__
 RAYASSERT(sizeof(struct block_t) == (2 * sizeof(struct obj_t)), heap_h);
@@ -61,8 +62,12 @@ heap_p heap_create(i64_t id) {
     __HEAP->id = id;
     __HEAP->avail = 0;
     __HEAP->foreign_blocks = NULL;
+    __HEAP->lender = NULL;
+    __HEAP->spare_avail = 0;
+    __HEAP->spare_lock = 0;
 
     memset(__HEAP->freelist, 0, sizeof(__HEAP->freelist));
+    memset(__HEAP->spare, 0, sizeof(__HEAP->spare));
 
     if (os_get_var("HEAP_SWAP", HEAP_SWAP, sizeof(HEAP_SWAP)) == -1)
         snprintf(HEAP_SWAP, sizeof(HEAP_SWAP), "%s", DEFAULT_HEAP_SWAP);
@@ -126,6 +131,7 @@ nil_t heap_unmap(raw_p ptr, i64_t size) { mmap_free(ptr, size); }
 i64_t heap_gc(nil_t) { return 0; }
 nil_t heap_borrow(heap_p heap) { UNUSED(heap); }
 nil_t heap_merge(heap_p heap) { UNUSED(heap); }
+nil_t heap_release_foreign(heap_p heap) { UNUSED(heap); }
 memstat_t heap_memstat(nil_t) { return (memstat_t){0}; }
 
 #else
@@ -250,6 +256,36 @@ raw_p heap_stack(i64_t size) {
     return ptr;
 }
 
+// Take the smallest spare pool of at least the given order from the lender
+static block_p heap_borrow_pool(i64_t order) {
+    i64_t i, rounds = 0;
+    heap_p lender;
+    block_p block = NULL;
+
+    lender = __HEAP->lender;
+
+    if (lender == NULL || __atomic_load_n(&lender->spare_avail, __ATOMIC_ACQUIRE) == 0)
+        return NULL;
+
+    while (__atomic_exchange_n(&lender->spare_lock, 1, __ATOMIC_ACQUIRE))
+        backoff_spin(&rounds);
+
+    i = (AVAIL_MASK << (order < MAX_BLOCK_ORDER ? MAX_BLOCK_ORDER : order)) & lender->spare_avail;
+
+    if (i != 0) {
+        i = __builtin_ctzll(i);
+        block = lender->spare[i];
+        lender->spare[i] = block->next;
+
+        if (lender->spare[i] == NULL)
+            __atomic_store_n(&lender->spare_avail, lender->spare_avail & ~BSIZEOF(i), __ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n(&lender->spare_lock, 0, __ATOMIC_RELEASE);
+
+    return block;
+}
+
 raw_p __attribute__((hot)) heap_alloc(i64_t size) {
     i64_t i, order, block_size;
     block_p block;
@@ -268,7 +304,12 @@ raw_p __attribute__((hot)) heap_alloc(i64_t size) {
     // no free block found for this size, so mmap it directly if it is bigger than pool size or
     // add a new pool and split as well
     if (i == 0) {
-        if (order >= MAX_BLOCK_ORDER) {
+        block = heap_borrow_pool(order);
+
+        if (block != NULL) {
+            i = block->pool_order;
+            heap_insert_block(block, i);
+        } else if (order >= MAX_BLOCK_ORDER) {
             LOG_TRACE("Adding pool of size %lld requested size %lld", BSIZEOF(order), size);
             size = BSIZEOF(order);
             block = heap_add_pool(size);
@@ -283,15 +324,15 @@ raw_p __attribute__((hot)) heap_alloc(i64_t size) {
             __HEAP->memstat.system += size;
 
             return BLOCK2RAW(block);
-        }
+        } else {
+            block = heap_add_pool(BSIZEOF(MAX_BLOCK_ORDER));
 
-        block = heap_add_pool(BSIZEOF(MAX_BLOCK_ORDER));
-
-        if (block == NULL)
-            return NULL;
+            if (block == NULL)
+                return NULL;
 
-        i = MAX_BLOCK_ORDER;
-        heap_insert_block(block, i);
+            i = MAX_BLOCK_ORDER;
+            heap_insert_block(block, i);
+        }
     } else
         i = __builtin_ctzll(i);
 
@@ -340,7 +381,8 @@ __attribute__((hot)) nil_t heap_free(raw_p ptr) {
         return;
     }
 
-    if (__HEAP->id != 0 && block->heap_id != __HEAP->id) {
+    // foreign blocks are returned to the owner on merge (main heap owns all of them outside of parallel runs)
+    if (block->heap_id != __HEAP->id && (__HEAP->id != 0 || rc_sync_get())) {
         block->next = __HEAP->foreign_blocks;
         __HEAP->foreign_blocks = block;
         return;
@@ -383,7 +425,8 @@ __attribute__((hot)) raw_p heap_realloc(raw_p ptr, i64_t new_size) {
         return ptr;
 
     // grow or block is not in the same heap
-    if (order > block->order || (__HEAP->id != 0 && block->heap_id != __HEAP->id) || block->backed) {
+    if (order > block->order || (block->heap_id != __HEAP->id && (__HEAP->id != 0 || rc_sync_get())) ||
+        block->backed) {
         new_ptr = heap_alloc(new_size);
 
         if (new_ptr == NULL) {
@@ -434,22 +477,34 @@ i64_t heap_gc(nil_t) {
     return total;
 }
 
+// Let the heap borrow whole pools of the current one on demand during a parallel run. Pools are moved to the spare
+// lists on the first call, the current heap borrows them back the same way
 nil_t heap_borrow(heap_p heap) {
     i64_t i;
+    block_p block, next;
+
+    heap->lender = __HEAP;
+
+    if (__HEAP->lender == __HEAP)
+        return;
+
+    __HEAP->lender = __HEAP;
 
     for (i = MAX_BLOCK_ORDER; i <= MAX_POOL_ORDER; i++) {
-        // Only borrow if the source heap has a freelist[i] and it has more than one node and it is the pool (not a
-        // splitted block)
-        if (__HEAP->freelist[i] == NULL || __HEAP->freelist[i]->next == NULL || __HEAP->freelist[i]->pool_order != i)
-            continue;
+        block = __HEAP->freelist[i];
 
-        heap->freelist[i] = __HEAP->freelist[i];
-        __HEAP->freelist[i] = __HEAP->freelist[i]->next;
-        __HEAP->freelist[i]->prev = NULL;
+        while (block != NULL) {
+            next = block->next;
+
+            if (block->pool_order == i) {
+                heap_remove_block(block, i);
+                block->next = __HEAP->spare[i];
+                __HEAP->spare[i] = block;
+                __HEAP->spare_avail |= BSIZEOF(i);
+            }
 
-        heap->freelist[i]->next = NULL;
-        heap->freelist[i]->prev = NULL;
-        heap->avail |= BSIZEOF(i);
+            block = next;
+        }
     }
 }
 
@@ -457,17 +512,6 @@ nil_t heap_merge(heap_p heap) {
     i64_t i;
     block_p block, last;
 
-    // First traverse foreign blocks and free them
-    block = heap->foreign_blocks;
-    while (block != NULL) {
-        last = block;
-        block = block->next;
-        last->heap_id = __HEAP->id;
-        heap_free(BLOCK2RAW(last));
-    }
-
-    heap->foreign_blocks = NULL;
-
     for (i = MIN_BLOCK_ORDER; i <= MAX_POOL_ORDER; i++) {
         block = heap->freelist[i];
         last = NULL;
@@ -491,6 +535,37 @@ nil_t heap_merge(heap_p heap) {
 
     __HEAP->avail |= heap->avail;
     heap->avail = 0;
+    heap->lender = NULL;
+
+    // take back the pools nobody borrowed
+    if (__HEAP->lender == __HEAP) {
+        for (i = MAX_BLOCK_ORDER; i <= MAX_POOL_ORDER; i++) {
+            while (__HEAP->spare[i] != NULL) {
+                block = __HEAP->spare[i];
+                __HEAP->spare[i] = block->next;
+                heap_insert_block(block, i);
+            }
+        }
+
+        __HEAP->spare_avail = 0;
+        __HEAP->lender = NULL;
+    }
+}
+
+// Free the heap's foreign blocks into the current one. Buddies may sit in any heap that took part in a parallel
+// run, so this must be called only after all of them are merged
+nil_t heap_release_foreign(heap_p heap) {
+    block_p block, last;
+
+    block = heap->foreign_blocks;
+    heap->foreign_blocks = NULL;
+
+    while (block != NULL) {
+        last = block;
+        block = block->next;
+        last->heap_id = __HEAP->id;
+        heap_free(BLOCK2RAW(last));
+    }
 }
 
 memstat_t heap_memstat(nil_t) {
@@ -62,6 +62,10 @@ typedef struct heap_t {
     i64_t avail;                           // mask of available blocks by order
     block_p foreign_blocks;                // foreign blocks (to be freed by the owner)
     block_p backed_blocks;                 // backed blocks (to be unmapped)
+    struct heap_t *lender;                 // heap to borrow whole pools from during a parallel run
+    block_p spare[MAX_POOL_ORDER + 2];     // whole pools lent to the other heaps by order
+    i64_t spare_avail;                     // mask of spare pools by order
+    i64_t spare_lock;                      // guards spare pools
     memstat_t memstat;
 } *heap_p;
 
@@ -77,6 +81,7 @@ nil_t heap_unmap(raw_p ptr, i64_t size);
 i64_t heap_gc(nil_t);
 nil_t heap_borrow(heap_p heap);
 nil_t heap_merge(heap_p heap);
+nil_t heap_release_foreign(heap_p heap);
 memstat_t heap_memstat(nil_t);
 nil_t heap_print_blocks(heap_p heap);
 
@@ -36,6 +36,20 @@
 
 const i64_t MAX_RANGE = 1 << 20;
 
+#define RADIX_TASK_PARTITIONS 4  // Partitions per task, to even out skewed keys
+
+// Partitions take the high bits of a remixed hash, so they don't correlate with slots of per partition tables
+#define RADIX_PARTITION(hash, bits) ((i64_t)(((u64_t)(hash) * 0x9e3779b97f4a7c15ull) >> (64 - (bits))))
+
+static i64_t index_radix_bits(i64_t tasks) {
+    i64_t bits;
+
+    for (bits = 0; (1ll << bits) < tasks * RADIX_TASK_PARTITIONS; bits++)
+        ;
+
+    return bits;
+}
+
 u64_t __hash_get(i64_t row, raw_p seed) {
     __index_find_ctx_t* ctx = (__index_find_ctx_t*)seed;
     return ctx->hashes[row];
@@ -168,6 +182,17 @@ obj_p index_hash_obj_partial(obj_p obj, i64_t out[], i64_t filter[], i64_t len,
                 for (i = offset; i < len + offset; i++)
                     out[i] = hash_index_u64(hash_index_obj(l64v[i]), out[i]);
             break;
+        case TYPE_STRINGS:
+            u64v = STRINGS_OFFS(obj);
+            if (filter)
+                for (i = offset; i < len + offset; i++)
+                    out[i] = hash_index_u64(str_hash(STRINGS_DATA(obj) + u64v[filter[i]],
+                                                     u64v[filter[i] + 1] - u64v[filter[i]]),
+                                            out[i]);
+            else
+                for (i = offset; i < len + offset; i++)
+                    out[i] = hash_index_u64(str_hash(STRINGS_DATA(obj) + u64v[i], u64v[i + 1] - u64v[i]), out[i]);
+            break;
         case TYPE_ENUM:
             if (resolve) {
                 k = ray_key(obj);
@@ -593,6 +618,49 @@ obj_p index_distinct_guid(guid_t values[], i64_t len) {
     return vec;
 }
 
+// String vectors are hashed by row ids, the rows are resolved through the vector passed as a seed
+static u64_t hash_strings_row(i64_t a, raw_p seed) {
+    obj_p x = (obj_p)seed;
+    i64_t* offs = STRINGS_OFFS(x);
+
+    return str_hash(STRINGS_DATA(x) + offs[a], offs[a + 1] - offs[a]);
+}
+
+static i64_t hash_cmp_strings_row(i64_t a, i64_t b, raw_p seed) {
+    obj_p x = (obj_p)seed;
+    i64_t* offs = STRINGS_OFFS(x);
+
+    return str_cmp(STRINGS_DATA(x) + offs[a], offs[a + 1] - offs[a], STRINGS_DATA(x) + offs[b], offs[b + 1] - offs[b]);
+}
+
+obj_p index_distinct_strings(obj_p x) {
+    i64_t i, j, len;
+    i64_t p, *out, *ids;
+    obj_p set, rows, vec;
+
+    len = x->len;
+    set = ht_oa_create(len, -1);
+    rows = I64(len);
+    ids = AS_I64(rows);
+
+    // keep the rows in the order they are first seen
+    for (i = 0, j = 0; i < len; i++) {
+        p = ht_oa_tab_next_with(&set, i, &hash_strings_row, &hash_cmp_strings_row, x);
+        out = AS_I64(AS_LIST(set)[0]);
+        if (out[p] == NULL_I64) {
+            out[p] = i;
+            ids[j++] = i;
+        }
+    }
+
+    vec = strings_at_ids(x, ids, j);
+    vec->attrs |= ATTR_DISTINCT;
+    drop_obj(rows);
+    drop_obj(set);
+
+    return vec;
+}
+
 obj_p index_distinct_obj(obj_p values[], i64_t len) {
     i64_t i, j;
     i64_t p, *out;
@@ -1458,6 +1526,278 @@ obj_p index_find_i64(i64_t x[], i64_t xl, i64_t y[], i64_t yl) {
     return vec;
 }
 
+typedef struct __index_join_ctx_t {
+    i64_t *xhashes;   // hashes of the build side
+    i64_t *yhashes;   // hashes of the probe side
+    raw_p xseed;      // seed to hash and compare build rows with each other
+    raw_p yseed;      // seed to compare probe rows against build rows
+    hash_f hash;
+    cmp_f cmp;
+    i64_t bits;       // log2 of partitions, 0 for a single table
+    i64_t partitions;
+    i64_t *counts;    // per chunk build rows in each partition, then their write cursors
+    i64_t *starts;    // partition bounds in rows (partitions + 1)
+    i64_t *rows;      // build rows scattered by partition, in order
+    obj_p *tables;
+    i64_t *out;       // first build row for every probe row
+    i64_t *next;      // optional: next build row with the same key, chains of duplicates are kept in order
+    i64_t *dups;      // rows in a chain, kept at its first row
+    i64_t *totals;    // matches per probe chunk, then their write offsets
+    i64_t *lids;      // out: probe side of every match
+    i64_t *rids;      // out: build side of every match
+}* index_join_ctx_p;
+
+#define INDEX_JOIN_PARTITION(ctx, h) (((ctx)->bits == 0) ? 0 : RADIX_PARTITION(h, (ctx)->bits))
+
+obj_p index_join_count(index_join_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, l, *counts;
+
+    l = offset + len;
+    counts = ctx->counts + chunk * ctx->partitions;
+    memset(counts, 0, ctx->partitions * sizeof(i64_t));
+
+    for (i = offset; i < l; i++)
+        counts[INDEX_JOIN_PARTITION(ctx, ctx->xhashes[i])]++;
+
+    return NULL_OBJ;
+}
+
+obj_p index_join_scatter(index_join_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, l, *counts;
+
+    l = offset + len;
+    counts = ctx->counts + chunk * ctx->partitions;
+
+    for (i = offset; i < l; i++)
+        ctx->rows[counts[INDEX_JOIN_PARTITION(ctx, ctx->xhashes[i])]++] = i;
+
+    return NULL_OBJ;
+}
+
+obj_p index_join_build(index_join_ctx_p ctx, i64_t partition) {
+    i64_t i, l, idx, row, *keys, *tails;
+    obj_p ht;
+
+    i = ctx->starts[partition];
+    l = ctx->starts[partition + 1];
+    ht = ht_oa_create(l - i, (ctx->next != NULL) ? TYPE_I64 : -1);
+
+    // rows are in order, so the first one of equal keys wins and chains are appended at their tails
+    for (; i < l; i++) {
+        row = ctx->rows[i];
+        idx = ht_oa_tab_next_with(&ht, row, ctx->hash, ctx->cmp, ctx->xseed);
+        keys = AS_I64(AS_LIST(ht)[0]);
+
+        if (keys[idx] == NULL_I64)
+            keys[idx] = row;
+
+        if (ctx->next == NULL)
+            continue;
+
+        tails = AS_I64(AS_LIST(ht)[1]);
+        ctx->next[row] = NULL_I64;
+
+        if (keys[idx] == row) {
+            ctx->dups[row] = 1;
+        } else {
+            ctx->next[tails[idx]] = row;
+            ctx->dups[keys[idx]]++;
+        }
+
+        tails[idx] = row;
+    }
+
+    ctx->tables[partition] = ht;
+
+    return NULL_OBJ;
+}
+
+obj_p index_join_probe(index_join_ctx_p ctx, i64_t len, i64_t offset) {
+    i64_t i, l, idx;
+    obj_p ht;
+
+    l = offset + len;
+
+    for (i = offset; i < l; i++) {
+        ht = ctx->tables[INDEX_JOIN_PARTITION(ctx, ctx->yhashes[i])];
+        idx = ht_oa_tab_get_with(ht, i, ctx->hash, ctx->cmp, ctx->yseed);
+        ctx->out[i] = (idx == NULL_I64) ? NULL_I64 : AS_I64(AS_LIST(ht)[0])[idx];
+    }
+
+    return NULL_OBJ;
+}
+
+// For every probe row finds the first build row with the same key (or null) into out. Build rows are radix
+// partitioned by hash and every partition gets its own table, so both sides go in parallel, the output is in probe
+// order and doesn't depend on the number of cores
+static nil_t index_hash_join(index_join_ctx_p ctx, i64_t xl, i64_t yl) {
+    i64_t i, c, l, n, p, chunks, chunk;
+    pool_p pool;
+    obj_p cnts, rows, tables;
+
+    pool = pool_get();
+    chunks = pool_split_by(pool, MAXI64(xl, yl), 0);
+
+    if (chunks == 1) {
+        ctx->bits = 0;
+        ctx->partitions = 1;
+        tables = LIST(1);
+        ctx->tables = AS_LIST(tables);
+        ctx->starts = (i64_t[2]){0, xl};
+        rows = I64(xl);
+        ctx->rows = AS_I64(rows);
+        for (i = 0; i < xl; i++)
+            ctx->rows[i] = i;
+
+        index_join_build(ctx, 0);
+        index_join_probe(ctx, yl, 0);
+
+        drop_obj(rows);
+        drop_obj(tables);
+
+        return;
+    }
+
+    ctx->bits = index_radix_bits(chunks);
+    ctx->partitions = p = 1ll << ctx->bits;
+
+    cnts = I64(chunks * p + p + 1);
+    rows = I64(xl);
+    tables = LIST(p);
+    ctx->counts = AS_I64(cnts);
+    ctx->starts = ctx->counts + chunks * p;
+    ctx->rows = AS_I64(rows);
+    ctx->tables = AS_LIST(tables);
+    for (i = 0; i < p; i++)
+        ctx->tables[i] = NULL_OBJ;
+
+    chunk = xl / chunks;
+
+    pool_prepare(pool);
+    for (c = 0; c < chunks - 1; c++)
+        pool_add_task(pool, (raw_p)index_join_count, 4, ctx, c, chunk, c * chunk);
+    pool_add_task(pool, (raw_p)index_join_count, 4, ctx, c, xl - c * chunk, c * chunk);
+    drop_obj(pool_run(pool));
+
+    for (i = 0, n = 0; i < p; i++) {
+        ctx->starts[i] = n;
+        for (c = 0; c < chunks; c++) {
+            l = ctx->counts[c * p + i];
+            ctx->counts[c * p + i] = n;
+            n += l;
+        }
+    }
+    ctx->starts[p] = n;
+
+    pool_prepare(pool);
+    for (c = 0; c < chunks - 1; c++)
+        pool_add_task(pool, (raw_p)index_join_scatter, 4, ctx, c, chunk, c * chunk);
+    pool_add_task(pool, (raw_p)index_join_scatter, 4, ctx, c, xl - c * chunk, c * chunk);
+    drop_obj(pool_run(pool));
+
+    pool_prepare(pool);
+    for (i = 0; i < p; i++)
+        pool_add_task(pool, (raw_p)index_join_build, 2, ctx, i);
+    drop_obj(pool_run(pool));
+
+    chunk = yl / chunks;
+
+    pool_prepare(pool);
+    for (c = 0; c < chunks - 1; c++)
+        pool_add_task(pool, (raw_p)index_join_probe, 3, ctx, chunk, c * chunk);
+    pool_add_task(pool, (raw_p)index_join_probe, 3, ctx, yl - c * chunk, c * chunk);
+    drop_obj(pool_run(pool));
+
+    drop_obj(cnts);
+    drop_obj(rows);
+    drop_obj(tables);
+}
+
+obj_p index_join_count_matches(index_join_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, l, n, *out;
+
+    l = offset + len;
+    out = ctx->out;
+
+    for (i = offset, n = 0; i < l; i++) {
+        if (out[i] != NULL_I64)
+            n += ctx->dups[out[i]];
+    }
+
+    ctx->totals[chunk] = n;
+
+    return NULL_OBJ;
+}
+
+obj_p index_join_expand(index_join_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, j, l, r, *out, *next, *lids, *rids;
+
+    l = offset + len;
+    j = ctx->totals[chunk];
+    out = ctx->out;
+    next = ctx->next;
+    lids = ctx->lids;
+    rids = ctx->rids;
+
+    for (i = offset; i < l; i++) {
+        for (r = out[i]; r != NULL_I64; r = next[r]) {
+            lids[j] = i;
+            rids[j++] = r;
+        }
+    }
+
+    return NULL_OBJ;
+}
+
+// Expands matches of index_hash_join (built with chains) into (probe ids, build ids) pairs, ordered by probe row
+// and then by build row
+static obj_p index_hash_join_pairs(index_join_ctx_p ctx, i64_t yl) {
+    i64_t i, c, n, chunks, chunk;
+    pool_p pool;
+    obj_p totals, lids, rids;
+
+    pool = pool_get();
+    chunks = pool_split_by(pool, yl, 0);
+    chunk = yl / chunks;
+    totals = I64(chunks);
+    ctx->totals = AS_I64(totals);
+
+    if (chunks == 1) {
+        index_join_count_matches(ctx, 0, yl, 0);
+    } else {
+        pool_prepare(pool);
+        for (c = 0; c < chunks - 1; c++)
+            pool_add_task(pool, (raw_p)index_join_count_matches, 4, ctx, c, chunk, c * chunk);
+        pool_add_task(pool, (raw_p)index_join_count_matches, 4, ctx, c, yl - c * chunk, c * chunk);
+        drop_obj(pool_run(pool));
+    }
+
+    for (i = 0, n = 0; i < chunks; i++) {
+        c = ctx->totals[i];
+        ctx->totals[i] = n;
+        n += c;
+    }
+
+    lids = I64(n);
+    rids = I64(n);
+    ctx->lids = AS_I64(lids);
+    ctx->rids = AS_I64(rids);
+
+    if (chunks == 1) {
+        index_join_expand(ctx, 0, yl, 0);
+    } else {
+        pool_prepare(pool);
+        for (c = 0; c < chunks - 1; c++)
+            pool_add_task(pool, (raw_p)index_join_expand, 4, ctx, c, chunk, c * chunk);
+        pool_add_task(pool, (raw_p)index_join_expand, 4, ctx, c, yl - c * chunk, c * chunk);
+        drop_obj(pool_run(pool));
+    }
+
+    drop_obj(totals);
+
+    return vn_list(2, lids, rids);
+}
+
 obj_p index_find_guid(guid_t x[], i64_t xl, guid_t y[], i64_t yl) {
     i64_t i, *hashes;
     obj_p ht, res;
@@ -1496,38 +1836,36 @@ obj_p index_find_guid(guid_t x[], i64_t xl, guid_t y[], i64_t yl) {
 }
 
 obj_p index_find_obj(obj_p x[], i64_t xl, obj_p y[], i64_t yl) {
-    i64_t i, *hashes;
-    obj_p ht, res;
-    i64_t idx;
-    __index_find_ctx_t ctx;
+    i64_t i;
+    obj_p xh, yh, res;
+    __index_find_ctx_t xctx, yctx;
+    struct __index_join_ctx_t jctx;
 
     // calc hashes
-    res = I64(MAXI64(xl, yl));
-    ht = ht_oa_create(MAXI64(xl, yl) * 2, -1);
-
-    hashes = (i64_t*)AS_I64(res);
+    xh = I64(xl);
+    yh = I64(yl);
 
     for (i = 0; i < xl; i++)
-        hashes[i] = hash_index_u64(hash_index_obj(x[i]), 0xa5b6c7d8e9f01234ull);
-
-    ctx = (__index_find_ctx_t){.lobj = x, .robj = x, .hashes = hashes};
-    for (i = 0; i < xl; i++) {
-        idx = ht_oa_tab_next_with(&ht, i, &__hash_get, &__cmp_obj, &ctx);
-        if (AS_I64(AS_LIST(ht)[0])[idx] == NULL_I64)
-            AS_I64(AS_LIST(ht)[0])[idx] = i;
-    }
+        AS_I64(xh)[i] = hash_index_u64(hash_index_obj(x[i]), 0xa5b6c7d8e9f01234ull);
 
     for (i = 0; i < yl; i++)
-        hashes[i] = hash_index_u64(hash_index_obj(y[i]), 0xa5b6c7d8e9f01234ull);
+        AS_I64(yh)[i] = hash_index_u64(hash_index_obj(y[i]), 0xa5b6c7d8e9f01234ull);
 
-    ctx = (__index_find_ctx_t){.lobj = x, .robj = y, .hashes = hashes};
-    for (i = 0; i < yl; i++) {
-        idx = ht_oa_tab_get_with(ht, i, &__hash_get, &__cmp_obj, &ctx);
-        AS_I64(res)[i] = (idx == NULL_I64) ? NULL_I64 : AS_I64(AS_LIST(ht)[0])[idx];
-    }
+    res = I64(yl);
 
-    drop_obj(ht);
-    resize_obj(&res, yl);
+    xctx = (__index_find_ctx_t){.lobj = x, .robj = x, .hashes = AS_I64(xh)};
+    yctx = (__index_find_ctx_t){.lobj = x, .robj = y, .hashes = AS_I64(yh)};
+    jctx = (struct __index_join_ctx_t){.xhashes = AS_I64(xh),
+                                       .yhashes = AS_I64(yh),
+                                       .xseed = &xctx,
+                                       .yseed = &yctx,
+                                       .hash = &__hash_get,
+                                       .cmp = &__cmp_obj,
+                                       .out = AS_I64(res)};
+    index_hash_join(&jctx, xl, yl);
+
+    drop_obj(xh);
+    drop_obj(yh);
 
     return res;
 }
@@ -1571,80 +1909,151 @@ i64_t index_group_shift(obj_p index) { return AS_LIST(index)[3]->i64; }
 
 obj_p index_group_meta(obj_p index) { return AS_LIST(index)[6]; }
 
+i64_t index_group_base(obj_p index) {
+    if (index_group_type(index) == INDEX_TYPE_IDS && AS_LIST(index)[6] != NULL_OBJ)
+        return AS_LIST(index)[6]->i64;
+
+    return 0;
+}
+
 static obj_p index_group_build(index_type_t tp, i64_t groups_count, obj_p group_ids, obj_p index_min, obj_p source,
                                obj_p filter, obj_p meta) {
     return vn_list(7, i64(tp), i64(groups_count), group_ids, index_min, source, filter, meta);
 }
 
+// Group ids of a partition are local: base is the global id of its first group
+obj_p index_group_from_ids(i64_t groups_count, obj_p group_ids, obj_p filter, i64_t base) {
+    return index_group_build(INDEX_TYPE_IDS, groups_count, group_ids, i64(NULL_I64), NULL_OBJ, filter, i64(base));
+}
+
 typedef struct __group_radix_part_ctx_t {
+    i64_t *keys;
+    i64_t *filter;
+    i64_t *out;
+    hash_f hash;
+    cmp_f cmp;
+    i64_t chunks;
     i64_t partitions;
-    i64_t partition;
+    i64_t bits;       // log2 of partitions
+    i64_t *counts;    // per chunk rows in each partition, then their write cursors
+    i64_t *starts;    // partition bounds in pkeys/prows (partitions + 1)
+    i64_t *groups;    // groups found per partition, then their first global id
+    i64_t *pkeys;     // keys scattered by partition
+    i64_t *prows;     // positions of pkeys in out
 }* group_radix_part_ctx_p;
 
-obj_p index_group_distribute_partial(group_radix_part_ctx_p ctx, i64_t* groups, i64_t keys[], i64_t filter[],
-                                     i64_t out[], i64_t len, hash_f hash, cmp_f cmp) {
-    i64_t i, partition_id, partitions, size, partition;
-    i64_t *k, *v, n, idx;
-    obj_p ht;
-
-    partitions = ctx->partitions;
-    partition = ctx->partition;
+obj_p index_group_distribute_count(group_radix_part_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, l, p, *keys, *filter, *out, *counts;
 
-    size = (partition + 1 < partitions) ? (len / partitions) : (len - (len / partitions) * partition);
-    ht = ht_oa_create(size, TYPE_I64);
+    l = offset + len;
+    keys = ctx->keys;
+    filter = ctx->filter;
+    out = ctx->out;
+    counts = ctx->counts + chunk * ctx->partitions;
+    memset(counts, 0, ctx->partitions * sizeof(i64_t));
 
+    // out keeps the partition of each row until the groups are known
     if (filter) {
-        for (i = 0; i < len; i++) {
-            n = keys[filter[i]];
+        for (i = offset; i < l; i++) {
+            p = RADIX_PARTITION(ctx->hash(keys[filter[i]], NULL), ctx->bits);
+            out[i] = p;
+            counts[p]++;
+        }
+    } else {
+        for (i = offset; i < l; i++) {
+            p = RADIX_PARTITION(ctx->hash(keys[i], NULL), ctx->bits);
+            out[i] = p;
+            counts[p]++;
+        }
+    }
 
-            // determine if the key is ours due to radix partitioning
-            partition_id = n % partitions;
-            if (partition_id != partition)
-                continue;
+    return NULL_OBJ;
+}
 
-            idx = ht_oa_tab_next_with(&ht, n, hash, cmp, NULL);
-            k = AS_I64(AS_LIST(ht)[0]);
-            v = AS_I64(AS_LIST(ht)[1]);
+obj_p index_group_distribute_scatter(group_radix_part_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, j, l, *keys, *filter, *out, *counts, *pkeys, *prows;
 
-            if (k[idx] == NULL_I64) {
-                k[idx] = n;
-                v[idx] = __atomic_fetch_add(groups, 1, __ATOMIC_RELAXED);
-            }
+    l = offset + len;
+    keys = ctx->keys;
+    filter = ctx->filter;
+    out = ctx->out;
+    pkeys = ctx->pkeys;
+    prows = ctx->prows;
+    counts = ctx->counts + chunk * ctx->partitions;
 
-            out[i] = v[idx];
+    if (filter) {
+        for (i = offset; i < l; i++) {
+            j = counts[out[i]]++;
+            pkeys[j] = keys[filter[i]];
+            prows[j] = i;
         }
     } else {
-        for (i = 0; i < len; i++) {
-            n = keys[i];
+        for (i = offset; i < l; i++) {
+            j = counts[out[i]]++;
+            pkeys[j] = keys[i];
+            prows[j] = i;
+        }
+    }
 
-            // determine if the key is ours due to radix partitioning
-            partition_id = n % partitions;
-            if (partition_id != partition)
-                continue;
+    return NULL_OBJ;
+}
 
-            idx = ht_oa_tab_next_with(&ht, n, hash, cmp, NULL);
-            k = AS_I64(AS_LIST(ht)[0]);
-            v = AS_I64(AS_LIST(ht)[1]);
+obj_p index_group_distribute_partial(group_radix_part_ctx_p ctx, i64_t partition) {
+    i64_t i, l, n, idx, groups, *k, *v, *pkeys, *prows, *out;
+    obj_p ht;
 
-            if (k[idx] == NULL_I64) {
-                k[idx] = n;
-                v[idx] = __atomic_fetch_add(groups, 1, __ATOMIC_RELAXED);
-            }
+    i = ctx->starts[partition];
+    l = ctx->starts[partition + 1];
+    pkeys = ctx->pkeys;
+    prows = ctx->prows;
+    out = ctx->out;
+    groups = 0;
+
+    ht = ht_oa_create(l - i, TYPE_I64);
+
+    for (; i < l; i++) {
+        n = pkeys[i];
+        idx = ht_oa_tab_next_with(&ht, n, ctx->hash, ctx->cmp, NULL);
+        k = AS_I64(AS_LIST(ht)[0]);
+        v = AS_I64(AS_LIST(ht)[1]);
 
-            out[i] = v[idx];
+        if (k[idx] == NULL_I64) {
+            k[idx] = n;
+            v[idx] = groups++;
         }
+
+        out[prows[i]] = v[idx];
     }
 
     drop_obj(ht);
+    ctx->groups[partition] = groups;
+
+    return NULL_OBJ;
+}
+
+obj_p index_group_distribute_rebase(group_radix_part_ctx_p ctx, i64_t partition) {
+    i64_t i, l, base, *prows, *out;
+
+    base = ctx->groups[partition];
+    if (base == 0)
+        return NULL_OBJ;
+
+    l = ctx->starts[partition + 1];
+    prows = ctx->prows;
+    out = ctx->out;
+
+    for (i = ctx->starts[partition]; i < l; i++)
+        out[prows[i]] += base;
 
     return NULL_OBJ;
 }
 
 i64_t index_group_distribute(i64_t keys[], i64_t filter[], i64_t out[], i64_t len, hash_f hash, cmp_f cmp) {
-    i64_t i, parts, groups;
+    i64_t i, c, l, p, parts, groups, chunk;
     i64_t idx, n, *k, *v;
     pool_p pool;
-    obj_p ht, res;
+    obj_p ht, cnts, pkeys, prows;
+    struct __group_radix_part_ctx_t ctx;
 
     pool = pool_get();
     parts = pool_split_by(pool, len, 0);
@@ -1688,18 +2097,71 @@ i64_t index_group_distribute(i64_t keys[], i64_t filter[], i64_t out[], i64_t le
         return groups;
     }
 
-    struct __group_radix_part_ctx_t ctx[parts];
+    // Two phases, so that every key is read by one task only: rows are scattered into hash partitions (stable,
+    // so ids are still given in order of appearance within a partition), then each partition is grouped on its own
+    ctx.keys = keys;
+    ctx.filter = filter;
+    ctx.out = out;
+    ctx.hash = hash;
+    ctx.cmp = cmp;
+    ctx.chunks = parts;
+    ctx.bits = index_radix_bits(parts);
+    ctx.partitions = 1ll << ctx.bits;
+
+    p = ctx.partitions;
+    cnts = I64(parts * p + 2 * p + 1);
+    pkeys = I64(len);
+    prows = I64(len);
+    ctx.counts = AS_I64(cnts);
+    ctx.starts = ctx.counts + parts * p;
+    ctx.groups = ctx.starts + p + 1;
+    ctx.pkeys = AS_I64(pkeys);
+    ctx.prows = AS_I64(prows);
+
+    chunk = len / parts;
 
     pool_prepare(pool);
-    for (i = 0; i < parts; i++) {
-        ctx[i].partitions = parts;
-        ctx[i].partition = i;
-        pool_add_task(pool, (raw_p)index_group_distribute_partial, 8, &ctx[i], &groups, keys, filter, out, len, hash,
-                      cmp);
+    for (c = 0; c < parts - 1; c++)
+        pool_add_task(pool, (raw_p)index_group_distribute_count, 4, &ctx, c, chunk, c * chunk);
+    pool_add_task(pool, (raw_p)index_group_distribute_count, 4, &ctx, c, len - c * chunk, c * chunk);
+    drop_obj(pool_run(pool));
+
+    for (i = 0, n = 0; i < p; i++) {
+        ctx.starts[i] = n;
+        for (c = 0; c < parts; c++) {
+            l = ctx.counts[c * p + i];
+            ctx.counts[c * p + i] = n;
+            n += l;
+        }
     }
+    ctx.starts[p] = n;
+
+    pool_prepare(pool);
+    for (c = 0; c < parts - 1; c++)
+        pool_add_task(pool, (raw_p)index_group_distribute_scatter, 4, &ctx, c, chunk, c * chunk);
+    pool_add_task(pool, (raw_p)index_group_distribute_scatter, 4, &ctx, c, len - c * chunk, c * chunk);
+    drop_obj(pool_run(pool));
 
-    res = pool_run(pool);
-    drop_obj(res);
+    pool_prepare(pool);
+    for (i = 0; i < p; i++)
+        pool_add_task(pool, (raw_p)index_group_distribute_partial, 2, &ctx, i);
+    drop_obj(pool_run(pool));
+
+    // partition ids become global ones: partitions follow each other
+    for (i = 0; i < p; i++) {
+        n = ctx.groups[i];
+        ctx.groups[i] = groups;
+        groups += n;
+    }
+
+    pool_prepare(pool);
+    for (i = 0; i < p; i++)
+        pool_add_task(pool, (raw_p)index_group_distribute_rebase, 2, &ctx, i);
+    drop_obj(pool_run(pool));
+
+    drop_obj(cnts);
+    drop_obj(pkeys);
+    drop_obj(prows);
 
     return groups;
 }
@@ -1914,6 +2376,37 @@ obj_p index_group_guid(obj_p obj, obj_p filter) {
     return index_group_build(INDEX_TYPE_IDS, j, vals, i64(NULL_I64), NULL_OBJ, clone_obj(filter), NULL_OBJ);
 }
 
+obj_p index_group_strings(obj_p obj, obj_p filter) {
+    i64_t i, j, len, row;
+    i64_t idx, *hk, *hv, *hp, *indices;
+    obj_p vals, ht;
+
+    indices = is_null(filter) ? NULL : AS_I64(filter);
+    len = indices ? filter->len : obj->len;
+
+    ht = ht_oa_create(len, TYPE_I64);
+    vals = I64(len);
+    hp = AS_I64(vals);
+
+    // distribute bins
+    for (i = 0, j = 0; i < len; i++) {
+        row = indices ? indices[i] : i;
+        idx = ht_oa_tab_next_with(&ht, row, &hash_strings_row, &hash_cmp_strings_row, obj);
+        hk = AS_I64(AS_LIST(ht)[0]);
+        hv = AS_I64(AS_LIST(ht)[1]);
+        if (hk[idx] == NULL_I64) {
+            hk[idx] = row;
+            hv[idx] = j++;
+        }
+
+        hp[i] = hv[idx];
+    }
+
+    drop_obj(ht);
+
+    return index_group_build(INDEX_TYPE_IDS, j, vals, i64(NULL_I64), NULL_OBJ, clone_obj(filter), NULL_OBJ);
+}
+
 obj_p index_group_obj(obj_p obj, obj_p filter) {
     i64_t g, len;
     i64_t *out, *indices, *values;
@@ -1944,10 +2437,30 @@ obj_p index_group(obj_p val, obj_p filter) {
         case TYPE_SYMBOL:
         case TYPE_TIMESTAMP:
             return index_group_i64(val, filter);
+        case TYPE_I16:
+            l = val->len;
+            v = I64(l);
+            for (i = 0; i < l; i++)
+                AS_I64(v)[i] = AS_I16(val)[i];
+            bins = index_group_i64(v, filter);
+            drop_obj(v);
+            return bins;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            l = val->len;
+            v = I64(l);
+            for (i = 0; i < l; i++)
+                AS_I64(v)[i] = AS_I32(val)[i];
+            bins = index_group_i64(v, filter);
+            drop_obj(v);
+            return bins;
         case TYPE_F64:
             return index_group_f64(val, filter);
         case TYPE_GUID:
             return index_group_guid(val, filter);
+        case TYPE_STRINGS:
+            return index_group_strings(val, filter);
         case TYPE_ENUM:
             return index_group_i64(ENUM_VAL(val), filter);
         case TYPE_LIST:
@@ -2164,103 +2677,110 @@ obj_p index_group_list(obj_p obj, obj_p filter) {
     return index_group_build(INDEX_TYPE_IDS, g, res, i64(NULL_I64), NULL_OBJ, clone_obj(filter), NULL_OBJ);
 }
 
-obj_p index_left_join_obj(obj_p lcols, obj_p rcols, i64_t len) {
-    i64_t i, ll, rl;
-    obj_p ht, ids, hashes;
-    i64_t idx;
-    __index_list_ctx_t ctx;
-
-    // one column join
-    if (len == 1)
-        return ray_find(rcols, lcols);
+// First right row for every left row on multiple key columns
+static obj_p index_join_ids(obj_p lcols, obj_p rcols, i64_t len) {
+    i64_t ll, rl;
+    obj_p lh, rh, ids;
+    __index_list_ctx_t rctx, lctx;
+    struct __index_join_ctx_t jctx;
 
-    // multiple columns join
     ll = ops_count(AS_LIST(lcols)[0]);
     rl = ops_count(AS_LIST(rcols)[0]);
-    ht = ht_oa_create(rl, -1);
-    hashes = I64(MAXI64(ll, rl));
-
-    // Right hashes
-    __index_list_precalc_hash(rcols, (i64_t*)AS_I64(hashes), len, rl, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, rcols, (i64_t*)AS_I64(hashes), NULL};
-    for (i = 0; i < rl; i++) {
-        idx = ht_oa_tab_next_with(&ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
-        if (AS_I64(AS_LIST(ht)[0])[idx] == NULL_I64)
-            AS_I64(AS_LIST(ht)[0])[idx] = i;
-    }
-
+    lh = I64(ll);
+    rh = I64(rl);
     ids = I64(ll);
 
-    // Left hashes
-    __index_list_precalc_hash(lcols, (i64_t*)AS_I64(hashes), len, ll, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, lcols, (i64_t*)AS_I64(hashes), NULL};
-    for (i = 0; i < ll; ++i) {
-        idx = ht_oa_tab_get_with(ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
-        if (idx != NULL_I64)
-            AS_I64(ids)[i] = AS_I64(AS_LIST(ht)[0])[idx];
-        else
-            AS_I64(ids)[i] = NULL_I64;
-    }
+    __index_list_precalc_hash(rcols, AS_I64(rh), len, rl, NULL, B8_TRUE);
+    __index_list_precalc_hash(lcols, AS_I64(lh), len, ll, NULL, B8_TRUE);
 
-    drop_obj(hashes);
-    drop_obj(ht);
+    rctx = (__index_list_ctx_t){rcols, rcols, AS_I64(rh), NULL};
+    lctx = (__index_list_ctx_t){rcols, lcols, AS_I64(lh), NULL};
+    jctx = (struct __index_join_ctx_t){.xhashes = AS_I64(rh),
+                                       .yhashes = AS_I64(lh),
+                                       .xseed = &rctx,
+                                       .yseed = &lctx,
+                                       .hash = &__index_list_hash_get,
+                                       .cmp = &__index_list_cmp_row,
+                                       .out = AS_I64(ids)};
+    index_hash_join(&jctx, rl, ll);
+
+    drop_obj(lh);
+    drop_obj(rh);
 
     return ids;
 }
 
-obj_p index_inner_join_obj(obj_p lcols, obj_p rcols, i64_t len) {
-    i64_t i, j, ll, rl;
-    obj_p ht, lids, rids;
-    i64_t idx;
-    __index_list_ctx_t ctx;
+obj_p index_left_join_obj(obj_p lcols, obj_p rcols, i64_t len) {
+    // one column join
+    if (len == 1)
+        return ray_find(rcols, lcols);
 
-    if (len == 1) {
-        lids = ray_find(rcols, lcols);
-        if (IS_ERR(lids))
-            return lids;
-        return vn_list(2, clone_obj(lids), lids);
-    }
+    // multiple columns join
+    return index_join_ids(lcols, rcols, len);
+}
+
+static obj_p index_inner_join_cols(obj_p lcols, obj_p rcols, i64_t len) {
+    i64_t ll, rl;
+    obj_p lh, rh, heads, next, dups, res;
+    __index_list_ctx_t rctx, lctx;
+    struct __index_join_ctx_t jctx;
 
     ll = ops_count(AS_LIST(lcols)[0]);
     rl = ops_count(AS_LIST(rcols)[0]);
-    ht = ht_oa_create(rl, -1);
-    rids = I64(MAXI64(ll, rl));
-
-    // Right hashes
-    __index_list_precalc_hash(rcols, (i64_t*)AS_I64(rids), len, rl, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, rcols, (i64_t*)AS_I64(rids), NULL};
-    for (i = 0; i < rl; i++) {
-        idx = ht_oa_tab_next_with(&ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
-        if (AS_I64(AS_LIST(ht)[0])[idx] == NULL_I64)
-            AS_I64(AS_LIST(ht)[0])[idx] = i;
-    }
+    lh = I64(ll);
+    rh = I64(rl);
+    heads = I64(ll);
+    next = I64(rl);
+    dups = I64(rl);
+
+    __index_list_precalc_hash(rcols, AS_I64(rh), len, rl, NULL, B8_TRUE);
+    __index_list_precalc_hash(lcols, AS_I64(lh), len, ll, NULL, B8_TRUE);
+
+    rctx = (__index_list_ctx_t){rcols, rcols, AS_I64(rh), NULL};
+    lctx = (__index_list_ctx_t){rcols, lcols, AS_I64(lh), NULL};
+    jctx = (struct __index_join_ctx_t){.xhashes = AS_I64(rh),
+                                       .yhashes = AS_I64(lh),
+                                       .xseed = &rctx,
+                                       .yseed = &lctx,
+                                       .hash = &__index_list_hash_get,
+                                       .cmp = &__index_list_cmp_row,
+                                       .out = AS_I64(heads),
+                                       .next = AS_I64(next),
+                                       .dups = AS_I64(dups)};
+    index_hash_join(&jctx, rl, ll);
+
+    drop_obj(lh);
+    drop_obj(rh);
+
+    res = index_hash_join_pairs(&jctx, ll);
+
+    drop_obj(heads);
+    drop_obj(next);
+    drop_obj(dups);
 
-    lids = I64(ll);
+    return res;
+}
 
-    // Left hashes
-    __index_list_precalc_hash(lcols, (i64_t*)AS_I64(rids), len, ll, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, lcols, (i64_t*)AS_I64(rids), NULL};
-    for (i = 0, j = 0; i < ll; i++) {
-        idx = ht_oa_tab_get_with(ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
-        if (idx != NULL_I64) {
-            AS_I64(rids)[j] = AS_I64(AS_LIST(ht)[0])[idx];
-            AS_I64(lids)[j++] = i;
-        }
-    }
+// Every pair of matching rows, so keys repeated on both sides fan out
+obj_p index_inner_join_obj(obj_p lcols, obj_p rcols, i64_t len) {
+    obj_p l, r, res;
 
-    drop_obj(ht);
+    if (len > 1)
+        return index_inner_join_cols(lcols, rcols, len);
 
-    resize_obj(&lids, j);
-    resize_obj(&rids, j);
+    // one column join gets the column itself
+    l = vn_list(1, clone_obj(lcols));
+    r = vn_list(1, clone_obj(rcols));
+    res = index_inner_join_cols(l, r, len);
+    drop_obj(l);
+    drop_obj(r);
 
-    return vn_list(2, lids, rids);
+    return res;
 }
 
 obj_p index_upsert_obj(obj_p lcols, obj_p rcols, i64_t len) {
-    u64_t i, ll, rl;
-    obj_p ht, res;
+    obj_p res;
     i64_t idx;
-    __index_list_ctx_t ctx;
 
     if (len == 1) {
         res = ray_find(rcols, lcols);
@@ -2274,31 +2794,7 @@ obj_p index_upsert_obj(obj_p lcols, obj_p rcols, i64_t len) {
         return res;
     }
 
-    ll = ops_count(AS_LIST(lcols)[0]);
-    rl = ops_count(AS_LIST(rcols)[0]);
-    ht = ht_oa_create(MAXU64(ll, rl), -1);
-    res = I64(MAXU64(ll, rl));
-
-    // Right hashes
-    __index_list_precalc_hash(rcols, AS_I64(res), len, rl, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, rcols, AS_I64(res), NULL};
-    for (i = 0; i < rl; i++) {
-        idx = ht_oa_tab_next_with(&ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
-        if (AS_I64(AS_LIST(ht)[0])[idx] == NULL_I64)
-            AS_I64(AS_LIST(ht)[0])[idx] = i;
-    }
-
-    // Left hashes
-    __index_list_precalc_hash(lcols, AS_I64(res), len, ll, NULL, B8_TRUE);
-    ctx = (__index_list_ctx_t){rcols, lcols, AS_I64(res), NULL};
-    for (i = 0; i < ll; i++) {
-        idx = ht_oa_tab_get_with(ht, i, &__index_list_hash_get, &__index_list_cmp_row, &ctx);
-        AS_I64(res)[i] = (idx == NULL_I64) ? NULL_I64 : AS_I64(AS_LIST(ht)[0])[idx];
-    }
-
-    drop_obj(ht);
-
-    return res;
+    return index_join_ids(lcols, rcols, len);
 }
 
 i64_t index_bin_u8(u8_t val, u8_t vals[], i64_t ids[], i64_t len) {
@@ -2314,7 +2810,7 @@ i64_t index_bin_u8(u8_t val, u8_t vals[], i64_t ids[], i64_t len) {
         }
     }
 
-    return ids[idx];
+    return (idx == NULL_I64) ? NULL_I64 : ids[idx];
 }
 
 i64_t index_bin_i16(i16_t val, i16_t vals[], i64_t ids[], i64_t len) {
@@ -2330,7 +2826,7 @@ i64_t index_bin_i16(i16_t val, i16_t vals[], i64_t ids[], i64_t len) {
         }
     }
 
-    return ids[idx];
+    return (idx == NULL_I64) ? NULL_I64 : ids[idx];
 }
 
 i64_t index_bin_i32(i32_t val, i32_t vals[], i64_t ids[], i64_t len) {
@@ -2346,7 +2842,7 @@ i64_t index_bin_i32(i32_t val, i32_t vals[], i64_t ids[], i64_t len) {
         }
     }
 
-    return ids[idx];
+    return (idx == NULL_I64) ? NULL_I64 : ids[idx];
 }
 i64_t index_bin_i64(i64_t val, i64_t vals[], i64_t ids[], i64_t len) {
     i64_t left, right, mid, idx;
@@ -2361,7 +2857,7 @@ i64_t index_bin_i64(i64_t val, i64_t vals[], i64_t ids[], i64_t len) {
         }
     }
 
-    return ids[idx];
+    return (idx == NULL_I64) ? NULL_I64 : ids[idx];
 }
 
 i64_t index_bin_f64(f64_t val, f64_t vals[], i64_t ids[], i64_t len) {
@@ -2377,26 +2873,76 @@ i64_t index_bin_f64(f64_t val, f64_t vals[], i64_t ids[], i64_t len) {
         }
     }
 
-    return ids[idx];
-}
+    return (idx == NULL_I64) ? NULL_I64 : ids[idx];
+}
+
+// Last position in Ids[0..Len) whose value is <= Val, or -1 if there is none. Gallops forward from From
+// (a position already known to be <= Val, or -1), so sweeping sorted probes over a key costs O(n + m).
+#define INDEX_ASOF_SEEK(Val, Vals, Ids, From, Len)                                \
+    ({                                                                            \
+        i64_t $lo = (From), $hi, $mid, $step = 1;                                 \
+        while ($lo + $step < (Len) && (Vals)[(Ids)[$lo + $step]] <= (Val)) {      \
+            $lo += $step;                                                         \
+            $step <<= 1;                                                          \
+        }                                                                         \
+        $hi = ($lo + $step < (Len)) ? $lo + $step : (Len);                        \
+        while ($hi - $lo > 1) {                                                   \
+            $mid = $lo + ($hi - $lo) / 2;                                         \
+            if ((Vals)[(Ids)[$mid]] <= (Val))                                     \
+                $lo = $mid;                                                       \
+            else                                                                  \
+                $hi = $mid;                                                       \
+        }                                                                         \
+        $lo;                                                                      \
+    })
+
+#define ASOF_IDS_PARTIAL(Type, Ctx, Lxcol, Rxcol, Ht, Len, Offset, Ids)                              \
+    ({                                                                                               \
+        Type##_t *$lx = __AS_##Type(Lxcol), *$rx = __AS_##Type(Rxcol);                               \
+        i64_t $i, $idx, $p, $from, *$cursors = NULL;                                                 \
+        obj_p $rows, $sweep = NULL_OBJ;                                                              \
+        b8_t $sorted;                                                                                \
+        /* Attributes are not trusted here: a cheap scan tells if the chunk probes are ascending */  \
+        for ($i = Offset + 1; $i < Len + Offset && $lx[$i - 1] <= $lx[$i]; $i++)                     \
+            ;                                                                                        \
+        $sorted = $i >= Len + Offset;                                                                \
+        /* Sorted probes of a key only move forward: keep a cursor per key instead of searching */   \
+        if ($sorted && AS_LIST(Ht)[0]->len <= Len) {                                                 \
+            $sweep = I64(AS_LIST(Ht)[0]->len);                                                       \
+            $cursors = AS_I64($sweep);                                                               \
+            for ($i = 0; $i < $sweep->len; $i++)                                                     \
+                $cursors[$i] = -1;                                                                   \
+        }                                                                                            \
+        for ($i = Offset; $i < Len + Offset; $i++) {                                                 \
+            $idx = ht_oa_tab_get_with(Ht, $i, &__index_list_hash_get, &__index_list_cmp_row, Ctx);   \
+            if ($idx == NULL_I64) {                                                                  \
+                AS_I64(Ids)[$i] = NULL_I64;                                                          \
+                continue;                                                                            \
+            }                                                                                        \
+            $rows = AS_LIST(AS_LIST(Ht)[1])[$idx];                                                   \
+            $from = ($cursors != NULL) ? $cursors[$idx] : -1;                                        \
+            $p = INDEX_ASOF_SEEK($lx[$i], $rx, AS_I64($rows), $from, $rows->len);                    \
+            if ($cursors != NULL)                                                                    \
+                $cursors[$idx] = $p;                                                                 \
+            AS_I64(Ids)[$i] = ($p < 0) ? NULL_I64 : AS_I64($rows)[$p];                               \
+        }                                                                                            \
+        drop_obj($sweep);                                                                            \
+    })
 
 static obj_p __asof_ids_partial(__index_list_ctx_t* ctx, obj_p lxcol, obj_p rxcol, obj_p ht, i64_t len, i64_t offset,
                                 obj_p ids) {
-    i64_t i, idx, p;
-
     switch (lxcol->type) {
         case TYPE_I32:
         case TYPE_DATE:
         case TYPE_TIME:
-            for (i = offset; i < len + offset; i++) {
-                idx = ht_oa_tab_get_with(ht, i, &__index_list_hash_get, &__index_list_cmp_row, ctx);
-                if (idx != NULL_I64) {
-                    p = index_bin_i32(AS_I32(lxcol)[i], AS_I32(rxcol), AS_I64(AS_LIST(AS_LIST(ht)[1])[idx]),
-                                      AS_LIST(AS_LIST(ht)[1])[idx]->len);
-                    AS_I64(ids)[i] = p;
-                } else
-                    AS_I64(ids)[i] = NULL_I64;
-            }
+            ASOF_IDS_PARTIAL(i32, ctx, lxcol, rxcol, ht, len, offset, ids);
+            break;
+        case TYPE_I64:
+        case TYPE_TIMESTAMP:
+            ASOF_IDS_PARTIAL(i64, ctx, lxcol, rxcol, ht, len, offset, ids);
+            break;
+        case TYPE_F64:
+            ASOF_IDS_PARTIAL(f64, ctx, lxcol, rxcol, ht, len, offset, ids);
             break;
         default:
             THROW(ERR_TYPE, "index_asof_join_obj: invalid type: %s", type_name(lxcol->type));
@@ -2442,8 +2988,7 @@ obj_p index_asof_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol) {
     n = pool_split_by(pool, ll, 0);
 
     if (n == 1) {
-        __asof_ids_partial(&ctx, lxcol, rxcol, ht, ll, 0, ids);
-        goto clean;
+        v = __asof_ids_partial(&ctx, lxcol, rxcol, ht, ll, 0, ids);
     } else {
         pool_prepare(pool);
         chunk = ll / n;
@@ -2452,18 +2997,8 @@ obj_p index_asof_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol) {
             pool_add_task(pool, (raw_p)__asof_ids_partial, 7, &ctx, lxcol, rxcol, ht, chunk, i * chunk, ids);
         pool_add_task(pool, (raw_p)__asof_ids_partial, 7, &ctx, lxcol, rxcol, ht, ll - i * chunk, i * chunk, ids);
         v = pool_run(pool);
-
-        if (IS_ERR(v)) {
-            drop_obj(ids);
-            drop_obj(hashes);
-            drop_obj(ht);
-            return v;
-        }
-
-        drop_obj(v);
     }
 
-clean:
     drop_obj(hashes);
     rl = AS_LIST(ht)[0]->len;
     for (i = 0; i < rl; i++)
@@ -2472,22 +3007,101 @@ clean:
 
     drop_obj(ht);
 
-    return ids;
-}
+    if (IS_ERR(v)) {
+        drop_obj(ids);
+        return v;
+    }
 
-static obj_p __window_join_fill(__index_list_ctx_t* ctx, obj_p ht, i64_t len, i64_t offset, obj_p out) {
-    i64_t i, idx;
-    obj_p* ids;
+    drop_obj(v);
 
-    ids = AS_LIST(out);
-    len += offset;
+    return ids;
+}
 
-    for (i = offset; i < len; i++) {
-        idx = ht_oa_tab_get_with(ht, i, &__index_list_hash_get, &__index_list_cmp_row, ctx);
-        if (idx != NULL_I64)
-            ids[i] = clone_obj(AS_LIST(AS_LIST(ht)[1])[idx]);
-        else
-            ids[i] = NULL_OBJ;
+typedef struct __window_join_ctx_t {
+    __index_list_ctx_t *keys;
+    obj_p ht;      // key -> [first, last] rows of the key in the (sorted) right table
+    obj_p rxcol;
+    obj_p lower;   // window bounds per left row, same type as rxcol
+    obj_p upper;
+    i64_t jtype;   // 0: window starts from the prevailing right row, 1: bounds are strict
+    i64_t *from;   // out: first right row of the window, NULL_I64 if it is empty
+    i64_t *to;     // out: last right row of the window
+} __window_join_ctx_t;
+
+// Last position in Vals[From..To] whose value is <= Val, From if there is none
+#define WINDOW_BIN_LAST_LE(Val, Vals, From, To)  \
+    ({                                           \
+        i64_t $l = (From), $r = (To), $m, $p;    \
+        $p = $l;                                 \
+        while ($l <= $r) {                       \
+            $m = $l + ($r - $l) / 2;             \
+            if ((Vals)[$m] <= (Val)) {           \
+                $p = $m;                         \
+                $l = $m + 1;                     \
+            } else {                             \
+                $r = $m - 1;                     \
+            }                                    \
+        }                                        \
+        $p;                                      \
+    })
+
+// First position in Vals[From..To] whose value is >= Val, From if there is none
+#define WINDOW_BIN_FIRST_GE(Val, Vals, From, To) \
+    ({                                           \
+        i64_t $l = (From), $r = (To), $m, $p;    \
+        $p = $l;                                 \
+        while ($l <= $r) {                       \
+            $m = $l + ($r - $l) / 2;             \
+            if ((Vals)[$m] < (Val)) {            \
+                $l = $m + 1;                     \
+            } else {                             \
+                $p = $m;                         \
+                $r = $m - 1;                     \
+            }                                    \
+        }                                        \
+        $p;                                      \
+    })
+
+#define WINDOW_JOIN_FILL(Type, Ctx, Len, Offset)                                                              \
+    ({                                                                                                        \
+        Type##_t *$rx = __AS_##Type((Ctx)->rxcol), *$kl = __AS_##Type((Ctx)->lower),                         \
+                 *$kr = __AS_##Type((Ctx)->upper);                                                            \
+        i64_t $i, $idx, $fi, $ti, $li, $ri;                                                                   \
+        for ($i = Offset; $i < Len + Offset; $i++) {                                                          \
+            $idx = ht_oa_tab_get_with((Ctx)->ht, $i, &__index_list_hash_get, &__index_list_cmp_row,           \
+                                      (Ctx)->keys);                                                           \
+            (Ctx)->from[$i] = NULL_I64;                                                                       \
+            (Ctx)->to[$i] = NULL_I64;                                                                         \
+            if ($idx == NULL_I64)                                                                             \
+                continue;                                                                                     \
+            $fi = AS_I64(AS_LIST(AS_LIST((Ctx)->ht)[1])[$idx])[0];                                            \
+            $ti = AS_I64(AS_LIST(AS_LIST((Ctx)->ht)[1])[$idx])[1];                                            \
+            $li = ((Ctx)->jtype == 0) ? WINDOW_BIN_LAST_LE($kl[$i], $rx, $fi, $ti)                            \
+                                      : WINDOW_BIN_FIRST_GE($kl[$i], $rx, $fi, $ti);                          \
+            $ri = WINDOW_BIN_LAST_LE($kr[$i], $rx, $fi, $ti);                                                 \
+            if ($rx[$li] > $kr[$i] || ((Ctx)->jtype == 1 && $rx[$ri] < $kl[$i]))                              \
+                continue;                                                                                     \
+            (Ctx)->from[$i] = $li;                                                                            \
+            (Ctx)->to[$i] = $ri;                                                                              \
+        }                                                                                                     \
+    })
+
+static obj_p __window_join_fill(__window_join_ctx_t *ctx, i64_t len, i64_t offset) {
+    switch (ctx->rxcol->type) {
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            WINDOW_JOIN_FILL(i32, ctx, len, offset);
+            break;
+        case TYPE_I64:
+        case TYPE_TIMESTAMP:
+            WINDOW_JOIN_FILL(i64, ctx, len, offset);
+            break;
+        case TYPE_F64:
+            WINDOW_JOIN_FILL(f64, ctx, len, offset);
+            break;
+        default:
+            THROW(ERR_TYPE, "index_window_join_obj: invalid type: %s", type_name(ctx->rxcol->type));
     }
 
     return NULL_OBJ;
@@ -2496,13 +3110,21 @@ static obj_p __window_join_fill(__index_list_ctx_t* ctx, obj_p ht, i64_t len, i6
 obj_p index_window_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol, obj_p windows, obj_p ltab, obj_p rtab,
                             i64_t jtype) {
     i64_t i, ll, rl, n, chunk;
-    obj_p v, ht, hashes, index;
+    obj_p v, ht, hashes, bounds;
     i64_t idx;
     __index_list_ctx_t ctx;
+    __window_join_ctx_t wctx;
     pool_p pool;
 
     ll = ops_count(ltab);
     rl = ops_count(rtab);
+
+    if (windows->len != 2 || AS_LIST(windows)[0]->type != rxcol->type || AS_LIST(windows)[1]->type != rxcol->type)
+        THROW(ERR_TYPE, "window-join: windows must be two vectors of type: %s", type_name(rxcol->type));
+
+    if (AS_LIST(windows)[0]->len != ll || AS_LIST(windows)[1]->len != ll)
+        THROW(ERR_LENGTH, "window-join: windows must match the left table length");
+
     ht = ht_oa_create(rl, TYPE_I64);
     hashes = I64(MAXI64(ll, rl));
 
@@ -2522,25 +3144,33 @@ obj_p index_window_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol,
         }
     }
 
-    index = LIST(ll);
+    // Resolve every window to its right rows once, aggregations then only walk the ranges
+    bounds = vn_list(2, I64(ll), I64(ll));
 
     // Left hashes
     __index_list_precalc_hash(lcols, (i64_t*)AS_I64(hashes), lcols->len, ll, NULL, B8_TRUE);
     ctx = (__index_list_ctx_t){rcols, lcols, (i64_t*)AS_I64(hashes), NULL};
+    wctx = (__window_join_ctx_t){.keys = &ctx,
+                                 .ht = ht,
+                                 .rxcol = rxcol,
+                                 .lower = AS_LIST(windows)[0],
+                                 .upper = AS_LIST(windows)[1],
+                                 .jtype = jtype,
+                                 .from = AS_I64(AS_LIST(bounds)[0]),
+                                 .to = AS_I64(AS_LIST(bounds)[1])};
 
     pool = pool_get();
     n = pool_split_by(pool, ll, 0);
 
     if (n == 1) {
-        __window_join_fill(&ctx, ht, ll, 0, index);
+        v = __window_join_fill(&wctx, ll, 0);
     } else {
         pool_prepare(pool);
         chunk = ll / n;
         for (i = 0; i < n - 1; i++)
-            pool_add_task(pool, (raw_p)__window_join_fill, 5, &ctx, ht, chunk, i * chunk, index);
-        pool_add_task(pool, (raw_p)__window_join_fill, 5, &ctx, ht, ll - i * chunk, i * chunk, index);
+            pool_add_task(pool, (raw_p)__window_join_fill, 3, &wctx, chunk, i * chunk);
+        pool_add_task(pool, (raw_p)__window_join_fill, 3, &wctx, ll - i * chunk, i * chunk);
         v = pool_run(pool);
-        drop_obj(v);
     }
 
     drop_obj(hashes);
@@ -2551,6 +3181,13 @@ obj_p index_window_join_obj(obj_p lcols, obj_p lxcol, obj_p rcols, obj_p rxcol,
 
     drop_obj(ht);
 
-    return index_group_build(INDEX_TYPE_WINDOW, ll, clone_obj(lxcol), clone_obj(rxcol), clone_obj(windows), index,
+    if (IS_ERR(v)) {
+        drop_obj(bounds);
+        return v;
+    }
+
+    drop_obj(v);
+
+    return index_group_build(INDEX_TYPE_WINDOW, ll, clone_obj(lxcol), clone_obj(rxcol), clone_obj(windows), bounds,
                              i64(jtype));
 }
\ No newline at end of file
@@ -63,12 +63,15 @@ i64_t *index_group_filter_ids(obj_p index);
 obj_p index_group_filter(obj_p index);
 i64_t index_group_shift(obj_p index);
 obj_p index_group_meta(obj_p index);
+i64_t index_group_base(obj_p index);
+obj_p index_group_from_ids(i64_t groups_count, obj_p group_ids, obj_p filter, i64_t base);
 obj_p index_distinct_i8(i8_t values[], i64_t len);
 obj_p index_distinct_i16(i16_t values[], i64_t len);
 obj_p index_distinct_i32(i32_t values[], i64_t len);
 obj_p index_distinct_i64(i64_t values[], i64_t len);
 obj_p index_distinct_guid(guid_t values[], i64_t len);
 obj_p index_distinct_obj(obj_p values[], i64_t len);
+obj_p index_distinct_strings(obj_p x);
 obj_p index_in_i8_i8(i8_t x[], i64_t xl, i8_t y[], i64_t yl);
 obj_p index_in_i8_i16(i8_t x[], i64_t xl, i16_t y[], i64_t yl);
 obj_p index_in_i8_i32(i8_t x[], i64_t xl, i32_t y[], i64_t yl);
@@ -43,6 +43,8 @@
 #include "compose.h"
 #include "items.h"
 #include "ipc.h"
+#include "zone.h"
+#include "grouped.h"
 
 obj_p ray_hopen(obj_p *x, i64_t n) {
     i64_t fd, id, timeout = 0;
@@ -330,6 +332,19 @@ obj_p parse_csv_field(i8_t type, str_p start, str_p end, i64_t row, obj_p out) {
                 n--;
             AS_LIST(out)[row] = string_from_str(start, n);
             break;
+        case TYPE_STRINGS:
+            // keep the slice of the mapped file, the column is packed once all the lines are parsed
+            if (start == NULL || end == NULL) {
+                AS_I64(out)[2 * row] = 0;
+                AS_I64(out)[2 * row + 1] = 0;
+                break;
+            }
+            n = end - start;
+            if ((n > 0) && (*(end - 1) == '\r'))
+                n--;
+            AS_I64(out)[2 * row] = (i64_t)start;
+            AS_I64(out)[2 * row + 1] = n;
+            break;
         case TYPE_GUID:
             if (start == NULL || end == NULL) {
                 memcpy(AS_GUID(out)[row], NULL_GUID, sizeof(guid_t));
@@ -518,7 +533,7 @@ obj_p ray_read_csv(obj_p *x, i64_t n) {
     i64_t fd, size;
     i64_t i, l, len, lines;
     str_p buf, prev, pos, line;
-    obj_p types, names, cols, path, res;
+    obj_p types, names, cols, col, path, res;
     i8_t type;
     c8_t sep = ',';
 
@@ -655,6 +670,8 @@ obj_p ray_read_csv(obj_p *x, i64_t n) {
             for (i = 0; i < l; i++) {
                 if (AS_C8(types)[i] == TYPE_C8)
                     AS_LIST(cols)[i] = LIST(lines);
+                else if (AS_C8(types)[i] == TYPE_STRINGS)
+                    AS_LIST(cols)[i] = I64(2 * lines);
                 else
                     AS_LIST(cols)[i] = vector(AS_C8(types)[i], lines);
             }
@@ -662,6 +679,17 @@ obj_p ray_read_csv(obj_p *x, i64_t n) {
             // parse lines
             res = parse_csv_lines((i8_t *)AS_U8(types), l, line, size, lines, cols, sep);
 
+            // pack string columns while the file is still mapped
+            if (is_null(res)) {
+                for (i = 0; i < l; i++) {
+                    if (AS_C8(types)[i] == TYPE_STRINGS) {
+                        col = strings_from_slices(AS_I64(AS_LIST(cols)[i]), lines);
+                        drop_obj(AS_LIST(cols)[i]);
+                        AS_LIST(cols)[i] = col;
+                    }
+                }
+            }
+
             drop_obj(types);
             fs_fclose(fd);
             mmap_free(buf, size);
@@ -805,15 +833,11 @@ obj_p io_get_symfile(obj_p path) {
     return NULL_OBJ;
 }
 
-obj_p io_set_table(obj_p path, obj_p table) {
+// Save an object as a blob (serialized)
+static obj_p io_set_blob(obj_p path, obj_p obj) {
     i64_t c, fd;
     obj_p s, buf, res;
 
-    // Save splayed
-    if (path->len > 0 && AS_C8(path)[path->len - 1] == '/')
-        return io_set_table_splayed(path, table, NULL_OBJ);
-
-    // Save as a blob (serialized)
     s = cstring_from_obj(path);
     fd = fs_fopen(AS_C8(s), ATTR_WRONLY | ATTR_CREAT | ATTR_TRUNC);
 
@@ -823,7 +847,7 @@ obj_p io_set_table(obj_p path, obj_p table) {
         return res;
     }
 
-    buf = ser_obj(table);
+    buf = ser_obj(obj);
     if (IS_ERR(buf)) {
         drop_obj(s);
         fs_fclose(fd);
@@ -846,9 +870,17 @@ obj_p io_set_table(obj_p path, obj_p table) {
     return NULL_OBJ;
 }
 
+obj_p io_set_table(obj_p path, obj_p table) {
+    // Save splayed
+    if (path->len > 0 && AS_C8(path)[path->len - 1] == '/')
+        return io_set_table_splayed(path, table, NULL_OBJ);
+
+    return io_set_blob(path, table);
+}
+
 obj_p io_set_table_splayed(obj_p path, obj_p table, obj_p symfile) {
     i64_t i, l;
-    obj_p res, col, s, p, v, e, cols, sym;
+    obj_p res, col, s, p, v, e, cols, sym, zones, grouped;
 
     // save columns schema
     s = cstring_from_str(".d", 2);
@@ -930,16 +962,24 @@ obj_p io_set_table_splayed(obj_p path, obj_p table, obj_p symfile) {
     for (i = 0; i < l; i++) {
         v = at_idx(AS_LIST(table)[1], i);
 
+        // a sorted column is saved as such, so range filters over it can binary search
+        if (!(v->attrs & ATTR_ASC) && ops_is_asc(v))
+            v->attrs |= ATTR_ASC;
+
         // symbol column need to be converted to enum
         if (v->type == TYPE_SYMBOL) {
             s = symbol("sym", 3);
             e = ray_enum(s, v);
             drop_obj(s);
-            drop_obj(v);
 
-            if (IS_ERR(e))
+            if (IS_ERR(e)) {
+                drop_obj(v);
                 return e;
+            }
 
+            // keep the column marked, its group index is saved along
+            e->attrs |= v->attrs & ATTR_GROUPED;
+            drop_obj(v);
             v = e;
         }
 
@@ -959,9 +999,165 @@ obj_p io_set_table_splayed(obj_p path, obj_p table, obj_p symfile) {
         drop_obj(res);
     }
 
+    // save zone maps of the columns supporting them, rewritten each time to never go stale
+    zones = dict(SYMBOL(0), LIST(0));
+    for (i = 0; i < l; i++) {
+        v = zone_build(AS_LIST(AS_LIST(table)[1])[i]);
+        if (v == NULL_OBJ)
+            continue;
+
+        p = at_idx(AS_LIST(table)[0], i);
+        set_obj(&zones, p, v);
+        drop_obj(p);
+    }
+
+    s = cstring_from_str(".z", 2);
+    col = ray_concat(path, s);
+    res = io_set_blob(col, zones);
+
+    drop_obj(s);
+    drop_obj(col);
+    drop_obj(zones);
+
+    if (IS_ERR(res))
+        return res;
+
+    drop_obj(res);
+
+    // save group indexes of grouped columns, the file is only there if any is
+    grouped = dict(SYMBOL(0), LIST(0));
+    for (i = 0; i < l; i++) {
+        v = AS_LIST(AS_LIST(table)[1])[i];
+        if (!(v->attrs & ATTR_GROUPED))
+            continue;
+
+        e = grouped_get(v);
+        if (e == NULL_OBJ)
+            e = grouped_build(v);
+        if (e == NULL_OBJ)
+            continue;
+
+        p = at_idx(AS_LIST(table)[0], i);
+        set_obj(&grouped, p, grouped_save(e));
+        drop_obj(p);
+        drop_obj(e);
+    }
+
+    if (AS_LIST(grouped)[0]->len > 0) {
+        s = cstring_from_str(".g", 2);
+        col = ray_concat(path, s);
+        res = io_set_blob(col, grouped);
+
+        drop_obj(s);
+        drop_obj(col);
+
+        if (IS_ERR(res)) {
+            drop_obj(grouped);
+            return res;
+        }
+
+        drop_obj(res);
+    }
+
+    drop_obj(grouped);
+
     return clone_obj(path);
 }
 
+/*
+ * Attach the zone maps saved along a splayed table to its mapped columns.
+ * Zone maps are optional: a missing or unreadable file just leaves the columns without them.
+ */
+static nil_t io_get_zones(obj_p path, obj_p keys, obj_p vals) {
+    i64_t i, l;
+    obj_p s, col, zones, zone, v;
+
+    s = cstring_from_str(".z", 2);
+    col = ray_concat(path, s);
+    zones = ray_get(col);
+    drop_obj(s);
+    drop_obj(col);
+
+    if (zones->type != TYPE_DICT) {
+        drop_obj(zones);
+        return;
+    }
+
+    l = keys->len;
+    for (i = 0; i < l; i++) {
+        v = AS_LIST(vals)[i];
+        if (!IS_EXTERNAL_SIMPLE(v))
+            continue;
+
+        s = at_idx(keys, i);
+        zone = at_obj(zones, s);
+        drop_obj(s);
+
+        // a zone map not matching the column length was saved for another version of it
+        if (zone->type != TYPE_TABLE || ops_count(zone) != (v->len + ZONE_BLOCK - 1) / ZONE_BLOCK) {
+            drop_obj(zone);
+            continue;
+        }
+
+        runtime_zone_push(runtime_get(), v, zone);
+    }
+
+    drop_obj(zones);
+}
+
+/*
+ * Attach the group indexes saved along a splayed table to its columns marked grouped.
+ * A column whose index is missing or does not match its length is left without one.
+ */
+static nil_t io_get_grouped(obj_p path, obj_p keys, obj_p vals) {
+    i64_t i, l;
+    obj_p s, col, saved, index, v;
+
+    l = keys->len;
+    for (i = 0; i < l; i++) {
+        if (AS_LIST(vals)[i]->attrs & ATTR_GROUPED)
+            break;
+    }
+
+    if (i == l)
+        return;
+
+    s = cstring_from_str(".g", 2);
+    col = ray_concat(path, s);
+    saved = ray_get(col);
+    drop_obj(s);
+    drop_obj(col);
+
+    if (saved->type != TYPE_DICT) {
+        drop_obj(saved);
+        return;
+    }
+
+    for (; i < l; i++) {
+        v = AS_LIST(vals)[i];
+        if (!IS_VECTOR(v) || !(v->attrs & ATTR_GROUPED))
+            continue;
+
+        s = at_idx(keys, i);
+        col = at_obj(saved, s);
+        index = grouped_load(col);
+        drop_obj(s);
+        drop_obj(col);
+
+        if (index == NULL_OBJ)
+            continue;
+
+        if (AS_LIST(index)[1]->len != ops_count(v)) {
+            drop_obj(index);
+            continue;
+        }
+
+        grouped_set(v, index);
+    }
+
+    drop_obj(saved);
+}
+
 obj_p io_get_table_splayed(obj_p path, obj_p symfile) {
     obj_p col, keys, vals, val, s, v;
     i64_t i, l;
@@ -1020,5 +1216,41 @@ obj_p io_get_table_splayed(obj_p path, obj_p symfile) {
         }
     }
 
+    io_get_zones(path, keys, vals);
+    io_get_grouped(path, keys, vals);
+
     return table(keys, vals);
 }
+
+/*
+ * Hint the kernel about the upcoming access to an object mapped from a file.
+ * Objects living on the heap are left as is.
+ */
+nil_t io_advise(obj_p obj, mmap_advice_t advice) {
+    i64_t size;
+    raw_p addr;
+
+    if (obj->type >= TYPE_B8 && obj->type <= TYPE_C8)
+        size = ISIZEOF(struct obj_t) + obj->len * size_of_type(obj->type);
+    else if (obj->type == TYPE_ENUM || obj->type == TYPE_MAPLIST)
+        size = ISIZEOF(struct obj_t) + obj->len * ISIZEOF(i64_t);
+    else if (obj->type == TYPE_STRINGS)
+        size = size_of(obj);
+    else
+        return;
+
+    switch (obj->mmod) {
+        case MMOD_EXTERNAL_SIMPLE:
+            addr = (raw_p)obj;
+            break;
+        case MMOD_EXTERNAL_COMPOUND:
+            // compound objects keep their header page right before the object
+            addr = (raw_p)((str_p)obj - RAY_PAGE_SIZE);
+            size += RAY_PAGE_SIZE;
+            break;
+        default:
+            return;
+    }
+
+    mmap_advise(addr, size, advice);
+}
@@ -25,6 +25,7 @@
 #define IO_H
 
 #include "rayforce.h"
+#include "mmap.h"
 
 obj_p ray_hopen(obj_p *x, i64_t n);
 obj_p ray_hclose(obj_p x);
@@ -39,5 +40,6 @@ obj_p io_get_symfile(obj_p path);
 obj_p io_set_table(obj_p path, obj_p table);
 obj_p io_set_table_splayed(obj_p path, obj_p table, obj_p symfile);
 obj_p io_get_table_splayed(obj_p path, obj_p symfile);
+nil_t io_advise(obj_p obj, mmap_advice_t advice);
 
 #endif  // IO_H
@@ -30,6 +30,7 @@
 #include "string.h"
 #include "util.h"
 #include "log.h"
+#include "compress.h"
 
 // ============================================================================
 // Listener Management
@@ -48,6 +49,7 @@ option_t ipc_listener_accept(poll_p poll, selector_p selector) {
         ctx = (ipc_ctx_p)heap_alloc(sizeof(struct ipc_ctx_t));
         ctx->name = string_from_str("ipc", 4);
         ctx->msgtype = MSG_TYPE_RESP;
+        ctx->flags = 0;
 
         registry.fd = fd;
         registry.type = SELECTOR_TYPE_SOCKET;
@@ -167,6 +169,7 @@ i64_t ipc_open(poll_p poll, sock_addr_t *addr, i64_t timeout) {
 
     ctx = (ipc_ctx_p)heap_alloc(sizeof(struct ipc_ctx_t));
     ctx->name = string_from_str("ipc", 4);
+    ctx->flags = 0;
 
     registry.fd = fd;
     registry.type = SELECTOR_TYPE_SOCKET;
@@ -257,6 +260,7 @@ option_t ipc_read_header(poll_p poll, selector_p selector) {
     LOG_DEBUG("Switching to message reading mode");
     selector->rx.read_fn = ipc_read_msg;
     ctx->msgtype = msgtype;
+    ctx->flags = header->flags & (SERDE_FLAG_SYMDICT | SERDE_FLAG_COMPRESS);
 
     return option_some(NULL);
 }
@@ -272,7 +276,10 @@ option_t ipc_read_msg(poll_p poll, selector_p selector) {
     header = (ipc_header_t *)selector->rx.buf->data;
     size = header->size;
     LOG_DEBUG("Message size: %lld", size);
-    res = de_raw(selector->rx.buf->data + ISIZEOF(struct ipc_header_t), &size);
+    if (header->flags & SERDE_FLAG_COMPRESSED)
+        res = decompress_obj(selector->rx.buf->data + ISIZEOF(struct ipc_header_t), size);
+    else
+        res = de_raw(selector->rx.buf->data + ISIZEOF(struct ipc_header_t), &size);
     LOG_DEBUG("Message read");
 
     // Prepare for the next message
@@ -313,22 +320,42 @@ obj_p ipc_process_msg(poll_p poll, selector_p selector, obj_p msg) {
 
 nil_t ipc_send_msg(poll_p poll, selector_p selector, obj_p msg, u8_t msgtype) {
     i64_t size;
+    u8_t flags;
+    obj_p packed;
     poll_buffer_p buf;
     ipc_header_t *header;
+    ipc_ctx_p ctx;
+
+    // encode only what the peer announced it reads, and announce what we read ourselves
+    ctx = (ipc_ctx_p)selector->data;
 
     LOG_TRACE("Serializing message");
-    size = size_obj(msg);
+    size = size_obj_with(msg, ctx->flags);
     buf = poll_buf_create(ISIZEOF(struct ipc_header_t) + size);
 
+    ser_raw_with(buf->data + ISIZEOF(struct ipc_header_t), msg, ctx->flags);
+    flags = SERDE_FLAG_SYMDICT | SERDE_FLAG_COMPRESS;
+
+    // large payloads go compressed, unless they do not shrink
+    if ((ctx->flags & SERDE_FLAG_COMPRESS) && size >= COMPRESS_MIN_SIZE) {
+        packed = compress_bytes(buf->data + ISIZEOF(struct ipc_header_t), size);
+        if (packed->len < size) {
+            memcpy(buf->data + ISIZEOF(struct ipc_header_t), AS_U8(packed), packed->len);
+            size = packed->len;
+            buf->size = ISIZEOF(struct ipc_header_t) + size;
+            flags |= SERDE_FLAG_COMPRESSED;
+        }
+        drop_obj(packed);
+    }
+
     header = (ipc_header_t *)buf->data;
     header->prefix = SERDE_PREFIX;
     header->version = RAYFORCE_VERSION;
-    header->flags = 0x00;
+    header->flags = flags;
     header->endian = 0x00;
     header->msgtype = msgtype;
     header->size = size;
 
-    ser_raw(buf->data + ISIZEOF(struct ipc_header_t), msg);
     LOG_DEBUG("Sending message of size %lld", size);
     poll_send_buf(poll, selector, buf);
     LOG_DEBUG("Message sent");
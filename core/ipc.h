@@ -34,6 +34,7 @@
 
 typedef struct ipc_ctx_t {
     u8_t msgtype;
+    u8_t flags;  // serde flags the peer announced in its last header
     obj_p name;
 } *ipc_ctx_p;
 
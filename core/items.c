@@ -36,6 +36,8 @@
 #include "pool.h"
 #include "cmp.h"
 #include "iter.h"
+#include "zone.h"
+#include "grouped.h"
 
 obj_p ray_at(obj_p x, obj_p y) {
     i64_t i, j, yl, xl, n, size;
@@ -430,6 +432,9 @@ obj_p ray_take(obj_p x, obj_p y) {
             res = I16(m);
             for (i = 0, j = (l - m % l) * f; i < m; i++, j++)
                 AS_I16(res)[i] = AS_I16(y)[j % l];
+            // a prefix or a suffix keeps the order of the values
+            if (m <= l)
+                res->attrs = y->attrs & ATTR_ORDER;
             return res;
 
         case -TYPE_I16:
@@ -445,6 +450,8 @@ obj_p ray_take(obj_p x, obj_p y) {
             res = vector(y->type, m);
             for (i = 0, j = (l - m % l) * f; i < m; i++, j++)
                 AS_I32(res)[i] = AS_I32(y)[j % l];
+            if (m <= l)
+                res->attrs = y->attrs & ATTR_ORDER;
             return res;
 
         case -TYPE_I32:
@@ -463,6 +470,8 @@ obj_p ray_take(obj_p x, obj_p y) {
             res = vector(y->type, m);
             for (i = 0, j = (l - m % l) * f; i < m; i++, j++)
                 AS_I64(res)[i] = AS_I64(y)[j % l];
+            if (m <= l)
+                res->attrs = y->attrs & ATTR_ORDER;
             return res;
 
         case -TYPE_I64:
@@ -546,6 +555,16 @@ obj_p ray_take(obj_p x, obj_p y) {
                 AS_LIST(res)[i] = clone_obj(AS_LIST(y)[j % l]);
             return res;
 
+        case TYPE_STRINGS:
+            // out of range rows are gathered as empty strings
+            l = y->len;
+            v = I64(m);
+            for (i = 0, j = l ? (l - m % l) * f : 0; i < m; i++, j++)
+                AS_I64(v)[i] = l ? j % l : 0;
+            res = strings_at_ids(y, AS_I64(v), m);
+            drop_obj(v);
+            return res;
+
         case TYPE_TABLE:
             n = AS_LIST(y)[1]->len;
             res = vector(TYPE_LIST, n);
@@ -567,13 +586,90 @@ obj_p ray_take(obj_p x, obj_p y) {
     }
 }
 
+/*
+ * Lookup of a mapped column having a zone map: blocks not holding any of the values (or holding just one of them)
+ * are settled upfront, runs of remaining blocks are looked up as usual. Returns NULL_OBJ if no block is settled.
+ */
+static obj_p in_zone(obj_p x, obj_p y, obj_p zone) {
+    i64_t i, j, l, n, m, len;
+    obj_p hits, res, v, r;
+
+    l = x->len;
+    n = ops_count(zone);
+    hits = U8(n);
+
+    for (i = 0, m = 0; i < n; i++) {
+        AS_U8(hits)[i] = zone_in(zone, i, y);
+        m += (AS_U8(hits)[i] == ZONE_SOME);
+    }
+
+    if (m == n) {
+        drop_obj(hits);
+        return NULL_OBJ;
+    }
+
+    res = B8(l);
+
+    for (i = 0; i < n; i = j) {
+        for (j = i + 1; j < n && AS_U8(hits)[j] == AS_U8(hits)[i]; j++)
+            ;
+
+        len = ((j < n) ? j * ZONE_BLOCK : l) - i * ZONE_BLOCK;
+
+        switch (AS_U8(hits)[i]) {
+            case ZONE_NONE:
+                memset(AS_B8(res) + i * ZONE_BLOCK, B8_FALSE, len);
+                break;
+            case ZONE_ALL:
+                memset(AS_B8(res) + i * ZONE_BLOCK, B8_TRUE, len);
+                break;
+            default:
+                v = vector(x->type, len);
+                memcpy(AS_U8(v), AS_U8(x) + i * ZONE_BLOCK * size_of_type(x->type), len * size_of_type(x->type));
+                r = ray_in(v, y);
+                drop_obj(v);
+
+                if (IS_ERR(r)) {
+                    drop_obj(hits);
+                    drop_obj(res);
+                    return r;
+                }
+
+                memcpy(AS_B8(res) + i * ZONE_BLOCK, AS_B8(r), len);
+                drop_obj(r);
+                break;
+        }
+    }
+
+    drop_obj(hits);
+
+    return res;
+}
+
 obj_p ray_in(obj_p x, obj_p y) {
     i64_t i;
-    obj_p vec;
+    obj_p vec, zone;
 
     if (IS_ATOM(x) && IS_ATOM(y))
         return b8(cmp_obj(x, y) == 0);
 
+    if (IS_VECTOR(x) && (x->attrs & ATTR_GROUPED)) {
+        vec = B8(ops_count(x));
+        if (grouped_mask(x, y, B8_TRUE, vec))
+            return vec;
+        drop_obj(vec);
+    }
+
+    if (IS_VECTOR(x) && IS_VECTOR(y) && y->len <= ZONE_IN_MAX) {
+        zone = zone_get(x);
+        if (zone != NULL_OBJ) {
+            vec = in_zone(x, y, zone);
+            drop_obj(zone);
+            if (vec != NULL_OBJ)
+                return vec;
+        }
+    }
+
     switch (MTYPE2(x->type, y->type)) {
         case MTYPE2(TYPE_U8, TYPE_U8):
         case MTYPE2(TYPE_B8, TYPE_B8):
@@ -648,8 +744,9 @@ obj_p ray_in(obj_p x, obj_p y) {
 }
 
 obj_p ray_within(obj_p x, obj_p y) {
-    i64_t i, l, min, max;
-    obj_p res;
+    i64_t i, b, n, l, min, max, from, to;
+    zone_hit_t hit;
+    obj_p res, zone, bound;
 
     if (!IS_VECTOR(y) || y->len != 2)
         return error_str(ERR_TYPE, "within: second argument must be a 2-element vector");
@@ -668,8 +765,43 @@ obj_p ray_within(obj_p x, obj_p y) {
                 max = AS_I64(y)[1];
                 res = B8(l);
 
-                for (i = 0; i < l; i++)
-                    AS_B8(res)[i] = AS_I64(x)[i] >= min && AS_I64(x)[i] <= max;
+                // sorted values: the rows within are a single range
+                if (x->attrs & ATTR_ASC) {
+                    bound = i64(min);
+                    cmp_range(x, bound, ZONE_OP_GE, &from, &to);
+                    drop_obj(bound);
+                    bound = i64(max);
+                    cmp_range(x, bound, ZONE_OP_LE, &i, &to);
+                    drop_obj(bound);
+
+                    memset(AS_B8(res), B8_FALSE, l);
+                    if (to > from)
+                        memset(AS_B8(res) + from, B8_TRUE, to - from);
+
+                    return res;
+                }
+
+                zone = zone_get(x);
+
+                for (b = 0; b < l; b += ZONE_BLOCK) {
+                    n = (b + ZONE_BLOCK < l) ? ZONE_BLOCK : l - b;
+                    hit = (zone != NULL_OBJ) ? zone_within(zone, b / ZONE_BLOCK, y) : ZONE_SOME;
+
+                    switch (hit) {
+                        case ZONE_NONE:
+                            memset(AS_B8(res) + b, B8_FALSE, n);
+                            break;
+                        case ZONE_ALL:
+                            memset(AS_B8(res) + b, B8_TRUE, n);
+                            break;
+                        default:
+                            for (i = b; i < b + n; i++)
+                                AS_B8(res)[i] = AS_I64(x)[i] >= min && AS_I64(x)[i] <= max;
+                            break;
+                    }
+                }
+
+                drop_obj(zone);
 
                 return res;
 
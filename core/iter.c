@@ -29,6 +29,7 @@
 #include "eval.h"
 #include "error.h"
 #include "pool.h"
+#include "serde.h"
 
 obj_p map_unary_fn(unary_f fn, i64_t attrs, obj_p x) {
     i64_t i, l, n;
@@ -45,7 +46,8 @@ obj_p map_unary_fn(unary_f fn, i64_t attrs, obj_p x) {
                 return NULL_OBJ;
 
             v = AS_LIST(x);
-            n = pool_split_by(pool, l, 0);
+            // list items are coarse, so a task per item (inner kernels may split further when cores are idle)
+            n = pool_split_tasks(pool, l);
 
             if (n > 1) {
                 pool_prepare(pool);
@@ -183,6 +185,10 @@ obj_p map_binary_right_fn(binary_f fn, i64_t attrs, obj_p x, obj_p y) {
     i64_t i, l;
     obj_p res, item, a;
 
+    // string vectors gather all the rows at once to keep the result contiguous
+    if (x->type == TYPE_STRINGS && y->type == TYPE_I64)
+        return fn(x, y);
+
     switch (y->type) {
         case TYPE_C8:
         case TYPE_U8:
@@ -414,77 +420,117 @@ obj_p map_vary_fn(vary_f fn, i64_t attrs, obj_p *x, i64_t n) {
 
 obj_p map_vary(obj_p f, obj_p *x, i64_t n) { return map_vary_fn((vary_f)f->i64, f->attrs, x, n); }
 
-obj_p map_lambda_partial(obj_p f, obj_p *lst, i64_t n, i64_t arg) {
-    i64_t i;
-    obj_p res;
+// Map a lambda over the rows [from, from + len) of its arguments, into a vector while it returns atoms of a type
+obj_p map_lambda_partial(obj_p f, obj_p *x, i64_t n, i64_t from, i64_t len) {
+    i64_t i, j;
+    obj_p v, res;
 
-    for (i = 0; i < n; i++)
-        stack_push(at_idx(lst[i], arg));
+    res = NULL_OBJ;
+
+    for (i = 0; i < len; i++) {
+        for (j = 0; j < n; j++)
+            stack_push(at_idx(x[j], from + i));
 
-    res = call(f, n);
+        v = (f->attrs & FN_ATOMIC) ? map_lambda(f, x, n) : call(f, n);
+
+        for (j = 0; j < n; j++)
+            drop_obj(stack_pop());
+
+        if (IS_ERR(v)) {
+            if (res != NULL_OBJ) {
+                res->len = i;
+                drop_obj(res);
+            }
+
+            return v;
+        }
 
-    for (i = 0; i < n; i++)
-        drop_obj(stack_pop());
+        if (i == 0)
+            res = v->type < 0 ? vector(v->type, len) : LIST(len);
+
+        ins_obj(&res, i, v);
+    }
 
     return res;
 }
 
-obj_p map_lambda(obj_p f, obj_p *x, i64_t n) {
-    i64_t i, j, l, executors;
-    obj_p v, res;
-    pool_p pool;
+// Glue the results of the morsels together, keeping them a vector when all of them are of the same type
+static obj_p map_lambda_join(obj_p parts, i64_t len) {
+    i64_t i, j, k, l, size;
+    i8_t type;
+    obj_p part, res;
 
-    l = ops_rank(x, n);
+    l = parts->len;
+    type = AS_LIST(parts)[0]->type;
 
-    if (n == 0 || l == 0 || l == NULL_I64)
-        return NULL_OBJ;
+    for (i = 1; i < l && type != TYPE_LIST; i++) {
+        if (AS_LIST(parts)[i]->type != type)
+            type = TYPE_LIST;
+    }
 
-    pool = pool_get();
-    executors = pool_split_by(pool, l, 0);
+    if (type != TYPE_LIST) {
+        res = vector(type, len);
+        size = size_of_type(type);
 
-    if (executors > 1) {
-        pool_prepare(pool);
+        for (i = 0, k = 0; i < l; i++) {
+            part = AS_LIST(parts)[i];
+            memcpy(AS_U8(res) + k * size, AS_U8(part), part->len * size);
+            k += part->len;
+        }
+
+        drop_obj(parts);
+        return res;
+    }
 
-        for (j = 0; j < l; j++)
-            pool_add_task(pool, (raw_p)map_lambda_partial, 4, f, x, n, j);
+    res = LIST(len);
 
-        return pool_run(pool);
+    for (i = 0, k = 0; i < l; i++) {
+        part = AS_LIST(parts)[i];
+        for (j = 0; j < part->len; j++)
+            AS_LIST(res)[k++] = at_idx(part, j);
     }
 
-    for (j = 0; j < n; j++)
-        stack_push(at_idx(x[j], 0));
+    drop_obj(parts);
 
-    v = (f->attrs & FN_ATOMIC) ? map_lambda(f, x, n) : call(f, n);
+    return res;
+}
 
-    for (j = 0; j < n; j++)
-        drop_obj(stack_pop());
+obj_p map_lambda(obj_p f, obj_p *x, i64_t n) {
+    i64_t i, j, l, chunk, executors;
+    obj_p res;
+    pool_p pool;
 
-    if (IS_ERR(v))
-        return v;
+    l = ops_rank(x, n);
 
-    res = v->type < 0 ? vector(v->type, l) : LIST(l);
+    if (n == 0 || l == 0 || l == NULL_I64)
+        return NULL_OBJ;
 
-    ins_obj(&res, 0, v);
+    pool = pool_get();
+    executors = pool_split_by(pool, l, 0);
+    chunk = (l + executors - 1) / executors;
 
-    for (i = 1; i < l; i++) {
-        for (j = 0; j < n; j++)
-            stack_push(at_idx(x[j], i));
+    // mapping over lists (e.g. partitions) yields coarse calls, so run a task per item
+    for (j = 0; j < n && executors == 1; j++) {
+        if (x[j]->type == TYPE_LIST) {
+            executors = pool_split_tasks(pool, l);
+            chunk = 1;
+        }
+    }
 
-        v = (f->attrs & FN_ATOMIC) ? map_lambda(f, x, n) : call(f, n);
+    if (executors == 1)
+        return map_lambda_partial(f, x, n, 0, l);
 
-        for (j = 0; j < n; j++)
-            drop_obj(stack_pop());
+    // rows go in morsels, a task per executor, each filling a vector of its own
+    pool_prepare(pool);
 
-        if (IS_ERR(v)) {
-            res->len = i;
-            drop_obj(res);
-            return v;
-        }
+    for (i = 0; i < l; i += chunk)
+        pool_add_task(pool, (raw_p)map_lambda_partial, 5, f, x, n, i, MINI64(chunk, l - i));
 
-        ins_obj(&res, i, v);
-    }
+    res = pool_run(pool);
+    if (IS_ERR(res))
+        return res;
 
-    return res;
+    return map_lambda_join(res, l);
 }
 
 obj_p ray_map(obj_p *x, i64_t n) {
@@ -341,6 +341,9 @@ obj_p ray_asof_join(obj_p *x, i64_t n) {
     drop_obj(ajkl);
     drop_obj(ajkr);
 
+    if (IS_ERR(idx))
+        return idx;
+
     keys = at_obj(x[1], x[0]);
 
     res = __left_join_inner(x[1], x[2], x[0], keys, idx);
@@ -406,6 +409,11 @@ static obj_p __window_join(obj_p *x, i64_t n, i64_t tp) {
     drop_obj(wjkl);
     drop_obj(wjkr);
 
+    if (IS_ERR(idx)) {
+        drop_obj(jtab);
+        return idx;
+    }
+
     rtab = group_map(jtab, idx);
     mount_env(rtab);
 
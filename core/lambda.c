@@ -29,6 +29,7 @@
 #include "group.h"
 #include "pool.h"
 #include "iter.h"
+#include "vm.h"
 
 obj_p lambda(obj_p args, obj_p body, obj_p nfo) {
     obj_p obj;
@@ -44,6 +45,7 @@ obj_p lambda(obj_p args, obj_p body, obj_p nfo) {
     f->args = args;
     f->body = body;
     f->nfo = nfo;
+    f->code = (body == NULL_OBJ) ? NULL_OBJ : vm_compile(args, body);
 
     return obj;
 }
@@ -31,6 +31,7 @@ typedef struct lambda_f {
     obj_p args;  // vector of arguments names
     obj_p body;  // body of lambda
     obj_p nfo;   // nfo from cc phase
+    obj_p code;  // compiled body (see vm.h)
 } *lambda_p;
 
 #define AS_LAMBDA(o) ((lambda_p)(AS_C8(o)))
@@ -27,6 +27,11 @@
 #include "string.h"
 #include "eval.h"
 #include "runtime.h"
+#include "symbols.h"
+#include "items.h"
+#include "unary.h"
+#include "grouped.h"
+#include "pool.h"
 
 typedef obj_p (*logic_op_f)(raw_p, raw_p, raw_p, raw_p, raw_p);
 
@@ -201,14 +206,158 @@ obj_p ray_and(obj_p *x, i64_t n) { return logic_map(x, n, "and", and_op_partial)
 
 obj_p ray_or(obj_p *x, i64_t n) { return logic_map(x, n, "or", or_op_partial); }
 
+/*
+ * Like over symbols matches every distinct symbol once: the values of an enum domain or of a group index, then
+ * broadcasts the results to the rows through their ids. Plain symbol vectors keep the result of the last symbol seen
+ * at every slot of a small cache, so each chunk matches a column of few distinct values only a few times.
+ */
+#define LIKE_CACHE_BITS 10
+
+typedef obj_p (*like_partial_f)(raw_p, i64_t *, i64_t, i64_t, b8_t *);
+
+static obj_p like_symbols_partial(str_pat_t *pat, i64_t *syms, i64_t len, i64_t offset, b8_t *out) {
+    i64_t i, s, slot, keys[1 << LIKE_CACHE_BITS];
+    b8_t hits[1 << LIKE_CACHE_BITS];
+
+    memset(keys, 0, sizeof(keys));  // no symbol lives at address 0
+
+    for (i = offset; i < offset + len; i++) {
+        s = syms[i];
+        slot = (i64_t)(((u64_t)s * 0x9e3779b97f4a7c15ull) >> (64 - LIKE_CACHE_BITS));
+        if (keys[slot] != s) {
+            keys[slot] = s;
+            hits[slot] = str_pat_match(pat, str_from_symbol(s), SYMBOL_STRLEN(s));
+        }
+        out[i] = hits[slot];
+    }
+
+    return NULL_OBJ;
+}
+
+static obj_p like_ids_partial(b8_t *hits, i64_t *ids, i64_t len, i64_t offset, b8_t *out) {
+    i64_t i;
+
+    for (i = offset; i < offset + len; i++)
+        out[i] = hits[ids[i]];
+
+    return NULL_OBJ;
+}
+
+typedef struct like_strings_ctx_t {
+    str_pat_t pat;
+    str_p data;
+} like_strings_ctx_t;
+
+static obj_p like_strings_partial(like_strings_ctx_t *ctx, i64_t *offs, i64_t len, i64_t offset, b8_t *out) {
+    i64_t i;
+
+    for (i = offset; i < offset + len; i++)
+        out[i] = str_pat_match(&ctx->pat, ctx->data + offs[i], offs[i + 1] - offs[i]);
+
+    return NULL_OBJ;
+}
+
+static nil_t like_run(like_partial_f fn, raw_p arg, i64_t *vals, i64_t len, b8_t *out) {
+    i64_t i, n, chunk;
+    pool_p pool = runtime_get()->pool;
+
+    n = pool_split_by(pool, len, 0);
+
+    if (n == 1) {
+        fn(arg, vals, len, 0, out);
+        return;
+    }
+
+    chunk = (len + n - 1) / n;
+
+    pool_prepare(pool);
+    for (i = 0; i < len; i += chunk)
+        pool_add_task(pool, (raw_p)fn, 5, arg, vals, MINI64(chunk, len - i), i, out);
+    drop_obj(pool_run(pool));
+}
+
+static obj_p like_symbols(obj_p x, obj_p y) {
+    str_pat_t pat;
+    obj_p index, keys, hits, res;
+
+    str_pat_compile(&pat, AS_C8(y), y->len);
+    res = B8(x->len);
+
+    index = grouped_get(x);
+    if (index == NULL_OBJ) {
+        like_run((like_partial_f)like_symbols_partial, &pat, AS_SYMBOL(x), x->len, AS_B8(res));
+        return res;
+    }
+
+    keys = AS_LIST(index)[0];
+    hits = B8(keys->len);
+    like_run((like_partial_f)like_symbols_partial, &pat, AS_SYMBOL(keys), keys->len, AS_B8(hits));
+    like_run((like_partial_f)like_ids_partial, AS_B8(hits), AS_I64(AS_LIST(index)[1]), x->len, AS_B8(res));
+
+    drop_obj(hits);
+    drop_obj(index);
+
+    return res;
+}
+
+static obj_p like_enum(obj_p x, obj_p y) {
+    str_pat_t pat;
+    obj_p k, sym, ids, hits, res;
+
+    k = ray_key(x);
+    sym = ray_get(k);
+    drop_obj(k);
+
+    if (is_null(sym) || sym->type != TYPE_SYMBOL) {
+        drop_obj(sym);
+        THROW(ERR_TYPE, "like: invalid enum");
+    }
+
+    str_pat_compile(&pat, AS_C8(y), y->len);
+
+    hits = B8(sym->len);
+    like_run((like_partial_f)like_symbols_partial, &pat, AS_SYMBOL(sym), sym->len, AS_B8(hits));
+
+    ids = ENUM_VAL(x);
+    res = B8(ids->len);
+    like_run((like_partial_f)like_ids_partial, AS_B8(hits), AS_I64(ids), ids->len, AS_B8(res));
+
+    drop_obj(hits);
+    drop_obj(sym);
+
+    return res;
+}
+
+static obj_p like_strings(obj_p x, obj_p y) {
+    like_strings_ctx_t ctx;
+    obj_p res;
+
+    str_pat_compile(&ctx.pat, AS_C8(y), y->len);
+    ctx.data = STRINGS_DATA(x);
+    res = B8(x->len);
+    like_run((like_partial_f)like_strings_partial, &ctx, STRINGS_OFFS(x), x->len, AS_B8(res));
+
+    return res;
+}
+
 obj_p ray_like(obj_p x, obj_p y) {
     i64_t i, l;
+    str_pat_t pat;
     obj_p res, e;
 
     switch (MTYPE2(x->type, y->type)) {
         case MTYPE2(TYPE_C8, TYPE_C8):
             return (b8(str_match(AS_C8(x), x->len, AS_C8(y), y->len)));
+        case MTYPE2(-TYPE_SYMBOL, TYPE_C8):
+            return (b8(str_match(str_from_symbol(x->i64), SYMBOL_STRLEN(x->i64), AS_C8(y), y->len)));
+        case MTYPE2(TYPE_SYMBOL, TYPE_C8):
+            return like_symbols(x, y);
+        case MTYPE2(TYPE_ENUM, TYPE_C8):
+            return like_enum(x, y);
+        case MTYPE2(TYPE_STRINGS, TYPE_C8):
+            return like_strings(x, y);
         case MTYPE2(TYPE_LIST, TYPE_C8):
+            str_pat_compile(&pat, AS_C8(y), y->len);
             l = x->len;
             res = B8(l);
             for (i = 0; i < l; i++) {
@@ -219,12 +368,13 @@ obj_p ray_like(obj_p x, obj_p y) {
                     THROW(ERR_TYPE, "like: unsupported types: '%s, %s", type_name(e->type), type_name(y->type));
                 }
 
-                AS_B8(res)[i] = str_match(AS_C8(e), e->len, AS_C8(y), y->len);
+                AS_B8(res)[i] = str_pat_match(&pat, AS_C8(e), e->len);
             }
 
             return res;
 
         case MTYPE2(TYPE_MAPLIST, TYPE_C8):
+            str_pat_compile(&pat, AS_C8(y), y->len);
             l = x->len;
             res = B8(l);
             for (i = 0; i < l; i++) {
@@ -236,13 +386,14 @@ obj_p ray_like(obj_p x, obj_p y) {
                     THROW(ERR_TYPE, "like: unsupported types: '%s, '%s", type_name(e->type), type_name(y->type));
                 }
 
-                AS_B8(res)[i] = str_match(AS_C8(e), e->len, AS_C8(y), y->len);
+                AS_B8(res)[i] = str_pat_match(&pat, AS_C8(e), e->len);
                 drop_obj(e);
             }
 
             return res;
 
         case MTYPE2(TYPE_PARTEDLIST, TYPE_C8):
+        case MTYPE2(TYPE_PARTEDENUM, TYPE_C8):
             l = x->len;
             res = LIST(l);
             for (i = 0; i < l; i++) {
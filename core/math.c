@@ -86,8 +86,8 @@
         NULL_OBJ;                                                                        \
     })
 
-i8_t infer_math_type(obj_p x, obj_p y) {
-    switch (MTYPE2(ABSI8(x->type), ABSI8(y->type))) {
+static i8_t infer_math_type(i8_t x, i8_t y) {
+    switch (MTYPE2(ABSI8(x), ABSI8(y))) {
         case MTYPE2(TYPE_B8, TYPE_I64):
         case MTYPE2(TYPE_I64, TYPE_B8):
             return TYPE_I64;
@@ -121,8 +121,8 @@ i8_t infer_math_type(obj_p x, obj_p y) {
     }
 }
 
-i8_t infer_div_type(obj_p x, obj_p y) {
-    switch (MTYPE2(ABSI8(x->type), ABSI8(y->type))) {
+static i8_t infer_div_type(i8_t x, i8_t y) {
+    switch (MTYPE2(ABSI8(x), ABSI8(y))) {
         case MTYPE2(TYPE_I32, TYPE_I32):
         case MTYPE2(TYPE_I32, TYPE_I64):
         case MTYPE2(TYPE_I32, TYPE_F64):
@@ -140,8 +140,8 @@ i8_t infer_div_type(obj_p x, obj_p y) {
     }
 }
 
-i8_t infer_mod_type(obj_p x, obj_p y) {
-    switch (MTYPE2(ABSI8(x->type), ABSI8(y->type))) {
+static i8_t infer_mod_type(i8_t x, i8_t y) {
+    switch (MTYPE2(ABSI8(x), ABSI8(y))) {
         case MTYPE2(TYPE_I32, TYPE_I32):
         case MTYPE2(TYPE_I64, TYPE_I32):
             return TYPE_I32;
@@ -159,8 +159,8 @@ i8_t infer_mod_type(obj_p x, obj_p y) {
     }
 }
 
-i8_t infer_xbar_type(obj_p x, obj_p y) {
-    switch (MTYPE2(ABSI8(x->type), ABSI8(y->type))) {
+static i8_t infer_xbar_type(i8_t x, i8_t y) {
+    switch (MTYPE2(ABSI8(x), ABSI8(y))) {
         case MTYPE2(TYPE_I32, TYPE_I32):
             return TYPE_I32;
         case MTYPE2(TYPE_I32, TYPE_F64):
@@ -1497,6 +1497,7 @@ obj_p unop_map(raw_p op, obj_p x) {
     pool = runtime_get()->pool;
     n = pool_split_by(pool, l, 0);
     out = (rc_obj(x) == 1) ? clone_obj(x) : vector(x->type, l);
+    out->attrs &= ~ATTR_ORDER;  // a reused argument is overwritten, its order says nothing about the result
 
     if (n == 1) {
         argv[0] = (raw_p)x;
@@ -1529,6 +1530,15 @@ obj_p unop_map(raw_p op, obj_p x) {
     return out;
 }
 
+// Type of the values op yields for operands of types x and y
+i8_t binop_type(raw_p op, i8_t x, i8_t y) {
+    return (op == ray_fdiv_partial)  ? TYPE_F64
+           : (op == ray_div_partial)  ? infer_div_type(x, y)
+           : (op == ray_xbar_partial) ? infer_xbar_type(x, y)
+           : (op == ray_mod_partial)  ? infer_mod_type(x, y)
+                                      : infer_math_type(x, y);
+}
+
 obj_p binop_map(raw_p op, obj_p x, obj_p y) {
     pool_p pool;
     i64_t i, l, n;
@@ -1551,17 +1561,15 @@ obj_p binop_map(raw_p op, obj_p x, obj_p y) {
         return pool_call_task_fn(op, 2, argv);
     }
 
-    t = (op == ray_fdiv_partial)                            ? TYPE_F64
-        : (op == ray_div_partial)                           ? infer_div_type(x, y)
-        : (op == ray_xbar_partial)                          ? infer_xbar_type(x, y)
-        : (op == ray_mod_partial || op == ray_xbar_partial) ? infer_mod_type(x, y)
-                                                            : infer_math_type(x, y);
+    t = binop_type(op, x->type, y->type);
 
     pool = runtime_get()->pool;
     n = pool_split_by(pool, l, 0);
-    out = (rc_obj(x) == 1 && IS_VECTOR(x))   ? clone_obj(x)
-          : (rc_obj(y) == 1 && IS_VECTOR(y)) ? clone_obj(y)
-                                             : vector(t, l);
+    // an argument no one else holds takes the result, as long as it is of the same type
+    out = (rc_obj(x) == 1 && IS_VECTOR(x) && x->type == t)   ? clone_obj(x)
+          : (rc_obj(y) == 1 && IS_VECTOR(y) && y->type == t) ? clone_obj(y)
+                                                             : vector(t, l);
+    out->attrs &= ~ATTR_ORDER;
 
     if (n == 1) {
         argv[0] = (raw_p)x;
@@ -1730,6 +1738,9 @@ obj_p ray_avg(obj_p x) {
 
 // TODO: Refactoring with out sort and with parallel execution
 obj_p ray_med(obj_p x) {
+    if (x->type == TYPE_MAPGROUP)
+        return aggr_med(AS_LIST(x)[0], AS_LIST(x)[1]);
+
     i64_t l = ray_cnt(x)->i64;
     if (l == 0)
         return f64(NULL_F64);
@@ -1772,15 +1783,15 @@ obj_p ray_med(obj_p x) {
 
             //     return f64(med);
 
-        case TYPE_MAPGROUP:
-            return aggr_med(AS_LIST(x)[0], AS_LIST(x)[1]);
-
         default:
             THROW(ERR_TYPE, "med: unsupported type: '%s", type_name(x->type));
     }
 }
 
 obj_p ray_dev(obj_p x) {
+    if (x->type == TYPE_MAPGROUP)
+        return aggr_dev(AS_LIST(x)[0], AS_LIST(x)[1]);
+
     i64_t l = ray_cnt(x)->i64;
 
     if (l == 0)
@@ -1802,9 +1813,6 @@ obj_p ray_dev(obj_p x) {
         case TYPE_F64:
             favg = (ray_sum(x)->f64) / (f64_t)l;
             break;
-        case TYPE_MAPGROUP:
-            return aggr_dev(AS_LIST(x)[0], AS_LIST(x)[1]);
-
         default:
             THROW(ERR_TYPE, "dev: unsupported type: '%s", type_name(x->type));
     }
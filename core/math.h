@@ -44,4 +44,14 @@ obj_p ray_ceil(obj_p x);
 obj_p ray_med(obj_p x);
 obj_p ray_dev(obj_p x);
 
+// Element-wise operators over the rows [offset, offset + len) of their operands, into out
+obj_p ray_add_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p out);
+obj_p ray_sub_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p out);
+obj_p ray_mul_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p out);
+obj_p ray_div_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p out);
+obj_p ray_fdiv_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p out);
+obj_p ray_mod_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p out);
+obj_p ray_xbar_partial(obj_p x, obj_p y, i64_t len, i64_t offset, obj_p out);
+i8_t binop_type(raw_p op, i8_t x, i8_t y);
+
 #endif  // MATH_H
@@ -69,6 +69,14 @@ i64_t mmap_commit(raw_p addr, i64_t size) {
     return 0;
 }
 
+i64_t mmap_advise(raw_p addr, i64_t size, mmap_advice_t advice) {
+    // Views are faulted in lazily, there is no equivalent for access pattern hints
+    UNUSED(addr);
+    UNUSED(size);
+    UNUSED(advice);
+    return 0;
+}
+
 #elif defined(OS_LINUX)
 
 raw_p mmap_stack(i64_t size) {
@@ -87,7 +95,7 @@ raw_p mmap_alloc(i64_t size) {
 }
 
 raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset) {
-    raw_p ptr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NONBLOCK | MAP_POPULATE, fd, offset);
+    raw_p ptr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
 
     if (ptr == MAP_FAILED)
         return NULL;
@@ -112,6 +120,25 @@ raw_p mmap_reserve(raw_p addr, i64_t size) {
 
 i64_t mmap_commit(raw_p addr, i64_t size) { return mprotect(addr, size, PROT_READ | PROT_WRITE); }
 
+i64_t mmap_advise(raw_p addr, i64_t size, mmap_advice_t advice) {
+    switch (advice) {
+        case MMAP_ADVICE_SEQUENTIAL:
+            return madvise(addr, size, MADV_SEQUENTIAL);
+        case MMAP_ADVICE_WILLNEED:
+            return madvise(addr, size, MADV_WILLNEED);
+        case MMAP_ADVICE_DONTNEED:
+            return madvise(addr, size, MADV_DONTNEED);
+        case MMAP_ADVICE_POPULATE:
+#if defined(MADV_POPULATE_READ)
+            if (madvise(addr, size, MADV_POPULATE_READ) == 0)
+                return 0;
+#endif
+            return madvise(addr, size, MADV_WILLNEED);
+        default:
+            return madvise(addr, size, MADV_NORMAL);
+    }
+}
+
 #elif defined(OS_MACOS)
 
 #define MAP_ANON 0x1000
@@ -160,4 +187,18 @@ raw_p mmap_reserve(raw_p addr, i64_t size) {
 
 i64_t mmap_commit(raw_p addr, i64_t size) { return mprotect(addr, size, PROT_READ | PROT_WRITE); }
 
+i64_t mmap_advise(raw_p addr, i64_t size, mmap_advice_t advice) {
+    switch (advice) {
+        case MMAP_ADVICE_SEQUENTIAL:
+            return madvise(addr, size, MADV_SEQUENTIAL);
+        case MMAP_ADVICE_WILLNEED:
+        case MMAP_ADVICE_POPULATE:
+            return madvise(addr, size, MADV_WILLNEED);
+        case MMAP_ADVICE_DONTNEED:
+            return madvise(addr, size, MADV_DONTNEED);
+        default:
+            return madvise(addr, size, MADV_NORMAL);
+    }
+}
+
 #endif
@@ -26,6 +26,15 @@
 
 #include "rayforce.h"
 
+// Access pattern hints for file mappings, file pages are faulted in lazily by default
+typedef enum mmap_advice_t {
+    MMAP_ADVICE_NORMAL = 0,
+    MMAP_ADVICE_SEQUENTIAL,  // full scan: aggressive readahead, pages may be reclaimed early
+    MMAP_ADVICE_WILLNEED,    // asynchronous prefetch of the range
+    MMAP_ADVICE_DONTNEED,    // range is not needed anymore: release resident pages
+    MMAP_ADVICE_POPULATE,    // fault the whole range in now (eager loading)
+} mmap_advice_t;
+
 raw_p mmap_stack(i64_t size);
 raw_p mmap_alloc(i64_t size);
 raw_p mmap_file(i64_t fd, raw_p addr, i64_t size, i64_t offset);
@@ -33,5 +42,6 @@ i64_t mmap_free(raw_p addr, i64_t size);
 i64_t mmap_sync(raw_p addr, i64_t size);
 raw_p mmap_reserve(raw_p addr, i64_t size);
 i64_t mmap_commit(raw_p addr, i64_t size);
+i64_t mmap_advise(raw_p addr, i64_t size, mmap_advice_t advice);
 
 #endif  // MMAP_H
@@ -141,6 +141,9 @@ b8_t ops_eq_idx(obj_p a, i64_t ai, obj_p b, i64_t bi) {
             drop_obj(lv);
             drop_obj(rv);
             return eq;
+        case MTYPE2(TYPE_STRINGS, TYPE_STRINGS):
+            return str_cmp(STRINGS_DATA(a) + STRINGS_OFFS(a)[ai], STRINGS_OFFS(a)[ai + 1] - STRINGS_OFFS(a)[ai],
+                           STRINGS_DATA(b) + STRINGS_OFFS(b)[bi], STRINGS_OFFS(b)[bi + 1] - STRINGS_OFFS(b)[bi]) == 0;
         case MTYPE2(TYPE_MAPLIST, TYPE_MAPLIST):
             lv = at_idx(a, ai);
             rv = at_idx(b, bi);
@@ -181,6 +184,8 @@ i64_t ops_count(obj_p x) {
             return ENUM_VAL(x)->len;
         case TYPE_MAPLIST:
             return MAPLIST_VAL(x)->len;
+        case TYPE_STRINGS:
+            return x->len;
         case TYPE_PARTEDLIST:
         case TYPE_PARTEDB8:
         case TYPE_PARTEDU8:
@@ -234,6 +239,41 @@ i64_t ops_rank(obj_p *x, i64_t n) {
 }
 
 // TODO: optimize this via parallel processing
+// Are the values of a vector in an ascending order, nulls being the smallest
+b8_t ops_is_asc(obj_p x) {
+    i64_t i, l;
+
+    l = x->len;
+
+    switch (x->type) {
+        case TYPE_I16:
+            for (i = 1; i < l; i++)
+                if (AS_I16(x)[i] < AS_I16(x)[i - 1])
+                    return B8_FALSE;
+            return B8_TRUE;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            for (i = 1; i < l; i++)
+                if (AS_I32(x)[i] < AS_I32(x)[i - 1])
+                    return B8_FALSE;
+            return B8_TRUE;
+        case TYPE_I64:
+        case TYPE_TIMESTAMP:
+            for (i = 1; i < l; i++)
+                if (AS_I64(x)[i] < AS_I64(x)[i - 1])
+                    return B8_FALSE;
+            return B8_TRUE;
+        case TYPE_F64:
+            for (i = 1; i < l; i++)
+                if (LTF64(AS_F64(x)[i], AS_F64(x)[i - 1]))
+                    return B8_FALSE;
+            return B8_TRUE;
+        default:
+            return B8_FALSE;
+    }
+}
+
 obj_p ops_where(b8_t *mask, i64_t len) {
     i64_t i, j, count;
     i64_t *ids;
@@ -251,6 +291,8 @@ obj_p ops_where(b8_t *mask, i64_t len) {
             ids[j++] = i;
     }
 
+    res->attrs = ATTR_ASC | ATTR_DISTINCT;
+
     return res;
 }
 
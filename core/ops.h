@@ -48,7 +48,9 @@ extern struct obj_t __NULL_OBJECT;
 #define ATTR_ASC 2
 #define ATTR_DESC 4
 #define ATTR_QUOTED 8
+#define ATTR_GROUPED 16  // the vector has a group index attached (see grouped.h)
 #define ATTR_PROTECTED 64
+#define ATTR_ORDER (ATTR_DISTINCT | ATTR_ASC | ATTR_DESC)  // what is known about the values of a vector
 
 #define IS_INTERNAL(x) ((x)->mmod == MMOD_INTERNAL)
 #define IS_EXTERNAL_SIMPLE(x) ((x)->mmod == MMOD_EXTERNAL_SIMPLE)
@@ -185,6 +187,7 @@ i64_t ops_count_ones(b8_t *mask, i64_t len);
 i64_t ops_rank(obj_p *x, i64_t n);
 b8_t ops_eq_idx(obj_p a, i64_t ai, obj_p b, i64_t bi);
 obj_p index_find_i64(i64_t x[], i64_t xl, i64_t y[], i64_t yl);
+b8_t ops_is_asc(obj_p x);
 obj_p ops_where(b8_t *mask, i64_t n);
 obj_p sys_error(os_ray_error_type_t, lit_p msg);
 
@@ -27,6 +27,12 @@
 #include "error.h"
 #include "compose.h"
 #include "string.h"
+#include "eval.h"
+#include "items.h"
+#include "aggr.h"
+#include "filter.h"
+#include "unary.h"
+#include "binary.h"
 
 obj_p ray_iasc(obj_p x) {
     switch (x->type) {
@@ -276,13 +282,8 @@ obj_p ray_xasc(obj_p x, obj_p y) {
                 return clone_obj(x);
             }
 
-            i64_t nrow = AS_LIST(AS_LIST(x)[1])[0]->len;
-            obj_p idx = I64(nrow);
-            i64_t* indices = AS_I64(idx);
-            for (i64_t i = 0; i < nrow; i++)
-                indices[i] = i;
-
-            // Stable sort by each column from last to first, extracting only one column at a time
+            // Stable sort by each column from last to first, every pass orders the rows the previous one left
+            obj_p idx = NULL_OBJ;
             for (i64_t c = n - 1; c >= 0; c--) {
                 obj_p col_name = at_idx(y, c);
                 obj_p col = at_obj(x, col_name);
@@ -292,32 +293,13 @@ obj_p ray_xasc(obj_p x, obj_p y) {
                     return col;
                 }
 
-                obj_p col_reordered = at_obj(col, idx);
-                if (IS_ERR(col_reordered)) {
-                    drop_obj(col);
-                    drop_obj(idx);
-                    return col_reordered;
-                }
-                obj_p local_idx = ray_iasc(col_reordered);
+                obj_p rows = sort_rows(col, idx, 1);
                 drop_obj(col);
-                if (IS_ERR(local_idx)) {
-                    drop_obj(col_reordered);
-                    drop_obj(idx);
-                    return local_idx;
-                }
-
-                // Reorder indices according to local_idx
-                i64_t* local = AS_I64(local_idx);
-                obj_p obj_tmp = I64(nrow);
-                i64_t* tmp = AS_I64(obj_tmp);
-                for (i64_t i = 0; i < nrow; i++)
-                    tmp[i] = indices[local[i]];
-
-                memcpy(indices, tmp, sizeof(i64_t) * nrow);
+                drop_obj(idx);
+                if (IS_ERR(rows))
+                    return rows;
 
-                drop_obj(obj_tmp);
-                drop_obj(col_reordered);
-                drop_obj(local_idx);
+                idx = rows;
             }
 
             obj_p res = at_obj(x, idx);
@@ -364,13 +346,8 @@ obj_p ray_xdesc(obj_p x, obj_p y) {
                 return clone_obj(x);
             }
 
-            i64_t nrow = AS_LIST(AS_LIST(x)[1])[0]->len;
-            obj_p idx = I64(nrow);
-            i64_t* indices = AS_I64(idx);
-            for (i64_t i = 0; i < nrow; i++)
-                indices[i] = i;
-
-            // Stable sort by each column from last to first, extracting only one column at a time
+            // Stable sort by each column from last to first, every pass orders the rows the previous one left
+            obj_p idx = NULL_OBJ;
             for (i64_t c = n - 1; c >= 0; c--) {
                 obj_p col_name = at_idx(y, c);
                 obj_p col = at_obj(x, col_name);
@@ -380,32 +357,13 @@ obj_p ray_xdesc(obj_p x, obj_p y) {
                     return col;
                 }
 
-                obj_p col_reordered = at_obj(col, idx);
-                if (IS_ERR(col_reordered)) {
-                    drop_obj(col);
-                    drop_obj(idx);
-                    return col_reordered;
-                }
-                obj_p local_idx = ray_idesc(col_reordered);
+                obj_p rows = sort_rows(col, idx, -1);
                 drop_obj(col);
-                if (IS_ERR(local_idx)) {
-                    drop_obj(col_reordered);
-                    drop_obj(idx);
-                    return local_idx;
-                }
+                drop_obj(idx);
+                if (IS_ERR(rows))
+                    return rows;
 
-                // Reorder indices according to local_idx
-                i64_t* local = AS_I64(local_idx);
-                obj_p obj_tmp = I64(nrow);
-                i64_t* tmp = AS_I64(obj_tmp);
-                for (i64_t i = 0; i < nrow; i++)
-                    tmp[i] = indices[local[i]];
-                for (i64_t i = 0; i < nrow; i++)
-                    indices[i] = tmp[i];
-
-                drop_obj(obj_tmp);
-                drop_obj(col_reordered);
-                drop_obj(local_idx);
+                idx = rows;
             }
 
             obj_p res = at_obj(x, idx);
@@ -424,6 +382,146 @@ obj_p ray_xdesc(obj_p x, obj_p y) {
     }
 }
 
+// Sort function an expression calls, NULL if it is not a call of one
+static obj_p order_sort_fn(obj_p expr) {
+    obj_p car, *val;
+
+    if (expr->type != TYPE_LIST || (expr->len != 2 && expr->len != 3))
+        return NULL;
+
+    car = AS_LIST(expr)[0];
+    if (car->type == -TYPE_SYMBOL && !(car->attrs & ATTR_QUOTED)) {
+        val = resolve(car->i64);
+        if (val == NULL)
+            return NULL;
+        car = *val;
+    }
+
+    if (expr->len == 3 && car->type == TYPE_BINARY &&
+        (car->i64 == (i64_t)ray_xasc || car->i64 == (i64_t)ray_xdesc))
+        return car;
+
+    if (expr->len == 2 && car->type == TYPE_UNARY &&
+        (car->i64 == (i64_t)ray_iasc || car->i64 == (i64_t)ray_idesc || car->i64 == (i64_t)ray_asc ||
+         car->i64 == (i64_t)ray_desc))
+        return car;
+
+    return NULL;
+}
+
+static obj_p order_eval(obj_p expr) {
+    obj_p x, y;
+
+    x = eval(expr);
+    if (IS_ERR(x))
+        return x;
+
+    if (x->type == TYPE_MAPGROUP) {
+        y = aggr_collect(AS_LIST(x)[0], AS_LIST(x)[1]);
+        drop_obj(x);
+        return y;
+    }
+
+    if (x->type == TYPE_MAPFILTER) {
+        y = filter_collect(AS_LIST(x)[0], AS_LIST(x)[1]);
+        drop_obj(x);
+        return y;
+    }
+
+    return x;
+}
+
+// Rows a sort function would put first (or last), NULL_OBJ if its arguments are not sorted that way
+static obj_p order_top(i64_t fn, obj_p x, obj_p y, i64_t k) {
+    i64_t i, l, asc;
+    obj_p cols, col, name, res;
+
+    asc = (fn == (i64_t)ray_xasc || fn == (i64_t)ray_iasc || fn == (i64_t)ray_asc) ? 1 : -1;
+
+    if (fn != (i64_t)ray_xasc && fn != (i64_t)ray_xdesc)
+        return (x->attrs & (ATTR_ASC | ATTR_DESC)) ? NULL_OBJ : sort_top(&x, 1, k, asc);
+
+    if (x->type != TYPE_TABLE || (y->type != -TYPE_SYMBOL && (y->type != TYPE_SYMBOL || y->len == 0)))
+        return NULL_OBJ;
+
+    l = (y->type == -TYPE_SYMBOL) ? 1 : y->len;
+    cols = LIST(0);
+
+    for (i = 0; i < l; i++) {
+        name = (y->type == -TYPE_SYMBOL) ? clone_obj(y) : at_idx(y, i);
+        col = at_obj(x, name);
+        drop_obj(name);
+        if (IS_ERR(col)) {
+            drop_obj(cols);
+            return col;
+        }
+        push_obj(&cols, col);
+    }
+
+    res = sort_top(AS_LIST(cols), l, k, asc);
+    drop_obj(cols);
+
+    return res;
+}
+
+/*
+ * take of a sort: only the rows it keeps are found and ordered. Called by eval with the expressions of the
+ * arguments, NULL if the second one is not a sort, so that the call goes as usual.
+ */
+obj_p order_take(obj_p n, obj_p expr) {
+    obj_p fn, k, x, y, rows, res;
+
+    fn = order_sort_fn(expr);
+    if (fn == NULL)
+        return NULL;
+
+    k = order_eval(n);
+    if (IS_ERR(k))
+        return k;
+
+    x = order_eval(AS_LIST(expr)[1]);
+    if (IS_ERR(x)) {
+        drop_obj(k);
+        return x;
+    }
+
+    y = NULL_OBJ;
+    if (expr->len == 3) {
+        y = order_eval(AS_LIST(expr)[2]);
+        if (IS_ERR(y)) {
+            drop_obj(k);
+            drop_obj(x);
+            return y;
+        }
+    }
+
+    rows = (k->type == -TYPE_I64 && k->i64 != NULL_I64) ? order_top(fn->i64, x, y, k->i64) : NULL_OBJ;
+
+    if (IS_ERR(rows)) {
+        res = rows;
+    } else if (rows == NULL_OBJ) {
+        res = (expr->len == 3) ? binary_call(fn, x, y) : unary_call(fn, x);
+        if (!IS_ERR(res)) {
+            rows = res;
+            res = ray_take(k, rows);
+            drop_obj(rows);
+        }
+    } else if (fn->i64 == (i64_t)ray_iasc || fn->i64 == (i64_t)ray_idesc) {
+        res = rows;
+    } else {
+        res = at_obj(x, rows);
+        drop_obj(rows);
+        if (res->type != TYPE_TABLE)
+            res->attrs |= (fn->i64 == (i64_t)ray_asc) ? ATTR_ASC : ATTR_DESC;
+    }
+
+    drop_obj(k);
+    drop_obj(x);
+    drop_obj(y);
+
+    return res;
+}
+
 obj_p ray_not(obj_p x) {
     i32_t i;
     i64_t l;
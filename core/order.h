@@ -34,5 +34,6 @@ obj_p ray_xasc(obj_p x, obj_p y);
 obj_p ray_xdesc(obj_p x, obj_p y);
 obj_p ray_not(obj_p x);
 obj_p ray_neg(obj_p x);
+obj_p order_take(obj_p n, obj_p expr);
 
 #endif  // ORDER_H
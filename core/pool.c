@@ -31,113 +31,149 @@
 #include "eval.h"
 #include "string.h"
 
-#define DEFAULT_MPMC_SIZE 2048
+#define DEFAULT_DEQUE_SIZE 1024
+#define DEFAULT_GROUP_SIZE 256
 #define POOL_SPLIT_THRESHOLD (RAY_PAGE_SIZE * 4)
-#define GROUP_SPLIT_THRESHOLD 100000
+#define POOL_SPIN_ROUNDS 32  // Idle rounds (half spinning, half yielding) before parking
 
-mpmc_p mpmc_create(i64_t size) {
-    size = next_power_of_two_u64(size);
+deque_buf_p deque_buf_create(i64_t size) {
+    deque_buf_p buf;
 
-    i64_t i;
-    mpmc_p queue;
-    cell_p buf;
-
-    queue = (mpmc_p)heap_mmap(sizeof(struct mpmc_t));
+    buf = (deque_buf_p)heap_mmap(sizeof(struct deque_buf_t) + size * sizeof(task_p));
 
-    if (queue == NULL)
+    if (buf == NULL)
         return NULL;
 
-    buf = (cell_p)heap_mmap(size * sizeof(struct cell_t));
+    buf->mask = size - 1;
+    buf->prev = NULL;
 
-    if (buf == NULL)
+    return buf;
+}
+
+nil_t deque_buf_destroy(deque_buf_p buf) {
+    heap_unmap(buf, sizeof(struct deque_buf_t) + (buf->mask + 1) * sizeof(task_p));
+}
+
+deque_p deque_create(i64_t size) {
+    deque_p deque;
+
+    deque = (deque_p)heap_mmap(sizeof(struct deque_t));
+
+    if (deque == NULL)
         return NULL;
 
-    for (i = 0; i < (i64_t)size; i += 1)
-        __atomic_store_n(&buf[i].seq, i, __ATOMIC_RELAXED);
+    deque->buf = deque_buf_create(next_power_of_two_u64(size));
 
-    queue->buf = buf;
-    queue->mask = size - 1;
+    if (deque->buf == NULL) {
+        heap_unmap(deque, sizeof(struct deque_t));
+        return NULL;
+    }
 
-    __atomic_store_n(&queue->tail, 0, __ATOMIC_RELAXED);
-    __atomic_store_n(&queue->head, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->top, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, 0, __ATOMIC_RELAXED);
 
-    return queue;
+    return deque;
 }
 
-nil_t mpmc_destroy(mpmc_p queue) {
-    if (queue->buf)
-        heap_unmap(queue->buf, (queue->mask + 1) * sizeof(struct cell_t));
+// Free buffers retired by growth, must be called only when no thief can access the deque (on destroy)
+nil_t deque_reclaim(deque_p deque) {
+    deque_buf_p buf, prev;
+
+    buf = deque->buf->prev;
+    deque->buf->prev = NULL;
 
-    heap_unmap(queue, sizeof(struct mpmc_t));
+    while (buf != NULL) {
+        prev = buf->prev;
+        deque_buf_destroy(buf);
+        buf = prev;
+    }
 }
 
-i64_t mpmc_push(mpmc_p queue, task_data_t data) {
-    cell_p cell;
-    i64_t pos, seq, dif;
-    i64_t rounds = 0;
+nil_t deque_destroy(deque_p deque) {
+    deque_reclaim(deque);
+    deque_buf_destroy(deque->buf);
+    heap_unmap(deque, sizeof(struct deque_t));
+}
 
-    pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+// Owner only
+nil_t deque_push(deque_p deque, task_p task) {
+    i64_t i, t, b;
+    deque_buf_p buf, grown;
 
-    for (;;) {
-        cell = &queue->buf[pos & queue->mask];
-        seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
-
-        dif = seq - pos;
-        if (dif == 0) {
-            if (__atomic_compare_exchange_n(&queue->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
-                break;
-        } else if (dif < 0)
-            return -1;
-        else {
-            backoff_spin(&rounds);
-            pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
-        }
-    }
+    b = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    t = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    buf = __atomic_load_n(&deque->buf, __ATOMIC_RELAXED);
+
+    if (b - t > buf->mask) {
+        grown = deque_buf_create((buf->mask + 1) * 2);
+
+        if (grown == NULL)
+            PANIC("Deque push: oom");
+
+        for (i = t; i < b; i++)
+            grown->cells[i & grown->mask] = __atomic_load_n(&buf->cells[i & buf->mask], __ATOMIC_RELAXED);
 
-    cell->data = data;
-    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+        // thieves may still read the old buffer, so keep it until the pool is quiescent
+        grown->prev = buf;
+        __atomic_store_n(&deque->buf, grown, __ATOMIC_RELEASE);
+        buf = grown;
+    }
 
-    return 0;
+    __atomic_store_n(&buf->cells[b & buf->mask], task, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
 }
 
-task_data_t mpmc_pop(mpmc_p queue) {
-    cell_p cell;
-    task_data_t data = {.id = -1,
-                        .fn = NULL,
-                        .argc = 0,
-                        .argv = {NULL},  // Initialize the array elements
-                        .result = NULL_OBJ};
-    i64_t pos, seq, dif;
-    i64_t rounds = 0;
+// Owner only
+task_p deque_pop(deque_p deque) {
+    i64_t t, b;
+    deque_buf_p buf;
+    task_p task;
 
-    pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    b = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    buf = __atomic_load_n(&deque->buf, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    t = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
 
-    for (;;) {
-        cell = &queue->buf[pos & queue->mask];
-        seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
-        dif = seq - (pos + 1);
-        if (dif == 0) {
-            if (__atomic_compare_exchange_n(&queue->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
-                break;
-        } else if (dif < 0)
-            return data;
-        else {
-            backoff_spin(&rounds);
-            pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
-        }
+    if (t > b) {
+        __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
     }
 
-    data = cell->data;
-    __atomic_store_n(&cell->seq, pos + queue->mask + 1, __ATOMIC_RELEASE);
+    task = __atomic_load_n(&buf->cells[b & buf->mask], __ATOMIC_RELAXED);
 
-    return data;
-}
+    // last element: race against thieves
+    if (t == b) {
+        if (!__atomic_compare_exchange_n(&deque->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            task = NULL;
+        __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+    }
 
-i64_t mpmc_count(mpmc_p queue) {
-    return __atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST) - __atomic_load_n(&queue->head, __ATOMIC_SEQ_CST);
+    return task;
 }
 
-i64_t mpmc_size(mpmc_p queue) { return queue->mask + 1; }
+// Any thread, returns NULL if the deque is empty or the race was lost
+task_p deque_steal(deque_p deque) {
+    i64_t t, b;
+    deque_buf_p buf;
+    task_p task;
+
+    t = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    b = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+
+    if (t >= b)
+        return NULL;
+
+    buf = __atomic_load_n(&deque->buf, __ATOMIC_ACQUIRE);
+    task = __atomic_load_n(&buf->cells[t & buf->mask], __ATOMIC_RELAXED);
+
+    if (!__atomic_compare_exchange_n(&deque->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return NULL;
+
+    return task;
+}
 
 obj_p pool_call_task_fn(raw_p fn, i64_t argc, raw_p argv[]) {
     switch (argc) {
@@ -164,54 +200,154 @@ obj_p pool_call_task_fn(raw_p fn, i64_t argc, raw_p argv[]) {
     }
 }
 
+__thread worker_p __WORKER = NULL;
+
+static inline deque_p pool_victim(pool_p pool, i64_t i) {
+    return (i == 0) ? pool->main.deque : pool->executors[i - 1].worker.deque;
+}
+
+// Pop a task from own deque or steal one from the others
+task_p pool_find_task(pool_p pool, worker_p worker) {
+    i64_t i, n, v;
+    deque_p victim;
+    task_p task;
+
+    task = deque_pop(worker->deque);
+
+    if (task == NULL && __atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) > 0) {
+        n = pool->executors_count + 1;
+        v = worker->seed++;
+
+        for (i = 0; i < n && task == NULL; i++) {
+            victim = pool_victim(pool, (v + i) % n);
+            if (victim != worker->deque)
+                task = deque_steal(victim);
+        }
+    }
+
+    if (task != NULL)
+        __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_RELAXED);
+
+    return task;
+}
+
+nil_t pool_exec_task(pool_p pool, task_p task) {
+    task_group_p group = task->group;
+
+    task->result = pool_call_task_fn(task->fn, task->argc, task->argv);
+
+    if (__atomic_sub_fetch(&group->pending, 1, __ATOMIC_SEQ_CST) == 0 &&
+        __atomic_load_n(&pool->waiters, __ATOMIC_SEQ_CST) > 0) {
+        mutex_lock(&pool->mutex);
+        cond_broadcast(&pool->done);
+        mutex_unlock(&pool->mutex);
+    }
+}
+
+// Wait for a work to appear: spin, then yield, then park. Returns B8_FALSE if the pool is stopped
+b8_t pool_idle(pool_p pool) {
+    i64_t i, rounds = 0;
+    b8_t running;
+
+    for (i = 0; i < POOL_SPIN_ROUNDS; i++) {
+        if (__atomic_load_n(&pool->queued, __ATOMIC_ACQUIRE) > 0)
+            return B8_TRUE;
+
+        if (__atomic_load_n(&pool->state, __ATOMIC_ACQUIRE) == RUN_STATE_STOPPED)
+            return B8_FALSE;
+
+        if (i < POOL_SPIN_ROUNDS / 2)
+            backoff_spin(&rounds);
+        else
+            thread_yield();
+    }
+
+    mutex_lock(&pool->mutex);
+    __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0 && pool->state == RUN_STATE_RUNNING)
+        cond_wait(&pool->run, &pool->mutex);
+
+    __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+    running = (pool->state == RUN_STATE_RUNNING);
+    mutex_unlock(&pool->mutex);
+
+    return running;
+}
+
+// Wake parked executors to pick up n new tasks
+nil_t pool_wake(pool_p pool, i64_t n) {
+    i64_t i, sleepers;
+
+    sleepers = __atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST);
+
+    if (sleepers == 0 || n <= 0)
+        return;
+
+    mutex_lock(&pool->mutex);
+
+    if (n >= sleepers)
+        cond_broadcast(&pool->run);
+    else {
+        for (i = 0; i < n; i++)
+            cond_signal(&pool->run);
+    }
+
+    mutex_unlock(&pool->mutex);
+}
+
+nil_t worker_init(worker_p worker, i64_t seed) {
+    i64_t i;
+
+    worker->deque = deque_create(DEFAULT_DEQUE_SIZE);
+    worker->seed = seed;
+    worker->depth = 0;
+
+    for (i = 0; i < POOL_MAX_DEPTH; i++) {
+        worker->groups[i].count = 0;
+        worker->groups[i].capacity = 0;
+        worker->groups[i].pending = 0;
+        worker->groups[i].tasks = NULL;
+    }
+}
+
+nil_t worker_destroy(worker_p worker) {
+    i64_t i;
+
+    for (i = 0; i < POOL_MAX_DEPTH; i++) {
+        if (worker->groups[i].tasks != NULL)
+            heap_unmap(worker->groups[i].tasks, worker->groups[i].capacity * sizeof(task_data_t));
+    }
+
+    deque_destroy(worker->deque);
+}
+
 raw_p executor_run(raw_p arg) {
     executor_t *executor = (executor_t *)arg;
-    task_data_t data;
-    i64_t i, tasks_count;
-    obj_p res;
+    pool_p pool = executor->pool;
     interpreter_p interpreter;
     heap_p heap;
+    task_p task;
 
     rc_sync_set(B8_TRUE);
 
+    __WORKER = &executor->worker;
     heap = heap_create(executor->id + 1);
     interpreter = interpreter_create(executor->id + 1);
 
     __atomic_store_n(&executor->heap, heap, __ATOMIC_RELAXED);
-    __atomic_store_n(&executor->interpreter, interpreter, __ATOMIC_RELAXED);
+    __atomic_store_n(&executor->interpreter, interpreter, __ATOMIC_RELEASE);
 
     for (;;) {
-        mutex_lock(&executor->pool->mutex);
-        cond_wait(&executor->pool->run, &executor->pool->mutex);
-
-        if (executor->pool->state == RUN_STATE_STOPPED) {
-            mutex_unlock(&executor->pool->mutex);
-            break;
-        }
-
-        tasks_count = executor->pool->tasks_count;
-        mutex_unlock(&executor->pool->mutex);
-
-        // process tasks
-        for (i = 0; i < tasks_count; i++) {
-            data = mpmc_pop(executor->pool->task_queue);
-
-            // Nothing to do
-            if (data.id == -1)
-                break;
+        task = pool_find_task(pool, &executor->worker);
 
-            // execute task
-            res = pool_call_task_fn(data.fn, data.argc, data.argv);
-            data.result = res;
-            mpmc_push(executor->pool->result_queue, data);
+        if (task != NULL) {
+            pool_exec_task(pool, task);
+            continue;
         }
 
-        if (i > 0) {
-            mutex_lock(&executor->pool->mutex);
-            executor->pool->done_count += i;
-            cond_signal(&executor->pool->done);
-            mutex_unlock(&executor->pool->mutex);
-        }
+        if (!pool_idle(pool))
+            break;
     }
 
     interpreter_destroy();
@@ -226,21 +362,24 @@ pool_p pool_create(i64_t executors_count) {
 
     pool = (pool_p)heap_mmap(sizeof(struct pool_t) + (sizeof(executor_t) * executors_count));
     pool->executors_count = executors_count;
-    pool->done_count = 0;
-    pool->tasks_count = 0;
-    pool->task_queue = mpmc_create(DEFAULT_MPMC_SIZE);
-    pool->result_queue = mpmc_create(DEFAULT_MPMC_SIZE);
+    pool->sleepers = 0;
+    pool->waiters = 0;
+    pool->queued = 0;
     pool->state = RUN_STATE_RUNNING;
     pool->mutex = mutex_create();
     pool->run = cond_create();
     pool->done = cond_create();
-    mutex_lock(&pool->mutex);
+    worker_init(&pool->main, 0);
 
     for (i = 0; i < executors_count; i++) {
         pool->executors[i].id = i;
         pool->executors[i].pool = pool;
         pool->executors[i].heap = NULL;
         pool->executors[i].interpreter = NULL;
+        worker_init(&pool->executors[i].worker, i + 1);
+    }
+
+    for (i = 0; i < executors_count; i++) {
         pool->executors[i].handle = ray_thread_create(executor_run, &pool->executors[i]);
         if (thread_pin(pool->executors[i].handle, i + 1) != 0)
             printf("Pool create: failed to pin thread %lld\n", i + 1);
@@ -249,11 +388,11 @@ pool_p pool_create(i64_t executors_count) {
     if (thread_pin(thread_self(), 0) != 0)
         printf("Pool create: failed to pin main thread\n");
 
-    mutex_unlock(&pool->mutex);
+    __WORKER = &pool->main;
 
     // Now ensure that all threads are running
     for (i = 0; i < executors_count; i++) {
-        while (__atomic_load_n(&pool->executors[i].interpreter, __ATOMIC_RELAXED) == NULL)
+        while (__atomic_load_n(&pool->executors[i].interpreter, __ATOMIC_ACQUIRE) == NULL)
             backoff_spin(&rounds);
     }
 
@@ -264,7 +403,7 @@ nil_t pool_destroy(pool_p pool) {
     i64_t i, n;
 
     mutex_lock(&pool->mutex);
-    pool->state = RUN_STATE_STOPPED;
+    __atomic_store_n(&pool->state, RUN_STATE_STOPPED, __ATOMIC_RELEASE);
     cond_broadcast(&pool->run);
     mutex_unlock(&pool->mutex);
 
@@ -272,13 +411,16 @@ nil_t pool_destroy(pool_p pool) {
     for (i = 0; i < n; i++) {
         if (thread_join(pool->executors[i].handle) != 0)
             printf("Pool destroy: failed to join thread %lld\n", i);
+        worker_destroy(&pool->executors[i].worker);
     }
 
     mutex_destroy(&pool->mutex);
     cond_destroy(&pool->run);
     cond_destroy(&pool->done);
-    mpmc_destroy(pool->task_queue);
-    mpmc_destroy(pool->result_queue);
+    worker_destroy(&pool->main);
+
+    if (__WORKER == &pool->main)
+        __WORKER = NULL;
 
     heap_unmap(pool, sizeof(struct pool_t) + sizeof(executor_t) * pool->executors_count);
 }
@@ -288,141 +430,174 @@ pool_p pool_get(nil_t) { return runtime_get()->pool; }
 nil_t pool_prepare(pool_p pool) {
     i64_t i, n;
     obj_p env;
+    worker_p worker;
+    task_group_p group;
 
     if (pool == NULL)
         PANIC("Pool prepare: pool is NULL");
 
-    env = interpreter_env_get();
+    worker = __WORKER;
 
-    mutex_lock(&pool->mutex);
+    if (worker == NULL || worker->depth >= POOL_MAX_DEPTH)
+        PANIC("Pool prepare: nesting is too deep");
+
+    group = &worker->groups[worker->depth++];
+    group->count = 0;
 
-    pool->tasks_count = 0;
-    pool->done_count = 0;
+    // nested group: executors are already running with their environment
+    if (worker != &pool->main || worker->depth > 1)
+        return;
 
+    env = interpreter_env_get();
+
+    // executors are idle between root runs, so their heaps and stacks are safe to touch
     n = pool->executors_count;
     for (i = 0; i < n; i++) {
         heap_borrow(pool->executors[i].heap);
         interpreter_env_set(pool->executors[i].interpreter, clone_obj(env));
     }
+}
 
-    mutex_unlock(&pool->mutex);
+nil_t pool_group_add(task_group_p group, raw_p fn, i64_t argc, va_list args) {
+    i64_t i, capacity;
+    task_data_t *tasks;
+    task_p task;
+
+    // tasks are not visible to other threads until the group runs, so just grow the array
+    if (group->count == group->capacity) {
+        capacity = (group->capacity == 0) ? DEFAULT_GROUP_SIZE : group->capacity * 2;
+        tasks = (task_data_t *)heap_mmap(capacity * sizeof(task_data_t));
+
+        if (tasks == NULL)
+            PANIC("Pool add task: oom");
+
+        if (group->tasks != NULL) {
+            memcpy(tasks, group->tasks, group->count * sizeof(task_data_t));
+            heap_unmap(group->tasks, group->capacity * sizeof(task_data_t));
+        }
+
+        group->tasks = tasks;
+        group->capacity = capacity;
+    }
+
+    task = &group->tasks[group->count];
+    task->id = group->count++;
+    task->fn = fn;
+    task->argc = argc;
+    task->result = NULL_OBJ;
+    task->group = group;
+
+    for (i = 0; i < argc; i++)
+        task->argv[i] = va_arg(args, raw_p);
 }
 
 nil_t pool_add_task(pool_p pool, raw_p fn, i64_t argc, ...) {
-    i64_t i, size;
     va_list args;
-    task_data_t data, old_data;
-    mpmc_p queue;
+    worker_p worker;
 
     if (pool == NULL)
         PANIC("Pool add task: pool is NULL");
 
-    mutex_lock(&pool->mutex);
+    worker = __WORKER;
 
-    data.id = pool->tasks_count++;
-    data.fn = fn;
-    data.argc = argc;
+    if (worker == NULL || worker->depth == 0)
+        PANIC("Pool add task: pool is not prepared");
 
     va_start(args, argc);
+    pool_group_add(&worker->groups[worker->depth - 1], fn, argc, args);
+    va_end(args);
+}
 
-    for (i = 0; i < argc; i++)
-        data.argv[i] = va_arg(args, raw_p);
+// Publish the group's tasks on the worker's deque and help executing tasks (of any group) until all of the group's
+// tasks are done
+nil_t pool_group_wait(pool_p pool, task_group_p group, worker_p worker) {
+    i64_t i, n, spins = 0, rounds = 0;
+    task_p task;
 
-    va_end(args);
+    n = group->count;
+    __atomic_store_n(&group->pending, n, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&pool->queued, n, __ATOMIC_SEQ_CST);
+
+    for (i = 0; i < n; i++)
+        deque_push(worker->deque, &group->tasks[i]);
+
+    pool_wake(pool, n - 1);
+
+    while (__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE) > 0) {
+        task = pool_find_task(pool, worker);
 
-    if (mpmc_push(pool->task_queue, data) == -1)  // queue is full
-    {
-        size = pool->tasks_count * 2;
-        // Grow task queue
-        queue = mpmc_create(size);
-
-        for (;;) {
-            old_data = mpmc_pop(pool->task_queue);
-            if (old_data.id == -1)
-                break;
-            mpmc_push(queue, old_data);
+        if (task != NULL) {
+            pool_exec_task(pool, task);
+            spins = 0;
+            rounds = 0;
+            continue;
         }
 
-        if (mpmc_push(queue, data) == -1)
-            PANIC("Pool add task: oom");
+        if (spins++ < POOL_SPIN_ROUNDS) {
+            backoff_spin(&rounds);
+            continue;
+        }
 
-        mpmc_destroy(pool->task_queue);
-        pool->task_queue = queue;
-        // Grow result queue
-        mpmc_destroy(pool->result_queue);
-        pool->result_queue = mpmc_create(size);
-    }
+        // nothing to steal, the rest of the group is in flight: park until it completes
+        mutex_lock(&pool->mutex);
+        __atomic_add_fetch(&pool->waiters, 1, __ATOMIC_SEQ_CST);
 
-    mutex_unlock(&pool->mutex);
+        while (__atomic_load_n(&group->pending, __ATOMIC_SEQ_CST) > 0)
+            cond_wait(&pool->done, &pool->mutex);
+
+        __atomic_sub_fetch(&pool->waiters, 1, __ATOMIC_SEQ_CST);
+        mutex_unlock(&pool->mutex);
+    }
 }
 
 obj_p pool_run(pool_p pool) {
-    i64_t i, n, tasks_count, executors_count;
+    i64_t i, n, tasks_count;
     obj_p e, res;
-    task_data_t data;
+    b8_t root;
+    worker_p worker;
+    task_group_p group;
 
     if (pool == NULL)
         PANIC("Pool run: pool is NULL");
 
-    mutex_lock(&pool->mutex);
-
-    rc_sync_set(B8_TRUE);
-
-    tasks_count = pool->tasks_count;
-    executors_count = pool->executors_count;
+    worker = __WORKER;
 
-    // wake up needed executors
-    if (executors_count < tasks_count) {
-        for (i = 0; i < executors_count; i++)
-            cond_signal(&pool->run);
-    } else
-        cond_broadcast(&pool->run);
-
-    mutex_unlock(&pool->mutex);
-
-    // process tasks on self too
-    for (i = 0; i < tasks_count; i++) {
-        data = mpmc_pop(pool->task_queue);
+    if (worker == NULL || worker->depth == 0)
+        PANIC("Pool run: pool is not prepared");
 
-        // Nothing to do
-        if (data.id == -1)
-            break;
-
-        // execute task
-        res = pool_call_task_fn(data.fn, data.argc, data.argv);
-        data.result = res;
-        mpmc_push(pool->result_queue, data);
-    }
-
-    mutex_lock(&pool->mutex);
+    group = &worker->groups[worker->depth - 1];
+    root = (worker == &pool->main && worker->depth == 1);
 
-    pool->done_count += i;
+    if (root)
+        rc_sync_set(B8_TRUE);
 
-    // wait for all tasks to be done
-    while (pool->done_count < tasks_count)
-        cond_wait(&pool->done, &pool->mutex);
+    pool_group_wait(pool, group, worker);
 
     // collect results
+    tasks_count = group->count;
     res = LIST(tasks_count);
 
-    for (i = 0; i < tasks_count; i++) {
-        data = mpmc_pop(pool->result_queue);
-        if (data.id < 0 || data.id >= (i64_t)tasks_count)
-            PANIC("Pool run: corrupted data: %lld\n", data.id);
+    for (i = 0; i < tasks_count; i++)
+        AS_LIST(res)[i] = group->tasks[i].result;
 
-        ins_obj(&res, data.id, data.result);
-    }
+    group->count = 0;
+    worker->depth--;
 
-    // merge heaps
-    n = pool->executors_count;
-    for (i = 0; i < n; i++) {
-        heap_merge(pool->executors[i].heap);
-        interpreter_env_unset(pool->executors[i].interpreter);
-    }
+    // all tasks are done and executors are idle: merge heaps, then free blocks that crossed threads (their buddies
+    // may be in any of the merged heaps)
+    if (root) {
+        n = pool->executors_count;
+        for (i = 0; i < n; i++)
+            heap_merge(pool->executors[i].heap);
 
-    rc_sync_set(B8_FALSE);
+        for (i = 0; i < n; i++) {
+            heap_release_foreign(pool->executors[i].heap);
+            interpreter_env_unset(pool->executors[i].interpreter);
+        }
 
-    mutex_unlock(&pool->mutex);
+        heap_release_foreign(heap_get());
+        rc_sync_set(B8_FALSE);
+    }
 
     // Check res for errors
     for (i = 0; i < tasks_count; i++) {
@@ -436,22 +611,44 @@ obj_p pool_run(pool_p pool) {
     return res;
 }
 
+// Nested splits (inside of a task) are worth it only while there are not enough queued tasks to keep everyone busy
+static inline b8_t pool_can_nest(pool_p pool) {
+    worker_p worker = __WORKER;
+
+    if (worker == NULL || worker->depth >= POOL_MAX_DEPTH)
+        return B8_FALSE;
+
+    if (rc_sync_get())
+        return __atomic_load_n(&pool->queued, __ATOMIC_RELAXED) < pool->executors_count;
+
+    return B8_TRUE;
+}
+
 i64_t pool_split_by(pool_p pool, i64_t input_len, i64_t groups_len) {
     if (pool == NULL || input_len < POOL_SPLIT_THRESHOLD)
         return 1;
-    else if (rc_sync_get())
-        return 1;
     else if (input_len <= pool->executors_count + 1)
         return 1;
     else if (groups_len >= GROUP_SPLIT_THRESHOLD)
         return 1;
+    else if (!pool_can_nest(pool))
+        return 1;
     else
         return pool->executors_count + 1;
 }
 
+i64_t pool_split_tasks(pool_p pool, i64_t tasks_len) {
+    if (pool == NULL || tasks_len < 2)
+        return 1;
+    else if (!pool_can_nest(pool))
+        return 1;
+    else
+        return (tasks_len < pool->executors_count + 1) ? tasks_len : pool->executors_count + 1;
+}
+
 i64_t pool_get_executors_count(pool_p pool) {
     if (pool == NULL)
         return 1;
     else
         return pool->executors_count + 1;
-}
\ No newline at end of file
+}
@@ -30,6 +30,8 @@
 #include "eval.h"
 
 #define CACHELINE_SIZE 64
+#define POOL_MAX_DEPTH 8  // Maximum nesting of task groups per thread
+#define GROUP_SPLIT_THRESHOLD 100000  // Above this many groups per-task partial tables are not worth it
 
 typedef c8_t cachepad_t[CACHELINE_SIZE];
 
@@ -43,29 +45,51 @@ typedef obj_p (*fn6)(raw_p, raw_p, raw_p, raw_p, raw_p, raw_p);
 typedef obj_p (*fn7)(raw_p, raw_p, raw_p, raw_p, raw_p, raw_p, raw_p);
 typedef obj_p (*fn8)(raw_p, raw_p, raw_p, raw_p, raw_p, raw_p, raw_p, raw_p);
 
+typedef struct task_group_t *task_group_p;
+
 typedef struct {
     i64_t id;
     raw_p fn;
     i64_t argc;
     raw_p argv[8];
     obj_p result;
+    task_group_p group;  // Group the task belongs to
 } task_data_t;
 
-typedef struct cell_t {
-    i64_t seq;
-    task_data_t data;
-} *cell_p;
+typedef task_data_t *task_p;
 
-typedef struct mpmc_t {
-    cachepad_t pad0;
-    cell_p buf;
+// Chase-Lev work-stealing deque: the owner pushes and pops at the bottom, thieves steal from the top
+typedef struct deque_buf_t {
     i64_t mask;
+    struct deque_buf_t *prev;  // Retired buffer (freed once the pool is quiescent)
+    task_p cells[];
+} *deque_buf_p;
+
+typedef struct deque_t {
+    cachepad_t pad0;
+    i64_t top;
     cachepad_t pad1;
-    i64_t tail;
+    i64_t bottom;
     cachepad_t pad2;
-    i64_t head;
+    deque_buf_p buf;
     cachepad_t pad3;
-} *mpmc_p;
+} *deque_p;
+
+// A batch of tasks submitted together and awaited together
+typedef struct task_group_t {
+    i64_t count;         // Number of tasks in the group
+    i64_t capacity;      // Capacity of the tasks array
+    i64_t pending;       // Number of tasks not completed yet
+    task_data_t *tasks;  // Group's tasks (stable while the group runs)
+} task_group_t;
+
+// Scheduling state of a thread taking part in the pool (main thread or executor)
+typedef struct worker_t {
+    deque_p deque;                        // Worker's deque
+    i64_t seed;                           // Victim selection seed
+    i64_t depth;                          // Number of groups being prepared/run by the worker
+    task_group_t groups[POOL_MAX_DEPTH];  // Stack of nested groups
+} *worker_p;
 
 typedef struct pool_t *pool_p;
 
@@ -76,19 +100,20 @@ typedef struct {
     heap_p heap;                // Executor's heap
     interpreter_p interpreter;  // Executor's interpreter
     pool_p pool;                // Executor's pool
+    struct worker_t worker;     // Executor's scheduling state
     ray_thread_t handle;        // Executor's thread handle
 } executor_t;
 
 typedef struct pool_t {
-    mutex_t mutex;           // Mutex for condition variable
+    mutex_t mutex;           // Mutex for parking executors
     cond_t run;              // Condition variable for run executors
-    cond_t done;             // Condition variable for signal that executor is done
+    cond_t done;             // Condition variable for signal that group is done
     run_state_t state;       // Pool's state
-    i64_t done_count;        // Number of done executors
+    i64_t sleepers;          // Number of parked executors
+    i64_t waiters;           // Number of threads parked on a group completion
+    i64_t queued;            // Number of tasks pushed and not taken yet
     i64_t executors_count;   // Number of executors
-    i64_t tasks_count;       // Number of tasks
-    mpmc_p task_queue;       // Pool's task queue
-    mpmc_p result_queue;     // Pool's result queue
+    struct worker_t main;    // Main thread's scheduling state
     executor_t executors[];  // Array of executors
 } *pool_p;
 
@@ -100,6 +125,7 @@ nil_t pool_add_task(pool_p pool, raw_p fn, i64_t argc, ...);
 obj_p pool_call_task_fn(raw_p fn, i64_t argc, raw_p argv[]);
 obj_p pool_run(pool_p pool);
 i64_t pool_split_by(pool_p pool, i64_t input_len, i64_t groups_len);
+i64_t pool_split_tasks(pool_p pool, i64_t tasks_len);
 i64_t pool_get_executors_count(pool_p pool);
 
 #endif  // POOL_H
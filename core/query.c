@@ -34,6 +34,16 @@
 #include "filter.h"
 #include "chrono.h"
 #include "runtime.h"
+#include "math.h"
+#include "misc.h"
+#include "logic.h"
+#include "format.h"
+#include "serde.h"
+#include "pool.h"
+#include "cmp.h"
+#include "zone.h"
+#include "grouped.h"
+#include "order.h"
 
 obj_p remap_filter(obj_p tab, obj_p index) { return filter_map(tab, index); }
 
@@ -43,7 +53,10 @@ obj_p remap_group(obj_p *gvals, obj_p cols, obj_p gkeys, obj_p gcols, query_ctx_
 
     switch (gkeys->type) {
         case -TYPE_SYMBOL:
-            index = index_group(cols, ctx->filter);
+            // a grouped column has its groups at hand
+            index = grouped_group(cols, ctx->filter);
+            if (index == NULL_OBJ)
+                index = index_group(cols, ctx->filter);
             timeit_tick("build index");
 
             if (IS_ERR(index))
@@ -180,6 +193,7 @@ nil_t query_ctx_init(query_ctx_p ctx) {
     ctx->tablen = 0;
     ctx->table = NULL_OBJ;
     ctx->take = NULL_OBJ;
+    ctx->limit = 0;
     ctx->filter = NULL_OBJ;
     ctx->group_fields = NULL_OBJ;
     ctx->group_values = NULL_OBJ;
@@ -203,6 +217,8 @@ nil_t query_ctx_destroy(query_ctx_p ctx) {
     drop_obj(ctx->group_index);
 }
 
+static i64_t select_limit(obj_p obj, query_ctx_p ctx);
+
 obj_p select_fetch_table(obj_p obj, query_ctx_p ctx) {
     obj_p prm, val;
 
@@ -235,6 +251,7 @@ obj_p select_fetch_table(obj_p obj, query_ctx_p ctx) {
             return val;
 
         ctx->take = val;
+        ctx->limit = select_limit(obj, ctx);
     }
 
     timeit_tick("fetch table");
@@ -242,13 +259,426 @@ obj_p select_fetch_table(obj_p obj, query_ctx_p ctx) {
     return NULL_OBJ;
 }
 
+static obj_p select_resolve_fn(obj_p car);
+static obj_p select_field(obj_p obj, obj_p fields, i64_t i);
+static b8_t select_refs_rows(obj_p expr, obj_p cols, i64_t psym);
+
+// Index of a column known to be sorted an expression names, NULL_I64 if it is not one
+static i64_t select_sorted_column(obj_p expr, obj_p tab) {
+    i64_t c;
+
+    if (expr->type != -TYPE_SYMBOL || (expr->attrs & ATTR_QUOTED))
+        return NULL_I64;
+
+    c = find_raw(AS_LIST(tab)[0], &expr->i64);
+    if (c == NULL_I64 || !(AS_LIST(AS_LIST(tab)[1])[c]->attrs & ATTR_ASC))
+        return NULL_I64;
+
+    return c;
+}
+
+/*
+ * Rows [from, to) a condition selects out of a sorted column: (op column value), (op value column) or
+ * (within column value), with a value not depending on the rows. Returns B8_FALSE for any other condition.
+ */
+static b8_t select_sorted_range(obj_p cond, obj_p tab, i64_t *from, i64_t *to) {
+    i64_t c, i, lo, hi;
+    zone_op_t op = ZONE_OP_EQ;
+    b8_t ok;
+    obj_p car, col, val, bound;
+    binary_f fn;
+
+    if (cond->type != TYPE_LIST || cond->len != 3)
+        return B8_FALSE;
+
+    car = select_resolve_fn(AS_LIST(cond)[0]);
+    if (car->type != TYPE_BINARY)
+        return B8_FALSE;
+
+    fn = (binary_f)car->i64;
+    if (fn == ray_eq)
+        op = ZONE_OP_EQ;
+    else if (fn == ray_lt)
+        op = ZONE_OP_LT;
+    else if (fn == ray_gt)
+        op = ZONE_OP_GT;
+    else if (fn == ray_le)
+        op = ZONE_OP_LE;
+    else if (fn == ray_ge)
+        op = ZONE_OP_GE;
+    else if (fn != ray_within)
+        return B8_FALSE;
+
+    i = 2;
+    c = select_sorted_column(AS_LIST(cond)[1], tab);
+    if (c == NULL_I64 && fn != ray_within) {
+        i = 1;
+        c = select_sorted_column(AS_LIST(cond)[2], tab);
+        op = zone_flip(op);
+    }
+
+    if (c == NULL_I64 || select_refs_rows(AS_LIST(cond)[i], AS_LIST(tab)[0], NULL_I64))
+        return B8_FALSE;
+
+    col = AS_LIST(AS_LIST(tab)[1])[c];
+    val = eval(AS_LIST(cond)[i]);
+
+    if (fn != ray_within)
+        ok = cmp_range(col, val, op, from, to);
+    else if (val->type > TYPE_LIST && val->type < TYPE_ENUM && val->len == 2) {
+        bound = at_idx(val, 0);
+        ok = cmp_range(col, bound, ZONE_OP_GE, from, &hi);
+        drop_obj(bound);
+
+        bound = at_idx(val, 1);
+        ok = ok && cmp_range(col, bound, ZONE_OP_LE, &lo, to);
+        drop_obj(bound);
+    } else
+        ok = B8_FALSE;
+
+    drop_obj(val);
+
+    return ok;
+}
+
+/*
+ * Rows of a grouped column an (== column value), (== value column) or (in column values) condition selects,
+ * with a value not depending on the rows. Returns NULL_OBJ for any other condition.
+ */
+static obj_p select_grouped_rows(obj_p cond, obj_p tab) {
+    i64_t c, i;
+    obj_p car, col, val, res;
+    binary_f fn;
+
+    if (cond->type != TYPE_LIST || cond->len != 3)
+        return NULL_OBJ;
+
+    car = select_resolve_fn(AS_LIST(cond)[0]);
+    if (car->type != TYPE_BINARY)
+        return NULL_OBJ;
+
+    fn = (binary_f)car->i64;
+    if (fn != ray_eq && fn != ray_in)
+        return NULL_OBJ;
+
+    for (i = 1; i < 3; i++) {
+        c = NULL_I64;
+        col = AS_LIST(cond)[i];
+        if (col->type == -TYPE_SYMBOL && !(col->attrs & ATTR_QUOTED))
+            c = find_raw(AS_LIST(tab)[0], &col->i64);
+        if (c != NULL_I64 && (AS_LIST(AS_LIST(tab)[1])[c]->attrs & ATTR_GROUPED))
+            break;
+        // (in values column) asks for something else
+        if (fn == ray_in)
+            return NULL_OBJ;
+    }
+
+    if (i == 3 || select_refs_rows(AS_LIST(cond)[3 - i], AS_LIST(tab)[0], NULL_I64))
+        return NULL_OBJ;
+
+    val = eval(AS_LIST(cond)[3 - i]);
+    res = (fn == ray_eq && val->type != -TYPE_SYMBOL) ? NULL_OBJ
+                                                        : grouped_rows(AS_LIST(AS_LIST(tab)[1])[c], val);
+    drop_obj(val);
+
+    return res;
+}
+
+// Rows present in both of ascending x and y
+static obj_p select_rows_sect(obj_p x, obj_p y) {
+    i64_t i, j, n;
+    obj_p res;
+
+    res = I64(x->len < y->len ? x->len : y->len);
+
+    for (i = 0, j = 0, n = 0; i < (i64_t)x->len && j < (i64_t)y->len;) {
+        if (AS_I64(x)[i] < AS_I64(y)[j])
+            i++;
+        else if (AS_I64(x)[i] > AS_I64(y)[j])
+            j++;
+        else {
+            AS_I64(res)[n++] = AS_I64(x)[i];
+            i++;
+            j++;
+        }
+    }
+
+    res->len = n;
+    res->attrs = ATTR_ASC | ATTR_DISTINCT;
+
+    return res;
+}
+
+/*
+ * Filter of a where clause having conditions over sorted or grouped columns: the former narrow the rows to a range
+ * by binary searches, the latter to the rows of their groups. The other conditions are evaluated as usual and only
+ * the rows left get collected. Returns NULL_OBJ if no condition is over a sorted or grouped column.
+ */
+static obj_p select_index_filter(obj_p where, obj_p tab) {
+    i64_t i, j, n, from, to, lo, hi;
+    b8_t hit = B8_FALSE;
+    obj_p car, rest, expr, mask, res, rows = NULL_OBJ, v;
+
+    car = (where->type == TYPE_LIST && where->len > 0) ? select_resolve_fn(AS_LIST(where)[0]) : NULL_OBJ;
+    if (car->type == TYPE_VARY && car->i64 == (i64_t)ray_and) {
+        rest = LIST(where->len - 1);
+        for (i = 1; i < where->len; i++)
+            AS_LIST(rest)[i - 1] = clone_obj(AS_LIST(where)[i]);
+    } else
+        rest = vn_list(1, clone_obj(where));
+
+    n = ops_count(tab);
+    from = 0;
+    to = n;
+
+    for (i = 0; i < rest->len;) {
+        if (select_sorted_range(AS_LIST(rest)[i], tab, &lo, &hi)) {
+            from = (lo > from) ? lo : from;
+            to = (hi < to) ? hi : to;
+        } else if ((v = select_grouped_rows(AS_LIST(rest)[i], tab)) != NULL_OBJ) {
+            if (rows != NULL_OBJ) {
+                expr = select_rows_sect(rows, v);
+                drop_obj(rows);
+                drop_obj(v);
+                v = expr;
+            }
+            rows = v;
+        } else {
+            i++;
+            continue;
+        }
+
+        hit = B8_TRUE;
+
+        drop_obj(AS_LIST(rest)[i]);
+        memmove(AS_LIST(rest) + i, AS_LIST(rest) + i + 1, (rest->len - i - 1) * sizeof(obj_p));
+        rest->len--;
+    }
+
+    if (!hit) {
+        drop_obj(rest);
+        return NULL_OBJ;
+    }
+
+    if (to < from)
+        to = from;
+
+    // rows of the groups within the range, they may still be the ones of the index
+    if (rows != NULL_OBJ) {
+        v = cow_obj(rows);
+        if (v != rows) {
+            drop_obj(rows);
+            rows = v;
+            rows->attrs = ATTR_ASC | ATTR_DISTINCT;
+        }
+
+        for (i = 0, j = 0; i < (i64_t)rows->len; i++) {
+            if (AS_I64(rows)[i] >= from && AS_I64(rows)[i] < to)
+                AS_I64(rows)[j++] = AS_I64(rows)[i];
+        }
+        rows->len = j;
+    }
+
+    if (rest->len == 0) {
+        drop_obj(rest);
+
+        if (rows != NULL_OBJ)
+            return rows;
+
+        res = I64(to - from);
+        for (i = 0; i < to - from; i++)
+            AS_I64(res)[i] = from + i;
+        res->attrs = ATTR_ASC | ATTR_DISTINCT;
+        return res;
+    }
+
+    if (rest->len == 1) {
+        expr = clone_obj(AS_LIST(rest)[0]);
+        drop_obj(rest);
+    } else {
+        expr = LIST(rest->len + 1);
+        AS_LIST(expr)[0] = clone_obj(AS_LIST(where)[0]);
+        for (i = 0; i < rest->len; i++)
+            AS_LIST(expr)[i + 1] = clone_obj(AS_LIST(rest)[i]);
+        drop_obj(rest);
+    }
+
+    mask = eval(expr);
+    drop_obj(expr);
+
+    if (IS_ERR(mask)) {
+        drop_obj(rows);
+        return mask;
+    }
+
+    if (mask->type != TYPE_B8 || mask->len != n) {
+        drop_obj(rows);
+        res = ray_where(mask);
+        drop_obj(mask);
+        if (IS_ERR(res))
+            return res;
+        drop_obj(res);
+        THROW(ERR_LENGTH, "where: expected a mask of %lld rows", n);
+    }
+
+    if (rows != NULL_OBJ) {
+        for (i = 0, j = 0; i < (i64_t)rows->len; i++) {
+            if (AS_B8(mask)[AS_I64(rows)[i]])
+                AS_I64(rows)[j++] = AS_I64(rows)[i];
+        }
+        rows->len = j;
+        drop_obj(mask);
+        return rows;
+    }
+
+    res = ops_where(AS_B8(mask) + from, to - from);
+    drop_obj(mask);
+
+    for (i = 0; i < res->len; i++)
+        AS_I64(res)[i] += from;
+
+    return res;
+}
+
+// Does an expression yield a value per row (or an atom): columns, constants and element-wise calls over them
+static b8_t select_is_rowwise(obj_p expr, obj_p cols) {
+    i64_t i, fn;
+    obj_p car;
+
+    switch (expr->type) {
+        case -TYPE_SYMBOL:
+            return (expr->attrs & ATTR_QUOTED) || find_raw(cols, &expr->i64) != NULL_I64;
+        case TYPE_LIST:
+            if (expr->len < 2)
+                return B8_FALSE;
+
+            car = select_resolve_fn(AS_LIST(expr)[0]);
+            fn = car->i64;
+
+            if (car->type == TYPE_UNARY) {
+                if (fn != (i64_t)ray_round && fn != (i64_t)ray_floor && fn != (i64_t)ray_ceil &&
+                    fn != (i64_t)ray_not && fn != (i64_t)ray_neg)
+                    return B8_FALSE;
+            } else if (car->type == TYPE_BINARY) {
+                if (fn != (i64_t)ray_eq && fn != (i64_t)ray_ne && fn != (i64_t)ray_lt && fn != (i64_t)ray_le &&
+                    fn != (i64_t)ray_gt && fn != (i64_t)ray_ge && fn != (i64_t)ray_add && fn != (i64_t)ray_sub &&
+                    fn != (i64_t)ray_mul && fn != (i64_t)ray_div && fn != (i64_t)ray_fdiv && fn != (i64_t)ray_mod &&
+                    fn != (i64_t)ray_xbar)
+                    return B8_FALSE;
+            } else
+                return B8_FALSE;
+
+            for (i = 1; i < expr->len; i++) {
+                if (!select_is_rowwise(AS_LIST(expr)[i], cols))
+                    return B8_FALSE;
+            }
+
+            return B8_TRUE;
+        default:
+            return expr->type < 0;
+    }
+}
+
+/*
+ * Rows a take keeps, when it can be applied to the filter rather than to the built table: it is an integer, the
+ * query is not grouped and every field maps row to row. Then the fields are only computed over the rows kept.
+ * A take of more rows than the filter holds repeats them, so a filter is never cut below |take| rows.
+ */
+static i64_t select_limit(obj_p obj, query_ctx_p ctx) {
+    i64_t i, l;
+    b8_t ok;
+    obj_p prm, fields, expr;
+
+    if (ctx->take->type != -TYPE_I64 || ctx->take->i64 == NULL_I64 || ctx->take->i64 == 0)
+        return 0;
+
+    prm = at_sym(obj, "by", 2);
+    ok = (prm == NULL_OBJ);
+    drop_obj(prm);
+
+    fields = ray_except(AS_LIST(obj)[0], runtime_get()->env.keywords);
+    l = fields->len;
+    for (i = 0; ok && i < l; i++) {
+        expr = select_field(obj, fields, i);
+        ok = select_is_rowwise(expr, AS_LIST(ctx->table)[0]);
+        drop_obj(expr);
+    }
+    drop_obj(fields);
+
+    return ok ? ctx->take->i64 : 0;
+}
+
+// First (limit > 0) or last (limit < 0) |limit| rows a mask selects, NULL_OBJ if it selects fewer
+static obj_p select_where_limit(obj_p mask, i64_t limit) {
+    i64_t i, j, k, n;
+    obj_p res;
+
+    n = mask->len;
+    k = (limit < 0) ? -limit : limit;
+    res = I64(k);
+
+    if (limit > 0) {
+        for (i = 0, j = 0; i < n && j < k; i++) {
+            if (AS_B8(mask)[i])
+                AS_I64(res)[j++] = i;
+        }
+    } else {
+        for (i = n - 1, j = k; i >= 0 && j > 0; i--) {
+            if (AS_B8(mask)[i])
+                AS_I64(res)[--j] = i;
+        }
+        j = k - j;
+    }
+
+    if (j < k) {
+        drop_obj(res);
+        return NULL_OBJ;
+    }
+
+    res->attrs = ATTR_ASC | ATTR_DISTINCT;
+
+    return res;
+}
+
+// Cuts ascending filter rows to the first or last |limit| of them
+static obj_p select_cut_filter(obj_p fil, i64_t limit) {
+    i64_t k;
+    obj_p res;
+
+    k = (limit < 0) ? -limit : limit;
+    if (fil->type != TYPE_I64 || fil->len <= k)
+        return fil;
+
+    res = I64(k);
+    memcpy(AS_I64(res), AS_I64(fil) + ((limit < 0) ? fil->len - k : 0), k * sizeof(i64_t));
+    res->attrs = ATTR_ASC | ATTR_DISTINCT;
+    drop_obj(fil);
+
+    return res;
+}
+
 obj_p select_apply_filters(obj_p obj, query_ctx_p ctx) {
+    i64_t i, k, n;
     obj_p prm, val, fil;
 
     timeit_span_start("filters");
 
     prm = at_sym(obj, "where", 5);
     if (prm != NULL_OBJ) {
+        fil = select_index_filter(prm, ctx->table);
+        if (fil != NULL_OBJ) {
+            timeit_tick("find indexed rows");
+            drop_obj(prm);
+
+            if (IS_ERR(fil))
+                return fil;
+
+            ctx->filter = (ctx->limit != 0) ? select_cut_filter(fil, ctx->limit) : fil;
+            timeit_span_end("filters");
+
+            return NULL_OBJ;
+        }
+
         val = eval(prm);
         timeit_tick("eval filters");
         drop_obj(prm);
@@ -256,7 +686,13 @@ obj_p select_apply_filters(obj_p obj, query_ctx_p ctx) {
         if (IS_ERR(val))
             return val;
 
-        fil = ray_where(val);
+        fil = NULL_OBJ;
+        if (ctx->limit != 0 && val->type == TYPE_B8 && val->len == ops_count(ctx->table))
+            fil = select_where_limit(val, ctx->limit);
+
+        if (fil == NULL_OBJ)
+            fil = ray_where(val);
+
         timeit_tick("find indices");
         drop_obj(val);
 
@@ -264,6 +700,18 @@ obj_p select_apply_filters(obj_p obj, query_ctx_p ctx) {
             return fil;
 
         ctx->filter = fil;
+    } else if (ctx->limit != 0) {
+        // No condition: the rows a take keeps are at either end of the table
+        k = (ctx->limit < 0) ? -ctx->limit : ctx->limit;
+        n = ops_count(ctx->table);
+        if (k < n) {
+            fil = I64(k);
+            for (i = 0; i < k; i++)
+                AS_I64(fil)[i] = (ctx->limit < 0) ? n - k + i : i;
+            fil->attrs = ATTR_ASC | ATTR_DISTINCT;
+            ctx->filter = fil;
+            timeit_tick("take rows");
+        }
     }
 
     timeit_span_end("filters");
@@ -547,6 +995,799 @@ obj_p select_build_table(query_ctx_p ctx) {
     return res;
 }
 
+/*
+ * Partition at a time execution of selects over parted tables.
+ * Every selected partition runs as an ordinary select over a table of its own columns (the mapped files plus the
+ * partition column filled with the partition value), so memory stays proportional to a partition rather than to
+ * the whole table. Partition results are concatenated, aggregations are then merged from their partials.
+ */
+typedef enum select_parted_mode_t {
+    SELECT_PARTED_NONE = 0,  // query depends on the whole table at once: use the generic path
+    SELECT_PARTED_CONCAT,    // partitions yield disjoint rows (or groups): concatenate them
+    SELECT_PARTED_MERGE,     // aggregations are merged from the partitions partials
+} select_parted_mode_t;
+
+#define SELECT_PARTITION_COLUMN 1  // materialize the partition column, the query refers to it
+#define SELECT_PARTITION_KEY 2     // grouped by the partition column: one row per partition, keyed by its value
+
+static b8_t select_is_parted(obj_p table) {
+    return AS_LIST(table)[0]->len > 0 && AS_LIST(AS_LIST(table)[1])[0]->type == TYPE_MAPCOMMON;
+}
+
+static obj_p select_resolve_fn(obj_p car) {
+    obj_p *val;
+
+    if (car->type != -TYPE_SYMBOL || (car->attrs & ATTR_QUOTED))
+        return car;
+
+    val = resolve(car->i64);
+
+    return (val == NULL) ? car : *val;
+}
+
+static obj_p select_unary(unary_f fn, u8_t attrs) {
+    obj_p f;
+
+    f = atom(-TYPE_UNARY);
+    f->attrs = attrs;
+    f->i64 = (i64_t)fn;
+
+    return f;
+}
+
+static obj_p select_field(obj_p obj, obj_p fields, i64_t i) {
+    obj_p sym, res;
+
+    sym = at_idx(fields, i);
+    res = at_obj(obj, sym);
+    drop_obj(sym);
+
+    return res;
+}
+
+// Does an expression call an aggregation (or a lambda, which may aggregate inside)
+static b8_t select_has_aggr(obj_p expr) {
+    i64_t i, l;
+    obj_p car;
+
+    switch (expr->type) {
+        case TYPE_LIST:
+            l = expr->len;
+            if (l == 0)
+                return B8_FALSE;
+
+            car = select_resolve_fn(AS_LIST(expr)[0]);
+            if (car->type == TYPE_LAMBDA)
+                return B8_TRUE;
+
+            if ((car->type == TYPE_UNARY || car->type == TYPE_BINARY || car->type == TYPE_VARY) &&
+                (car->attrs & FN_AGGR))
+                return B8_TRUE;
+
+            for (i = 0; i < l; i++) {
+                if (select_has_aggr(AS_LIST(expr)[i]))
+                    return B8_TRUE;
+            }
+
+            return B8_FALSE;
+        case TYPE_DICT:
+            return select_has_aggr(AS_LIST(expr)[1]);
+        default:
+            return B8_FALSE;
+    }
+}
+
+// Does an expression reference table columns other than the partition one
+static b8_t select_refs_rows(obj_p expr, obj_p cols, i64_t psym) {
+    i64_t i, l;
+
+    switch (expr->type) {
+        case -TYPE_SYMBOL:
+            if ((expr->attrs & ATTR_QUOTED) || expr->i64 == psym)
+                return B8_FALSE;
+            return find_raw(cols, &expr->i64) != NULL_I64;
+        case TYPE_LIST:
+            l = expr->len;
+            for (i = 0; i < l; i++) {
+                if (select_refs_rows(AS_LIST(expr)[i], cols, psym))
+                    return B8_TRUE;
+            }
+            return B8_FALSE;
+        case TYPE_DICT:
+            return select_refs_rows(AS_LIST(expr)[1], cols, psym);
+        default:
+            return B8_FALSE;
+    }
+}
+
+// Does an expression reference a given column
+static b8_t select_refs_column(obj_p expr, i64_t sym) {
+    i64_t i, l;
+
+    switch (expr->type) {
+        case -TYPE_SYMBOL:
+            return !(expr->attrs & ATTR_QUOTED) && expr->i64 == sym;
+        case TYPE_LIST:
+            l = expr->len;
+            for (i = 0; i < l; i++) {
+                if (select_refs_column(AS_LIST(expr)[i], sym))
+                    return B8_TRUE;
+            }
+            return B8_FALSE;
+        case TYPE_DICT:
+            return select_refs_column(AS_LIST(expr)[1], sym);
+        default:
+            return B8_FALSE;
+    }
+}
+
+// Aggregation whose partition partials merge into the final value, NULL if the expression is not one
+static unary_f select_parted_aggr(obj_p expr) {
+    obj_p car;
+    unary_f fn;
+
+    if (expr->type != TYPE_LIST || expr->len != 2)
+        return NULL;
+
+    car = select_resolve_fn(AS_LIST(expr)[0]);
+    if (car->type != TYPE_UNARY)
+        return NULL;
+
+    fn = (unary_f)car->i64;
+    if (fn != ray_sum && fn != ray_count && fn != ray_avg && fn != ray_min && fn != ray_max && fn != ray_first &&
+        fn != ray_last)
+        return NULL;
+
+    return select_has_aggr(AS_LIST(expr)[1]) ? NULL : fn;
+}
+
+static b8_t select_by_partition(obj_p by, i64_t psym) {
+    i64_t i, l;
+    obj_p v;
+
+    switch (by->type) {
+        case -TYPE_SYMBOL:
+            return !(by->attrs & ATTR_QUOTED) && by->i64 == psym;
+        case TYPE_DICT:
+            l = AS_LIST(by)[1]->len;
+            for (i = 0; i < l; i++) {
+                v = AS_LIST(AS_LIST(by)[1])[i];
+                if (v->type == -TYPE_SYMBOL && select_by_partition(v, psym))
+                    return B8_TRUE;
+            }
+            return B8_FALSE;
+        default:
+            return B8_FALSE;
+    }
+}
+
+static select_parted_mode_t select_parted_mode(obj_p obj, obj_p fields, obj_p where, obj_p by, i64_t psym) {
+    i64_t i, l, aggrs = 0, others = 0;
+    obj_p expr;
+
+    if (select_has_aggr(where) || select_has_aggr(by))
+        return SELECT_PARTED_NONE;
+
+    l = fields->len;
+    for (i = 0; i < l; i++) {
+        expr = select_field(obj, fields, i);
+
+        if (select_parted_aggr(expr) != NULL)
+            aggrs++;
+        else if (select_has_aggr(expr))
+            others++;
+
+        drop_obj(expr);
+    }
+
+    if (by != NULL_OBJ) {
+        if (l == 0)
+            return SELECT_PARTED_NONE;
+        if (select_by_partition(by, psym))
+            return SELECT_PARTED_CONCAT;
+        return (aggrs == l) ? SELECT_PARTED_MERGE : SELECT_PARTED_NONE;
+    }
+
+    if (l > 0 && aggrs == l)
+        return SELECT_PARTED_MERGE;
+
+    return (aggrs == 0 && others == 0) ? SELECT_PARTED_CONCAT : SELECT_PARTED_NONE;
+}
+
+// Evaluates conditions on the partition column alone against the partitions values, leaves the rest in rows
+/*
+ * Clear the partitions a condition of the form (op column value) rules out by the zone maps of the column.
+ * The condition still runs over the rows of the partitions left.
+ */
+static nil_t select_zone_prune(obj_p cond, obj_p tab, obj_p mask) {
+    i64_t i, b, c, n, l;
+    zone_op_t op = ZONE_OP_EQ;
+    zone_hit_t acc, hit;
+    obj_p car, col, val, zone;
+    binary_f fn;
+
+    if (cond->type != TYPE_LIST || cond->len != 3 || AS_LIST(cond)[1]->type != -TYPE_SYMBOL)
+        return;
+
+    car = select_resolve_fn(AS_LIST(cond)[0]);
+    if (car->type != TYPE_BINARY)
+        return;
+
+    fn = (binary_f)car->i64;
+    if (fn == ray_eq)
+        op = ZONE_OP_EQ;
+    else if (fn == ray_ne)
+        op = ZONE_OP_NE;
+    else if (fn == ray_lt)
+        op = ZONE_OP_LT;
+    else if (fn == ray_gt)
+        op = ZONE_OP_GT;
+    else if (fn == ray_le)
+        op = ZONE_OP_LE;
+    else if (fn == ray_ge)
+        op = ZONE_OP_GE;
+    else if (fn != ray_within && fn != ray_in)
+        return;
+
+    // the partition column has no zone maps, it is pruned by its values
+    c = find_raw(AS_LIST(tab)[0], &AS_LIST(cond)[1]->i64);
+    if (c == NULL_I64 || c == 0 || select_refs_rows(AS_LIST(cond)[2], AS_LIST(tab)[0], NULL_I64))
+        return;
+
+    val = eval(AS_LIST(cond)[2]);
+    if (IS_ERR(val) || ((fn == ray_within || fn == ray_in) ? !IS_VECTOR(val) : val->type >= 0) ||
+        (fn == ray_within && val->len != 2) || (fn == ray_in && val->len > ZONE_IN_MAX)) {
+        drop_obj(val);
+        return;
+    }
+
+    n = mask->len;
+    for (i = 0; i < n; i++) {
+        if (!AS_B8(mask)[i])
+            continue;
+
+        col = AS_LIST(AS_LIST(AS_LIST(tab)[1])[c])[i];
+        zone = zone_get(col);
+        if (zone == NULL_OBJ)
+            continue;
+
+        l = ops_count(zone);
+        for (b = 0, acc = ZONE_NONE; b < l && acc == ZONE_NONE; b++) {
+            if (fn == ray_within)
+                hit = zone_within(zone, b, val);
+            else if (fn == ray_in)
+                hit = zone_in(zone, b, val);
+            else
+                hit = zone_cmp(zone, b, op, val);
+
+            acc = zone_reduce(acc, hit);
+        }
+
+        if (l > 0 && acc == ZONE_NONE)
+            AS_B8(mask)[i] = B8_FALSE;
+
+        drop_obj(zone);
+    }
+
+    drop_obj(val);
+}
+
+static obj_p select_parted_prune(obj_p where, obj_p tab, obj_p *rows) {
+    i64_t i, j, h, l, n;
+    obj_p cols, pcol, car, conds, mask, v;
+
+    cols = AS_LIST(tab)[0];
+    pcol = AS_LIST(AS_LIST(tab)[1])[0];
+    n = AS_LIST(pcol)[0]->len;
+
+    mask = B8(n);
+    memset(AS_B8(mask), B8_TRUE, n);
+    *rows = NULL_OBJ;
+
+    if (where == NULL_OBJ)
+        return mask;
+
+    car = (where->type == TYPE_LIST && where->len > 0) ? select_resolve_fn(AS_LIST(where)[0]) : NULL_OBJ;
+
+    if (car->type == TYPE_VARY && car->i64 == (i64_t)ray_and) {
+        conds = LIST(where->len - 1);
+        for (i = 1; i < where->len; i++)
+            AS_LIST(conds)[i - 1] = clone_obj(AS_LIST(where)[i]);
+    } else
+        conds = vn_list(1, clone_obj(where));
+
+    v = SYMBOL(1);
+    AS_SYMBOL(v)[0] = AS_SYMBOL(cols)[0];
+    v = table(v, vn_list(1, clone_obj(AS_LIST(pcol)[0])));
+    mount_env(v);
+    drop_obj(v);
+
+    l = conds->len;
+    for (i = 0, j = 0; i < l; i++) {
+        if (!select_refs_rows(AS_LIST(conds)[i], cols, AS_SYMBOL(cols)[0])) {
+            v = eval(AS_LIST(conds)[i]);
+
+            if (v->type == TYPE_B8 && v->len == n) {
+                for (h = 0; h < n; h++)
+                    AS_B8(mask)[h] = AS_B8(mask)[h] && AS_B8(v)[h];
+                drop_obj(v);
+                continue;
+            } else if (v->type == -TYPE_B8) {
+                if (!v->b8)
+                    memset(AS_B8(mask), B8_FALSE, n);
+                drop_obj(v);
+                continue;
+            }
+
+            drop_obj(v);
+        }
+
+        if (i != j) {
+            AS_LIST(conds)[j] = AS_LIST(conds)[i];
+            AS_LIST(conds)[i] = NULL_OBJ;
+        }
+
+        j++;
+    }
+
+    unmount_env(1);
+
+    for (i = 0; i < j; i++)
+        select_zone_prune(AS_LIST(conds)[i], tab, mask);
+
+    if (j == 1)
+        *rows = clone_obj(AS_LIST(conds)[0]);
+    else if (j > 1) {
+        *rows = LIST(j + 1);
+        AS_LIST(*rows)[0] = clone_obj(AS_LIST(where)[0]);
+        for (i = 0; i < j; i++)
+            AS_LIST(*rows)[i + 1] = clone_obj(AS_LIST(conds)[i]);
+    }
+
+    drop_obj(conds);
+
+    return mask;
+}
+
+// Partition column of a partition: its value repeated over the rows
+static obj_p select_partition_column(obj_p pcol, i64_t part, i64_t n) {
+    i64_t i;
+    obj_p v;
+
+    v = vector(AS_LIST(pcol)[0]->type, n);
+    switch (size_of_type(v->type)) {
+        case ISIZEOF(i32_t):
+            for (i = 0; i < n; i++)
+                AS_I32(v)[i] = AS_I32(AS_LIST(pcol)[0])[part];
+            break;
+        default:
+            for (i = 0; i < n; i++)
+                AS_I64(v)[i] = AS_I64(AS_LIST(pcol)[0])[part];
+            break;
+    }
+
+    return v;
+}
+
+// Table over the columns of a partition, NULL_I64 partition gives an empty table of the same schema
+static obj_p select_partition_table(obj_p tab, i64_t part, b8_t column) {
+    i64_t i, j, l, n;
+    i8_t type;
+    obj_p cols, pcol, col, keys, vals;
+
+    cols = AS_LIST(tab)[1];
+    pcol = AS_LIST(cols)[0];
+    l = cols->len;
+    n = (part == NULL_I64) ? 0 : AS_I64(AS_LIST(pcol)[1])[part];
+    j = column ? 0 : 1;
+
+    keys = SYMBOL(l - j);
+    vals = LIST(l - j);
+    memcpy(AS_SYMBOL(keys), AS_SYMBOL(AS_LIST(tab)[0]) + j, (l - j) * sizeof(i64_t));
+
+    if (column)
+        AS_LIST(vals)[0] = select_partition_column(pcol, (part == NULL_I64) ? 0 : part, n);
+
+    for (i = 1; i < l; i++) {
+        col = AS_LIST(AS_LIST(cols)[i])[(part == NULL_I64) ? 0 : part];
+
+        if (part != NULL_I64)
+            AS_LIST(vals)[i - j] = clone_obj(col);
+        else {
+            type = (col->type == TYPE_ENUM) ? TYPE_SYMBOL : col->type;
+            AS_LIST(vals)[i - j] = (type > TYPE_LIST && type <= TYPE_C8) ? vector(type, 0) : LIST(0);
+        }
+    }
+
+    return table(keys, vals);
+}
+
+obj_p select_partition(obj_p query, obj_p tab, i64_t part, i64_t flags) {
+    i64_t i, l;
+    obj_p keys, vals, q, res;
+
+    keys = AS_LIST(query)[0];
+    l = keys->len;
+    vals = LIST(l);
+
+    for (i = 0; i < l; i++) {
+        if (AS_SYMBOL(keys)[i] == SYMBOL_FROM)
+            AS_LIST(vals)[i] = select_partition_table(tab, part, (flags & SELECT_PARTITION_COLUMN) != 0);
+        else
+            AS_LIST(vals)[i] = clone_obj(AS_LIST(AS_LIST(query)[1])[i]);
+    }
+
+    q = dict(clone_obj(keys), vals);
+    res = ray_select(q);
+    drop_obj(q);
+
+    if (IS_ERR(res) || !(flags & SELECT_PARTITION_KEY))
+        return res;
+
+    // One row per partition, keyed by the partition value
+    if (part == NULL_I64) {
+        q = ray_take(i64(0), res);
+        drop_obj(res);
+        res = q;
+    }
+
+    l = AS_LIST(AS_LIST(res)[1])[0]->len;
+    keys = SYMBOL(1);
+    AS_SYMBOL(keys)[0] = AS_SYMBOL(AS_LIST(tab)[0])[0];
+    q = ray_concat(keys, AS_LIST(res)[0]);
+    drop_obj(keys);
+
+    vals = LIST(AS_LIST(res)[1]->len + 1);
+    AS_LIST(vals)[0] = select_partition_column(AS_LIST(AS_LIST(tab)[1])[0], (part == NULL_I64) ? 0 : part, l);
+    for (i = 0; i < AS_LIST(res)[1]->len; i++)
+        AS_LIST(vals)[i + 1] = clone_obj(AS_LIST(AS_LIST(res)[1])[i]);
+
+    drop_obj(res);
+
+    return table(q, vals);
+}
+
+// Concatenates partition results, columns of a fixed width type are copied at once
+static obj_p select_parted_raze(obj_p parts) {
+    i64_t i, j, l, n, w, len, size;
+    i8_t type;
+    b8_t flat;
+    obj_p keys, vals, col, v, r;
+
+    n = parts->len;
+    if (n == 1)
+        return clone_obj(AS_LIST(parts)[0]);
+
+    keys = AS_LIST(AS_LIST(parts)[0])[0];
+    w = keys->len;
+    vals = LIST(w);
+
+    for (j = 0; j < w; j++) {
+        type = AS_LIST(AS_LIST(AS_LIST(parts)[0])[1])[j]->type;
+        flat = (type > TYPE_LIST && type <= TYPE_C8);
+        len = 0;
+
+        for (i = 0; i < n; i++) {
+            col = AS_LIST(AS_LIST(AS_LIST(parts)[i])[1])[j];
+            flat = flat && (col->type == type);
+            len += col->len;
+        }
+
+        if (flat) {
+            size = size_of_type(type);
+            v = vector(type, len);
+            for (i = 0, l = 0; i < n; i++) {
+                col = AS_LIST(AS_LIST(AS_LIST(parts)[i])[1])[j];
+                memcpy(AS_U8(v) + l * size, AS_U8(col), col->len * size);
+                l += col->len;
+            }
+        } else {
+            v = clone_obj(AS_LIST(AS_LIST(AS_LIST(parts)[0])[1])[j]);
+            for (i = 1; i < n; i++) {
+                r = ray_concat(v, AS_LIST(AS_LIST(AS_LIST(parts)[i])[1])[j]);
+                drop_obj(v);
+
+                if (IS_ERR(r)) {
+                    vals->len = j;
+                    drop_obj(vals);
+                    return r;
+                }
+
+                v = r;
+            }
+        }
+
+        AS_LIST(vals)[j] = v;
+    }
+
+    return table(clone_obj(keys), vals);
+}
+
+// Merges aggregation partials: group them again over the partition results and divide what avg has left
+static obj_p select_parted_merge(obj_p partials, obj_p fields, obj_p funs, obj_p avgs, b8_t grouped) {
+    i64_t i, k, m, a, h, l, len;
+    obj_p keys, vals, sym, cnt, sum, q, res, v;
+
+    m = fields->len;
+    a = avgs->len;
+    k = AS_LIST(partials)[0]->len - m - a;
+
+    keys = SYMBOL(0);
+    vals = LIST(0);
+
+    sym = symboli64(SYMBOL_FROM);
+    push_raw(&keys, &sym->i64);
+    push_obj(&vals, clone_obj(partials));
+    drop_obj(sym);
+
+    if (grouped) {
+        sym = symboli64(SYMBOL_BY);
+        push_raw(&keys, &sym->i64);
+        drop_obj(sym);
+
+        if (k == 1)
+            push_obj(&vals, symboli64(AS_SYMBOL(AS_LIST(partials)[0])[0]));
+        else {
+            v = LIST(k);
+            for (i = 0; i < k; i++)
+                AS_LIST(v)[i] = symboli64(AS_SYMBOL(AS_LIST(partials)[0])[i]);
+            push_obj(&vals, dict(ray_take(i64(k), AS_LIST(partials)[0]), v));
+        }
+    }
+
+    for (i = 0; i < m + a; i++) {
+        push_raw(&keys, &AS_SYMBOL(AS_LIST(partials)[0])[k + i]);
+        push_obj(&vals, vn_list(2, clone_obj((i < m) ? AS_LIST(funs)[i] : AS_LIST(funs)[m]),
+                                symboli64(AS_SYMBOL(AS_LIST(partials)[0])[k + i])));
+    }
+
+    q = dict(keys, vals);
+    res = ray_select(q);
+    drop_obj(q);
+
+    if (IS_ERR(res) || a == 0)
+        return res;
+
+    // avg partials are sums and counts
+    for (i = 0; i < a; i++) {
+        sum = AS_LIST(AS_LIST(res)[1])[k + AS_I64(avgs)[i]];
+        cnt = AS_LIST(AS_LIST(res)[1])[k + m + i];
+        len = sum->len;
+        v = F64(len);
+
+        switch (sum->type) {
+            case TYPE_I64:
+                for (h = 0; h < len; h++)
+                    AS_F64(v)[h] = FDIVI64(AS_I64(sum)[h], AS_I64(cnt)[h]);
+                break;
+            case TYPE_F64:
+                for (h = 0; h < len; h++)
+                    AS_F64(v)[h] = FDIVF64(AS_F64(sum)[h], (f64_t)AS_I64(cnt)[h]);
+                break;
+            default:
+                drop_obj(v);
+                drop_obj(res);
+                THROW(ERR_TYPE, "avg: unsupported type: '%s", type_name(sum->type));
+        }
+
+        AS_LIST(AS_LIST(res)[1])[k + AS_I64(avgs)[i]] = v;
+        drop_obj(sum);
+    }
+
+    l = k + m;
+    keys = ray_take(i64(l), AS_LIST(res)[0]);
+    vals = LIST(l);
+    for (i = 0; i < l; i++)
+        AS_LIST(vals)[i] = clone_obj(AS_LIST(AS_LIST(res)[1])[i]);
+
+    drop_obj(res);
+
+    return table(keys, vals);
+}
+
+static obj_p select_parted(obj_p obj, query_ctx_p ctx) {
+    i64_t i, l, m, n, psym, flags;
+    select_parted_mode_t mode;
+    unary_f fn;
+    obj_p cols, fields, where, by, rows, mask, parts, keys, vals, funs, avgs, query, expr, sym, res;
+    pool_p pool = runtime_get()->pool;
+
+    cols = AS_LIST(ctx->table)[0];
+    psym = AS_SYMBOL(cols)[0];
+
+    where = at_sym(obj, "where", 5);
+    by = at_sym(obj, "by", 2);
+    fields = ray_except(AS_LIST(obj)[0], runtime_get()->env.keywords);
+
+    mode = select_parted_mode(obj, fields, where, by, psym);
+
+    if (mode == SELECT_PARTED_NONE) {
+        drop_obj(where);
+        drop_obj(by);
+        drop_obj(fields);
+        return NULL_OBJ;
+    }
+
+    timeit_span_start("parted");
+
+    mask = select_parted_prune(where, ctx->table, &rows);
+    drop_obj(where);
+
+    timeit_tick("prune partitions");
+
+    // Partition query: same fields over a single partition, avg is split into a sum and a count
+    keys = SYMBOL(0);
+    vals = LIST(0);
+    funs = LIST(0);
+    avgs = I64(0);
+
+    sym = symboli64(SYMBOL_FROM);
+    push_raw(&keys, &sym->i64);
+    push_obj(&vals, NULL_OBJ);
+    drop_obj(sym);
+
+    if (rows != NULL_OBJ) {
+        sym = symboli64(SYMBOL_WHERE);
+        push_raw(&keys, &sym->i64);
+        push_obj(&vals, rows);
+        drop_obj(sym);
+    }
+
+    // Aggregations grouped by the partition column alone make a single row per partition, no need to group them
+    flags = 0;
+    if (by->type == -TYPE_SYMBOL && select_by_partition(by, psym)) {
+        flags = SELECT_PARTITION_KEY;
+        for (i = 0; i < fields->len; i++) {
+            expr = select_field(obj, fields, i);
+            if (!select_has_aggr(expr))
+                flags = 0;
+            drop_obj(expr);
+        }
+    }
+
+    if (by != NULL_OBJ && !(flags & SELECT_PARTITION_KEY)) {
+        sym = symboli64(SYMBOL_BY);
+        push_raw(&keys, &sym->i64);
+        push_obj(&vals, clone_obj(by));
+        drop_obj(sym);
+    }
+
+    l = fields->len;
+    for (i = 0; i < l; i++) {
+        push_raw(&keys, &AS_SYMBOL(fields)[i]);
+        expr = select_field(obj, fields, i);
+        fn = (mode == SELECT_PARTED_MERGE) ? select_parted_aggr(expr) : NULL;
+
+        if (fn == ray_avg) {
+            push_obj(&vals, vn_list(2, select_unary(ray_sum, FN_ATOMIC | FN_AGGR), clone_obj(AS_LIST(expr)[1])));
+            push_raw(&avgs, &i);
+            drop_obj(expr);
+        } else
+            push_obj(&vals, expr);
+
+        if (fn == ray_sum || fn == ray_count || fn == ray_avg)
+            push_obj(&funs, select_unary(ray_sum, FN_ATOMIC | FN_AGGR));
+        else if (fn == ray_min || fn == ray_max)
+            push_obj(&funs, select_unary(fn, FN_ATOMIC | FN_AGGR));
+        else if (fn != NULL)
+            push_obj(&funs, select_unary(fn, FN_AGGR));
+    }
+
+    // Grouped avg divides by the rows count, plain one by the count of non null values
+    for (i = 0; i < avgs->len; i++) {
+        expr = select_field(obj, fields, AS_I64(avgs)[i]);
+        res = str_fmt(-1, "%s.count", str_from_symbol(AS_SYMBOL(fields)[AS_I64(avgs)[i]]));
+        sym = symbol(AS_C8(res), res->len);
+        push_raw(&keys, &sym->i64);
+        push_obj(&vals, vn_list(2, (by != NULL_OBJ) ? select_unary(ray_count, FN_AGGR) : select_unary(ray_cnt, FN_NONE),
+                                clone_obj(AS_LIST(expr)[1])));
+        drop_obj(sym);
+        drop_obj(res);
+        drop_obj(expr);
+    }
+
+    if (avgs->len > 0)
+        push_obj(&funs, select_unary(ray_sum, FN_ATOMIC | FN_AGGR));
+
+    query = dict(keys, vals);
+
+    if (select_refs_column(AS_LIST(query)[1], psym))
+        flags |= SELECT_PARTITION_COLUMN;
+
+    // Partitions to visit
+    n = mask->len;
+    parts = I64(0);
+    for (i = 0; i < n; i++) {
+        if (AS_B8(mask)[i])
+            push_raw(&parts, &i);
+    }
+    drop_obj(mask);
+
+    if (parts->len == 0) {
+        i = NULL_I64;
+        push_raw(&parts, &i);
+    }
+
+    n = parts->len;
+
+    if (ctx->limit != 0 && mode == SELECT_PARTED_CONCAT && by == NULL_OBJ) {
+        // Partitions from the end the take keeps rows of, until they hold enough of them
+        res = LIST(0);
+        for (i = 0, m = 0; i < n && m < ((ctx->limit < 0) ? -ctx->limit : ctx->limit); i++) {
+            expr = select_partition(query, ctx->table, AS_I64(parts)[(ctx->limit < 0) ? n - 1 - i : i], flags);
+
+            if (IS_ERR(expr)) {
+                drop_obj(res);
+                res = expr;
+                break;
+            }
+
+            m += ops_count(expr);
+            push_obj(&res, expr);
+        }
+
+        if (!IS_ERR(res) && ctx->limit < 0) {
+            for (i = 0; i < res->len / 2; i++) {
+                expr = AS_LIST(res)[i];
+                AS_LIST(res)[i] = AS_LIST(res)[res->len - 1 - i];
+                AS_LIST(res)[res->len - 1 - i] = expr;
+            }
+        }
+    } else if (pool_split_tasks(pool, n) > 1) {
+        pool_prepare(pool);
+        for (i = 0; i < n; i++)
+            pool_add_task(pool, (raw_p)select_partition, 4, query, ctx->table, AS_I64(parts)[i], flags);
+        res = pool_run(pool);
+    } else {
+        res = LIST(n);
+        for (i = 0; i < n; i++) {
+            expr = select_partition(query, ctx->table, AS_I64(parts)[i], flags);
+
+            if (IS_ERR(expr)) {
+                res->len = i;
+                drop_obj(res);
+                res = expr;
+                break;
+            }
+
+            AS_LIST(res)[i] = expr;
+        }
+    }
+
+    drop_obj(parts);
+    drop_obj(query);
+
+    timeit_tick("select partitions");
+
+    if (!IS_ERR(res)) {
+        expr = select_parted_raze(res);
+        drop_obj(res);
+        res = expr;
+    }
+
+    if (!IS_ERR(res) && mode == SELECT_PARTED_MERGE) {
+        expr = select_parted_merge(res, fields, funs, avgs, by != NULL_OBJ);
+        drop_obj(res);
+        res = expr;
+    }
+
+    drop_obj(by);
+    drop_obj(fields);
+    drop_obj(funs);
+    drop_obj(avgs);
+
+    if (!IS_ERR(res) && ctx->take != NULL_OBJ) {
+        expr = ray_take(ctx->take, res);
+        drop_obj(res);
+        res = expr;
+    }
+
+    timeit_tick("merge partitions");
+    timeit_span_end("parted");
+
+    return res;
+}
+
 obj_p ray_select(obj_p obj) {
     obj_p res;
     struct query_ctx_t ctx;
@@ -566,6 +1807,15 @@ obj_p ray_select(obj_p obj) {
     if (IS_ERR(res))
         goto cleanup;
 
+    // Parted tables go partition at a time whenever the query allows it
+    if (select_is_parted(ctx.table)) {
+        res = select_parted(obj, &ctx);
+        if (res != NULL_OBJ) {
+            ctx.tablen = 0;
+            goto cleanup;
+        }
+    }
+
     // Mount table columns to a local env
     mount_env(ctx.table);
 
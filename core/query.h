@@ -29,6 +29,7 @@
 typedef struct query_ctx_t {
     i64_t tablen;
     obj_p take;
+    i64_t limit;  // rows a take keeps when it can cut the filter, 0 if it can not
     obj_p table;
     obj_p filter;
     obj_p group_index;
@@ -40,6 +40,7 @@
 #include "time.h"
 #include "timestamp.h"
 #include "cmp.h"
+#include "grouped.h"
 
 RAYASSERT(sizeof(struct obj_t) == 16, rayforce_h)
 
@@ -344,6 +345,26 @@ obj_p anymap(obj_p sym, obj_p vec) {
     return e;
 }
 
+obj_p strings(i64_t len, i64_t size) {
+    obj_p vec;
+
+    vec = (obj_p)heap_alloc(sizeof(struct obj_t) + (len + 1) * sizeof(i64_t) + size);
+
+    if (vec == NULL)
+        THROW(ERR_HEAP, "oom");
+
+    vec->mmod = MMOD_INTERNAL;
+    vec->type = TYPE_STRINGS;
+    vec->rc = 1;
+    vec->len = len;
+    vec->attrs = 0;
+
+    STRINGS_OFFS(vec)[0] = 0;
+    STRINGS_OFFS(vec)[len] = size;
+
+    return vec;
+}
+
 obj_p resize_obj(obj_p* obj, i64_t len) {
     i64_t elem_size, obj_size;
     obj_p new_obj;
@@ -353,6 +374,9 @@ obj_p resize_obj(obj_p* obj, i64_t len) {
     if ((*obj)->len == len)
         return *obj;
 
+    if (IS_INTERNAL(*obj) && ((*obj)->attrs & ATTR_GROUPED))
+        grouped_drop(*obj);
+
     elem_size = size_of_type((*obj)->type);
 
     // calculate size of vector with new length
@@ -379,6 +403,10 @@ obj_p push_raw(obj_p* obj, raw_p val) {
     i64_t off, req, size;
     obj_p new_obj;
 
+    // the object may move, leaving its group index behind (a mapped one keeps it, it is only copied)
+    if (IS_INTERNAL(*obj) && ((*obj)->attrs & ATTR_GROUPED))
+        grouped_drop(*obj);
+
     size = size_of_type((*obj)->type);
     off = (*obj)->len * size;
     req = sizeof(struct obj_t) + off + size;
@@ -397,6 +425,7 @@ obj_p push_raw(obj_p* obj, raw_p val) {
 
     memcpy((*obj)->raw + off, val, size);
     (*obj)->len++;
+    (*obj)->attrs &= ~ATTR_ORDER;
 
     return *obj;
 }
@@ -461,6 +490,8 @@ obj_p append_list(obj_p* obj, obj_p vals) {
     i64_t i, c, l, size1, size2;
     obj_p res;
 
+    (*obj)->attrs &= ~ATTR_ORDER;
+
     switch (MTYPE2((*obj)->type, vals->type)) {
         case MTYPE2(TYPE_I64, TYPE_I64):
         case MTYPE2(TYPE_SYMBOL, TYPE_SYMBOL):
@@ -755,6 +786,13 @@ obj_p at_idx(obj_p obj, i64_t idx) {
             if (idx >= 0 && idx < (i64_t)obj->len)
                 return clone_obj(AS_LIST(obj)[idx]);
             return NULL_OBJ;
+        case TYPE_STRINGS:
+            if (idx < 0)
+                idx = obj->len + idx;
+            if (idx >= 0 && idx < (i64_t)obj->len)
+                return string_from_str(STRINGS_DATA(obj) + STRINGS_OFFS(obj)[idx],
+                                       STRINGS_OFFS(obj)[idx + 1] - STRINGS_OFFS(obj)[idx]);
+            return string_from_str("", 0);
         case TYPE_GUID:
             if (idx < 0)
                 idx = obj->len + idx + 1;
@@ -1036,6 +1074,9 @@ obj_p at_ids(obj_p obj, i64_t ids[], i64_t len) {
 
             return out;
 
+        case TYPE_STRINGS:
+            return strings_at_ids(obj, ids, len);
+
         case TYPE_ENUM:
             k = ray_key(obj);
             if (IS_ERR(k))
@@ -1183,6 +1224,7 @@ obj_p at_obj(obj_p obj, obj_p idx) {
         case MTYPE2(TYPE_LIST, -TYPE_I64):
         case MTYPE2(TYPE_ENUM, -TYPE_I64):
         case MTYPE2(TYPE_MAPLIST, -TYPE_I64):
+        case MTYPE2(TYPE_STRINGS, -TYPE_I64):
         case MTYPE2(TYPE_TABLE, -TYPE_I64):
             return at_idx(obj, idx->i64);
         case MTYPE2(TYPE_TABLE, -TYPE_SYMBOL):
@@ -1203,6 +1245,7 @@ obj_p at_obj(obj_p obj, obj_p idx) {
         case MTYPE2(TYPE_GUID, TYPE_I64):
         case MTYPE2(TYPE_LIST, TYPE_I64):
         case MTYPE2(TYPE_ENUM, TYPE_I64):
+        case MTYPE2(TYPE_STRINGS, TYPE_I64):
         case MTYPE2(TYPE_TABLE, TYPE_I64):
             ids = AS_I64(idx);
             n = idx->len;
@@ -1249,6 +1292,10 @@ obj_p set_idx(obj_p* obj, i64_t idx, obj_p val) {
         THROW(ERR_INDEX, "set_idx: '%lld' is out of range '0..%lld'", idx, (*obj)->len - 1);
     }
 
+    // the values change, so what was known about their order no longer holds, nor their groups
+    (*obj)->attrs &= ~ATTR_ORDER;
+    grouped_drop(*obj);
+
     switch (MTYPE2((*obj)->type, val->type)) {
         case MTYPE2(TYPE_I64, -TYPE_I64):
         case MTYPE2(TYPE_SYMBOL, -TYPE_SYMBOL):
@@ -1283,6 +1330,10 @@ obj_p set_idx(obj_p* obj, i64_t idx, obj_p val) {
 
 obj_p set_ids(obj_p* obj, i64_t ids[], i64_t len, obj_p vals) {
     i64_t i;
+
+    (*obj)->attrs &= ~ATTR_ORDER;
+    grouped_drop(*obj);
+
     switch (MTYPE2((*obj)->type, vals->type)) {
         case MTYPE2(TYPE_C8, -TYPE_C8):
             for (i = 0; i < len; i++)
@@ -2069,6 +2120,16 @@ i64_t cmp_obj(obj_p a, obj_p b) {
             }
             return a->len - b->len;
 
+        case TYPE_STRINGS:
+            l = a->len < b->len ? a->len : b->len;
+            for (i = 0; i < l; i++) {
+                d = str_cmp(STRINGS_DATA(a) + STRINGS_OFFS(a)[i], STRINGS_OFFS(a)[i + 1] - STRINGS_OFFS(a)[i],
+                            STRINGS_DATA(b) + STRINGS_OFFS(b)[i], STRINGS_OFFS(b)[i + 1] - STRINGS_OFFS(b)[i]);
+                if (d != 0)
+                    return d;
+            }
+            return a->len - b->len;
+
         case TYPE_DICT:
         case TYPE_TABLE:
             d = cmp_obj(AS_LIST(a)[0], AS_LIST(b)[0]);
@@ -2244,6 +2305,21 @@ obj_p cast_obj(i8_t type, obj_p obj) {
             return table(clone_obj(AS_LIST(obj)[0]), clone_obj(AS_LIST(obj)[1]));
         case MTYPE2(TYPE_DICT, TYPE_TABLE):
             return dict(clone_obj(AS_LIST(obj)[0]), clone_obj(AS_LIST(obj)[1]));
+        case MTYPE2(TYPE_STRINGS, TYPE_LIST):
+            return strings_from_list(obj);
+        case MTYPE2(TYPE_STRINGS, TYPE_SYMBOL):
+            return strings_from_symbols(obj);
+        case MTYPE2(TYPE_STRINGS, TYPE_MAPLIST):
+            v = ray_value(obj);
+            if (IS_ERR(v))
+                return v;
+            res = strings_from_list(v);
+            drop_obj(v);
+            return res;
+        case MTYPE2(TYPE_LIST, TYPE_STRINGS):
+            return strings_to_list(obj);
+        case MTYPE2(TYPE_SYMBOL, TYPE_STRINGS):
+            return strings_to_symbols(obj);
         case MTYPE2(TYPE_B8, TYPE_I16):
         case MTYPE2(TYPE_U8, TYPE_I16):
             l = obj->len;
@@ -2529,6 +2605,8 @@ nil_t __attribute__((hot)) drop_obj(obj_p obj) {
             heap_free(obj);
             return;
         case TYPE_ENUM:
+            if (obj->attrs & ATTR_GROUPED)
+                runtime_grouped_pop(runtime_get(), obj);
             if (IS_EXTERNAL_COMPOUND(obj)) {
                 runtime_fdmap_pop(runtime_get(), obj);
                 // mmap_free((str_p)obj - RAY_PAGE_SIZE, size_of(obj) + RAY_PAGE_SIZE);
@@ -2555,6 +2633,7 @@ nil_t __attribute__((hot)) drop_obj(obj_p obj) {
             drop_obj(AS_LAMBDA(obj)->args);
             drop_obj(AS_LAMBDA(obj)->body);
             drop_obj(AS_LAMBDA(obj)->nfo);
+            drop_obj(AS_LAMBDA(obj)->code);
             heap_free(obj);
             return;
         case TYPE_NULL:
@@ -2565,9 +2644,13 @@ nil_t __attribute__((hot)) drop_obj(obj_p obj) {
             heap_free(obj);
             return;
         default:
-            if (IS_EXTERNAL_SIMPLE(obj))
+            // functions use the same bit for their flags
+            if (IS_VECTOR(obj) && (obj->attrs & ATTR_GROUPED))
+                runtime_grouped_pop(runtime_get(), obj);
+            if (IS_EXTERNAL_SIMPLE(obj)) {
+                runtime_zone_pop(runtime_get(), obj);
                 runtime_fdmap_pop(runtime_get(), obj);
-            else if (IS_EXTERNAL_COMPOUND(obj)) {
+            } else if (IS_EXTERNAL_COMPOUND(obj)) {
                 runtime_fdmap_pop(runtime_get(), MAPLIST_KEY(obj));
                 runtime_fdmap_pop(runtime_get(), obj);
             } else
@@ -2626,6 +2709,10 @@ obj_p copy_obj(obj_p obj) {
             for (i = 0; i < l; i++)
                 AS_LIST(res)[i] = clone_obj(AS_LIST(obj)[i]);
             return res;
+        case TYPE_STRINGS:
+            res = strings(obj->len, STRINGS_OFFS(obj)[obj->len]);
+            memcpy(res->raw, obj->raw, size_of(obj) - sizeof(struct obj_t));
+            return res;
         case TYPE_ENUM:
         case TYPE_MAPLIST:
             return ray_value(obj);
@@ -69,6 +69,7 @@ typedef u8_t guid_t[16];
 #define TYPE_GUID 11
 #define TYPE_C8 12
 #define TYPE_ENUM 20
+#define TYPE_STRINGS 21  // offsets followed by the bytes of all the strings
 #define TYPE_MAPFILTER 71
 #define TYPE_MAPGROUP 72
 #define TYPE_MAPFD 73
@@ -203,6 +204,7 @@ extern obj_p guid(const guid_t buf);           // GUID
 extern obj_p vn_c8(lit_p fmt, ...);            // string from format
 extern obj_p enumerate(obj_p sym, obj_p vec);  // enum
 extern obj_p anymap(obj_p sym, obj_p vec);     // anymap
+extern obj_p strings(i64_t len, i64_t size);   // string vector of len strings, size bytes
 
 #define B8(len) (vector(TYPE_B8, len))                // bool vector
 #define U8(len) (vector(TYPE_U8, len))                // byte vector
@@ -128,6 +128,8 @@ runtime_p runtime_create(i32_t argc, str_p argv[]) {
     __RUNTIME->symbols = symbols;
     __RUNTIME->env = env_create();
     __RUNTIME->fdmaps = dict(I64(0), LIST(0));
+    __RUNTIME->zones = dict(I64(0), LIST(0));
+    __RUNTIME->grouped = dict(I64(0), LIST(0));
     __RUNTIME->args = NULL_OBJ;
     __RUNTIME->query_ctx = NULL;
     __RUNTIME->pool = NULL;
@@ -235,6 +237,8 @@ nil_t runtime_destroy(nil_t) {
     heap_unmap(__RUNTIME->symbols, sizeof(struct symbols_t));
     env_destroy(&__RUNTIME->env);
     drop_obj(__RUNTIME->fdmaps);
+    drop_obj(__RUNTIME->zones);
+    drop_obj(__RUNTIME->grouped);
     // destroy dynamic libraries
     l = __RUNTIME->dynlibs->len;
     for (i = 0; i < l; i++) {
@@ -293,4 +297,83 @@ obj_p runtime_fdmap_get(runtime_p runtime, obj_p assoc) {
     return fdmap;
 }
 
+nil_t runtime_zone_push(runtime_p runtime, obj_p assoc, obj_p zone) {
+    obj_p id, r;
+
+    id = i64((i64_t)assoc);
+    r = set_obj(&runtime->zones, id, zone);
+    drop_obj(id);
+
+    if (IS_ERR(r)) {
+        DEBUG_OBJ(r);
+        return;
+    }
+}
+
+obj_p runtime_zone_pop(runtime_p runtime, obj_p assoc) {
+    obj_p id, zone;
+
+    // Most mapped columns have no zone map, keep their release cheap
+    if (AS_LIST(runtime->zones)[0]->len == 0)
+        return NULL_OBJ;
+
+    id = i64((i64_t)assoc);
+    zone = remove_obj(&runtime->zones, id);
+    drop_obj(id);
+
+    return zone;
+}
+
+obj_p runtime_zone_get(runtime_p runtime, obj_p assoc) {
+    obj_p id, zone;
+
+    if (AS_LIST(runtime->zones)[0]->len == 0)
+        return NULL_OBJ;
+
+    id = i64((i64_t)assoc);
+    zone = at_obj(runtime->zones, id);
+    drop_obj(id);
+
+    return zone;
+}
+
+nil_t runtime_grouped_push(runtime_p runtime, obj_p assoc, obj_p index) {
+    obj_p id, r;
+
+    id = i64((i64_t)assoc);
+    r = set_obj(&runtime->grouped, id, index);
+    drop_obj(id);
+
+    if (IS_ERR(r)) {
+        DEBUG_OBJ(r);
+        return;
+    }
+}
+
+obj_p runtime_grouped_pop(runtime_p runtime, obj_p assoc) {
+    obj_p id, index;
+
+    if (AS_LIST(runtime->grouped)[0]->len == 0)
+        return NULL_OBJ;
+
+    id = i64((i64_t)assoc);
+    index = remove_obj(&runtime->grouped, id);
+    drop_obj(id);
+
+    return index;
+}
+
+obj_p runtime_grouped_get(runtime_p runtime, obj_p assoc) {
+    obj_p id, index;
+
+    if (AS_LIST(runtime->grouped)[0]->len == 0)
+        return NULL_OBJ;
+
+    id = i64((i64_t)assoc);
+    index = at_obj(runtime->grouped, id);
+    drop_obj(id);
+
+    return index;
+}
+
 runtime_p runtime_get_ext(nil_t) { return __RUNTIME; }
\ No newline at end of file
@@ -45,6 +45,8 @@ typedef struct runtime_t {
     symbols_p symbols;      // vector_symbols pool.
     poll_p poll;            // I/O event loop handle.
     obj_p fdmaps;           // File descriptors mappings.
+    obj_p zones;            // Zone maps of mapped columns.
+    obj_p grouped;          // Group indexes of grouped columns.
     query_ctx_p query_ctx;  // Query context stack.
     pool_p pool;            // Executors pool.
     obj_p dynlibs;          // Dynamic libraries.
@@ -59,6 +61,12 @@ obj_p runtime_get_arg(lit_p key);
 nil_t runtime_fdmap_push(runtime_p runtime, obj_p assoc, obj_p fdmap);
 obj_p runtime_fdmap_pop(runtime_p runtime, obj_p assoc);
 obj_p runtime_fdmap_get(runtime_p runtime, obj_p assoc);
+nil_t runtime_zone_push(runtime_p runtime, obj_p assoc, obj_p zone);
+obj_p runtime_zone_pop(runtime_p runtime, obj_p assoc);
+obj_p runtime_zone_get(runtime_p runtime, obj_p assoc);
+nil_t runtime_grouped_push(runtime_p runtime, obj_p assoc, obj_p index);
+obj_p runtime_grouped_pop(runtime_p runtime, obj_p assoc);
+obj_p runtime_grouped_get(runtime_p runtime, obj_p assoc);
 inline __attribute__((always_inline)) runtime_p runtime_get(nil_t) { return __RUNTIME; }
 runtime_p runtime_get_ext(nil_t);
 
@@ -27,6 +27,181 @@
 #include "lambda.h"
 #include "env.h"
 #include "error.h"
+#include "hash.h"
+#include "compress.h"
+
+/*
+ * Symbol vectors are written either as their strings, or as a dictionary of their distinct strings followed by
+ * a code per row. The attrs byte of the vector holds the width of the codes, 0 for the strings.
+ */
+#define SYMDICT_MIN_LEN 16
+
+static i64_t symdict_width(i64_t count) {
+    if (count <= 1 << 8)
+        return ISIZEOF(u8_t);
+    if (count <= 1 << 16)
+        return ISIZEOF(u16_t);
+    return ISIZEOF(u32_t);
+}
+
+// Numbers the distinct symbols of a vector in the order they first appear. Returns NULL_OBJ when a dictionary would
+// not be smaller than the strings, the table from a symbol to its code otherwise, and the count and encoded size.
+static obj_p symdict_build(obj_p obj, i64_t *count, i64_t *size) {
+    i64_t i, l, n, p, s, plain, dict;
+    i64_t *keys, *vals, *syms;
+    obj_p ht;
+
+    l = obj->len;
+    if (l < SYMDICT_MIN_LEN)
+        return NULL_OBJ;
+
+    syms = AS_SYMBOL(obj);
+    ht = ht_oa_create(64, TYPE_I64);
+
+    for (i = 0, n = 0, plain = 0, dict = 0; i < l; i++) {
+        s = syms[i];
+        plain += SYMBOL_STRLEN(s) + 1;
+        p = ht_oa_tab_next_with(&ht, s, &hash_kmh, &hash_cmp_i64, NULL);
+        keys = AS_I64(AS_LIST(ht)[0]);
+        if (keys[p] != NULL_I64)
+            continue;
+
+        // mostly distinct values are cheaper as plain strings
+        if (++n > l / 2) {
+            drop_obj(ht);
+            return NULL_OBJ;
+        }
+
+        vals = AS_I64(AS_LIST(ht)[1]);
+        keys[p] = s;
+        vals[p] = n - 1;
+        dict += SYMBOL_STRLEN(s) + 1;
+
+        // probing only grows the table once it is full, keep it sparse instead
+        if (n * 4 > AS_LIST(ht)[0]->len * 3)
+            ht_oa_rehash(&ht, &hash_kmh, NULL);
+    }
+
+    *count = n;
+    *size = ISIZEOF(i64_t) + dict + l * symdict_width(n);
+
+    if (*size >= plain) {
+        drop_obj(ht);
+        return NULL_OBJ;
+    }
+
+    return ht;
+}
+
+static i64_t symdict_ser(u8_t *buf, obj_p obj, obj_p ht, i64_t count) {
+    i64_t i, l, c, w, p;
+    i64_t *keys, *vals, *syms;
+    u16_t c16;
+    u32_t c32;
+    obj_p dict;
+
+    l = obj->len;
+    w = symdict_width(count);
+    keys = AS_I64(AS_LIST(ht)[0]);
+    vals = AS_I64(AS_LIST(ht)[1]);
+
+    // the distinct strings in the order of their codes
+    dict = I64(count);
+    for (i = 0; i < AS_LIST(ht)[0]->len; i++) {
+        if (keys[i] != NULL_I64)
+            AS_I64(dict)[vals[i]] = keys[i];
+    }
+
+    memcpy(buf, &count, ISIZEOF(i64_t));
+    c = ISIZEOF(i64_t);
+    for (i = 0; i < count; i++) {
+        c += str_cpy((str_p)buf + c, str_from_symbol(AS_I64(dict)[i]));
+        buf[c++] = '\0';
+    }
+
+    drop_obj(dict);
+
+    syms = AS_SYMBOL(obj);
+    for (i = 0; i < l; i++) {
+        p = vals[ht_oa_tab_get_with(ht, syms[i], &hash_kmh, &hash_cmp_i64, NULL)];
+        if (w == ISIZEOF(u8_t)) {
+            buf[c + i] = (u8_t)p;
+        } else if (w == ISIZEOF(u16_t)) {
+            c16 = (u16_t)p;
+            memcpy(buf + c + i * w, &c16, w);
+        } else {
+            c32 = (u32_t)p;
+            memcpy(buf + c + i * w, &c32, w);
+        }
+    }
+
+    return c + l * w;
+}
+
+static obj_p symdict_de(u8_t *buf, i64_t *len, i64_t l, i64_t w) {
+    i64_t i, n, c, p;
+    u16_t c16;
+    u32_t c32;
+    obj_p dict, obj;
+
+    if (w != ISIZEOF(u8_t) && w != ISIZEOF(u16_t) && w != ISIZEOF(u32_t))
+        return error_str(ERR_IO, "de_raw: invalid symbol codes width");
+
+    if (*len < ISIZEOF(i64_t))
+        return error_str(ERR_IO, "de_raw: buffer underflow");
+
+    memcpy(&n, buf, ISIZEOF(i64_t));
+    buf += ISIZEOF(i64_t);
+    (*len) -= ISIZEOF(i64_t);
+
+    if (n < 0 || n > l || n > *len)
+        return error_str(ERR_IO, "de_raw: invalid symbol dictionary size");
+
+    // every distinct string is interned once
+    dict = SYMBOL(n);
+    for (i = 0; i < n; i++) {
+        c = str_len((str_p)buf, *len);
+        if (c >= *len) {
+            dict->len = i;
+            drop_obj(dict);
+            return error_str(ERR_IO, "de_raw: invalid symbol length");
+        }
+        AS_SYMBOL(dict)[i] = symbols_intern((str_p)buf, c);
+        buf += c + 1;
+        (*len) -= c + 1;
+    }
+
+    if (*len < l * w) {
+        drop_obj(dict);
+        return error_str(ERR_IO, "de_raw: buffer underflow");
+    }
+
+    obj = SYMBOL(l);
+    for (i = 0; i < l; i++) {
+        if (w == ISIZEOF(u8_t)) {
+            p = buf[i];
+        } else if (w == ISIZEOF(u16_t)) {
+            memcpy(&c16, buf + i * w, w);
+            p = c16;
+        } else {
+            memcpy(&c32, buf + i * w, w);
+            p = c32;
+        }
+
+        if (p >= n) {
+            drop_obj(dict);
+            drop_obj(obj);
+            return error_str(ERR_IO, "de_raw: invalid symbol code");
+        }
+
+        AS_SYMBOL(obj)[i] = AS_SYMBOL(dict)[p];
+    }
+
+    (*len) -= l * w;
+    drop_obj(dict);
+
+    return obj;
+}
 
 i64_t size_of_type(i8_t type) {
     switch (type) {
@@ -70,6 +245,9 @@ i64_t size_of(obj_p obj) {
     }
 
     switch (obj->type) {
+        case TYPE_STRINGS:
+            size += (obj->len + 1) * ISIZEOF(i64_t) + STRINGS_OFFS(obj)[obj->len];
+            return size;
         case TYPE_ENUM:
             size += obj->len * ISIZEOF(i64_t);
             return size;
@@ -84,10 +262,11 @@ i64_t size_of(obj_p obj) {
 }
 
 /*
- * Returns size (in bytes) that an obj occupy in memory via serialization
+ * Returns size (in bytes) that an obj occupy in memory via serialization, flags tell the encodings the reader accepts
  */
-i64_t size_obj(obj_p obj) {
-    i64_t i, l, size;
+i64_t size_obj_with(obj_p obj, u8_t flags) {
+    i64_t i, l, n, size;
+    obj_p ht;
 
     switch (obj->type) {
         case -TYPE_B8:
@@ -129,6 +308,13 @@ i64_t size_obj(obj_p obj) {
         case TYPE_C8:
             return ISIZEOF(i8_t) + 1 + ISIZEOF(i64_t) + obj->len * ISIZEOF(c8_t);
         case TYPE_SYMBOL:
+            if (flags & SERDE_FLAG_SYMDICT) {
+                ht = symdict_build(obj, &n, &size);
+                if (ht != NULL_OBJ) {
+                    drop_obj(ht);
+                    return ISIZEOF(i8_t) + 1 + ISIZEOF(i64_t) + size;
+                }
+            }
             l = obj->len;
             size = ISIZEOF(i8_t) + 1 + ISIZEOF(i64_t);
             for (i = 0; i < l; i++)
@@ -138,13 +324,17 @@ i64_t size_obj(obj_p obj) {
             l = obj->len;
             size = ISIZEOF(i8_t) + 1 + ISIZEOF(i64_t);
             for (i = 0; i < l; i++)
-                size += size_obj(AS_LIST(obj)[i]);
+                size += size_obj_with(AS_LIST(obj)[i], flags);
             return size;
+        case TYPE_STRINGS:
+            return ISIZEOF(i8_t) + 1 + ISIZEOF(i64_t) + (obj->len + 1) * ISIZEOF(i64_t) + STRINGS_OFFS(obj)[obj->len];
         case TYPE_TABLE:
         case TYPE_DICT:
-            return ISIZEOF(i8_t) + 1 + size_obj(AS_LIST(obj)[0]) + size_obj(AS_LIST(obj)[1]);
+            return ISIZEOF(i8_t) + 1 + size_obj_with(AS_LIST(obj)[0], flags) +
+                   size_obj_with(AS_LIST(obj)[1], flags);
         case TYPE_LAMBDA:
-            return ISIZEOF(i8_t) + 1 + ISIZEOF(i64_t) + size_obj(AS_LAMBDA(obj)->args) + size_obj(AS_LAMBDA(obj)->body);
+            return ISIZEOF(i8_t) + 1 + ISIZEOF(i64_t) + size_obj_with(AS_LAMBDA(obj)->args, flags) +
+                   size_obj_with(AS_LAMBDA(obj)->body, flags);
         case TYPE_UNARY:
         case TYPE_BINARY:
         case TYPE_VARY:
@@ -152,15 +342,18 @@ i64_t size_obj(obj_p obj) {
         case TYPE_NULL:
             return ISIZEOF(i8_t);
         case TYPE_ERR:
-            return ISIZEOF(i8_t) + ISIZEOF(i8_t) + size_obj(AS_ERROR(obj)->msg);
+            return ISIZEOF(i8_t) + ISIZEOF(i8_t) + size_obj_with(AS_ERROR(obj)->msg, flags);
         default:
             return 0;
     }
 }
 
-i64_t ser_raw(u8_t *buf, obj_p obj) {
-    i64_t i, l, c;
+i64_t size_obj(obj_p obj) { return size_obj_with(obj, SERDE_FLAG_SYMDICT); }
+
+i64_t ser_raw_with(u8_t *buf, obj_p obj, u8_t flags) {
+    i64_t i, l, n, c;
     str_p s;
+    obj_p ht;
 
     buf[0] = obj->type;
     buf++;
@@ -271,11 +464,17 @@ i64_t ser_raw(u8_t *buf, obj_p obj) {
 
             return ISIZEOF(i8_t) + ISIZEOF(i64_t) + l * ISIZEOF(f64_t) + 1;
         case TYPE_SYMBOL:
-            buf[0] = 0;  // attrs
+            ht = (flags & SERDE_FLAG_SYMDICT) ? symdict_build(obj, &n, &c) : NULL_OBJ;
+            buf[0] = (ht != NULL_OBJ) ? symdict_width(n) : 0;  // attrs
             buf++;
             l = obj->len;
             memcpy(buf, &l, ISIZEOF(i64_t));
             buf += ISIZEOF(i64_t);
+            if (ht != NULL_OBJ) {
+                c = symdict_ser(buf, obj, ht, n);
+                drop_obj(ht);
+                return ISIZEOF(i8_t) + ISIZEOF(i64_t) + c + 1;
+            }
             for (i = 0, c = 0; i < l; i++) {
                 s = str_from_symbol(AS_SYMBOL(obj)[i]);
                 c += str_cpy((str_p)buf + c, s);
@@ -299,21 +498,31 @@ i64_t ser_raw(u8_t *buf, obj_p obj) {
             memcpy(buf, &l, ISIZEOF(i64_t));
             buf += ISIZEOF(i64_t);
             for (i = 0, c = 0; i < l; i++)
-                c += ser_raw(buf + c, AS_LIST(obj)[i]);
+                c += ser_raw_with(buf + c, AS_LIST(obj)[i], flags);
 
             return ISIZEOF(i8_t) + ISIZEOF(i64_t) + c + 1;
+        case TYPE_STRINGS:
+            buf[0] = 0;  // attrs
+            buf++;
+            l = obj->len;
+            memcpy(buf, &l, ISIZEOF(i64_t));
+            buf += ISIZEOF(i64_t);
+            // offsets and bytes as they are in memory, so that reading them back is a single copy
+            c = (l + 1) * ISIZEOF(i64_t) + STRINGS_OFFS(obj)[l];
+            memcpy(buf, STRINGS_OFFS(obj), c);
+            return ISIZEOF(i8_t) + ISIZEOF(i64_t) + c + 1;
         case TYPE_TABLE:
         case TYPE_DICT:
             buf[0] = 0;  // attrs
             buf++;
-            c = ser_raw(buf, AS_LIST(obj)[0]);
-            c += ser_raw(buf + c, AS_LIST(obj)[1]);
+            c = ser_raw_with(buf, AS_LIST(obj)[0], flags);
+            c += ser_raw_with(buf + c, AS_LIST(obj)[1], flags);
             return ISIZEOF(i8_t) + c + 1;
         case TYPE_LAMBDA:
             buf[0] = 0;  // attrs
             buf++;
-            c = ser_raw(buf, AS_LAMBDA(obj)->args);
-            c += ser_raw(buf + c, AS_LAMBDA(obj)->body);
+            c = ser_raw_with(buf, AS_LAMBDA(obj)->args, flags);
+            c += ser_raw_with(buf + c, AS_LAMBDA(obj)->body, flags);
             return ISIZEOF(i8_t) + c + 1;
         case TYPE_UNARY:
         case TYPE_BINARY:
@@ -323,13 +532,15 @@ i64_t ser_raw(u8_t *buf, obj_p obj) {
         case TYPE_ERR:
             buf[0] = (i8_t)AS_ERROR(obj)->code;
             c = ISIZEOF(i8_t);
-            c += ser_raw(buf + c, AS_ERROR(obj)->msg);
+            c += ser_raw_with(buf + c, AS_ERROR(obj)->msg, flags);
             return ISIZEOF(i8_t) + c;
         default:
             return 0;
     }
 }
 
+i64_t ser_raw(u8_t *buf, obj_p obj) { return ser_raw_with(buf, obj, SERDE_FLAG_SYMDICT); }
+
 obj_p ser_obj(obj_p obj) {
     i64_t size = size_obj(obj);
     obj_p buf;
@@ -343,7 +554,7 @@ obj_p ser_obj(obj_p obj) {
 
     header->prefix = SERDE_PREFIX;
     header->version = RAYFORCE_VERSION;
-    header->flags = 0;
+    header->flags = SERDE_FLAG_SYMDICT;
     header->endian = 0;
     header->msgtype = 0;
     header->size = size;
@@ -357,6 +568,7 @@ obj_p ser_obj(obj_p obj) {
 }
 
 obj_p de_raw(u8_t *buf, i64_t *len) {
+    u8_t attrs;
     i8_t code;
     i64_t i, l, c, id;
     obj_p obj, k, v;
@@ -460,10 +672,12 @@ obj_p de_raw(u8_t *buf, i64_t *len) {
         case TYPE_SYMBOL:
         case TYPE_GUID:
         case TYPE_LIST:
+        case TYPE_STRINGS:
             if (*len < ISIZEOF(i64_t))
                 return error_str(ERR_IO, "de_raw: buffer underflow");
 
-            buf++;  // skip attrs
+            attrs = buf[0];
+            buf++;
             memcpy(&l, buf, ISIZEOF(i64_t));
             buf += ISIZEOF(i64_t);
             (*len) -= ISIZEOF(i64_t) + 1;
@@ -540,6 +754,8 @@ obj_p de_raw(u8_t *buf, i64_t *len) {
                     (*len) -= l * ISIZEOF(f64_t);
                     return obj;
                 case TYPE_SYMBOL:
+                    if (attrs != 0)
+                        return symdict_de(buf, len, l, attrs);
                     obj = SYMBOL(l);
                     if (IS_ERR(obj))
                         return obj;
@@ -587,6 +803,25 @@ obj_p de_raw(u8_t *buf, i64_t *len) {
                         AS_LIST(obj)[i] = v;
                     }
                     return obj;
+                case TYPE_STRINGS:
+                    if (*len < (l + 1) * ISIZEOF(i64_t))
+                        return error_str(ERR_IO, "de_raw: buffer underflow");
+                    memcpy(&c, buf + l * ISIZEOF(i64_t), ISIZEOF(i64_t));
+                    if (c < 0 || *len - (l + 1) * ISIZEOF(i64_t) < c)
+                        return error_str(ERR_IO, "de_raw: buffer underflow");
+                    obj = strings(l, c);
+                    if (IS_ERR(obj))
+                        return obj;
+                    memcpy(STRINGS_OFFS(obj), buf, (l + 1) * ISIZEOF(i64_t) + c);
+                    for (i = 0; i < l; i++) {
+                        if (STRINGS_OFFS(obj)[i] < 0 || STRINGS_OFFS(obj)[i] > STRINGS_OFFS(obj)[i + 1]) {
+                            drop_obj(obj);
+                            return error_str(ERR_IO, "de_raw: invalid string offsets");
+                        }
+                    }
+                    buf += (l + 1) * ISIZEOF(i64_t) + c;
+                    (*len) -= (l + 1) * ISIZEOF(i64_t) + c;
+                    return obj;
             }
             // Should never reach here
             return error_str(ERR_IO, "de_raw: internal error");
@@ -696,5 +931,8 @@ obj_p de_obj(obj_p obj) {
     len = header->size;
     buf += ISIZEOF(struct ipc_header_t);
 
+    if (header->flags & SERDE_FLAG_COMPRESSED)
+        return decompress_obj(buf, len);
+
     return de_raw(buf, &len);
 }
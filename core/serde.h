@@ -29,6 +29,11 @@
 
 #define SERDE_PREFIX 0xcefadefa
 
+// Header flags
+#define SERDE_FLAG_SYMDICT 0x01     // symbol vectors may come as a dictionary of their distinct values plus codes
+#define SERDE_FLAG_COMPRESS 0x02    // the sender reads compressed payloads
+#define SERDE_FLAG_COMPRESSED 0x04  // the payload is a compressed frame
+
 typedef struct ipc_header_t {
     u32_t prefix;  // marker
     u8_t version;  // version of the app
@@ -42,8 +47,10 @@ RAYASSERT(sizeof(ipc_header_t) == 16, ipc_header_t)
 
 obj_p de_raw(u8_t *buf, i64_t *len);
 i64_t ser_raw(u8_t *buf, obj_p obj);
+i64_t ser_raw_with(u8_t *buf, obj_p obj, u8_t flags);
 i64_t size_of_type(i8_t type);
 i64_t size_of(obj_p obj);
 i64_t size_obj(obj_p obj);
+i64_t size_obj_with(obj_p obj, u8_t flags);
 
 #endif  // SERDE_H
@@ -26,17 +26,11 @@
 #include "ops.h"
 #include "error.h"
 #include "symbols.h"
-
-// Maximum range for counting sort - configurable constant
-#define COUNTING_SORT_MAX_RANGE 1000000
+#include "pool.h"
 
 // Function pointer for comparison
 typedef i64_t (*compare_func_t)(obj_p vec, i64_t idx_i, i64_t idx_j);
 
-// Forward declarations for optimized sorting functions
-static obj_p ray_iasc_optimized(obj_p x);
-static obj_p ray_idesc_optimized(obj_p x);
-
 static i64_t compare_symbols(obj_p vec, i64_t idx_i, i64_t idx_j) {
     i64_t sym_i = AS_I64(vec)[idx_i];
     i64_t sym_j = AS_I64(vec)[idx_j];
@@ -183,199 +177,502 @@ obj_p ray_sort_asc_u8(obj_p vec) {
 
     return indices;
 }
+// Helper inline function to convert f64 to sortable u64
+static inline u64_t f64_to_sortable_u64(f64_t value) {
+    union {
+        f64_t f;
+        u64_t u;
+    } u;
 
-obj_p ray_sort_asc_i16(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    i64_t* ov = AS_I64(indices);
-    i16_t* iv = AS_I16(vec);
-
-    u64_t pos[65537] = {0};
+    if (ISNANF64(value)) {
+        return 0ull;
+    }
+    u.f = value;
 
-    for (i = 0; i < len; i++) {
-        pos[iv[i] + 32769]++;
+    // Flip sign bit for negative values to maintain correct ordering
+    if (u.u & 0x8000000000000000ULL) {
+        u.u = ~u.u;
+    } else {
+        u.u |= 0x8000000000000000ULL;
     }
-    for (i = 2; i <= 65536; i++) {
-        pos[i] += pos[i - 1];
+
+    return u.u;
+}
+
+// Rows of a vector in the order of their keys, by a radix sort. Keys are mapped to unsigned integers of the same
+// order (inverted for descending sorts) and taken relative to their min, so only the digits their range spans are
+// passed over. Every pass counts digits per chunk, turns the counts into write cursors and scatters keys along with
+// their rows, chunks go in parallel and equal keys keep the order of their rows. Narrow keys take least significant
+// digit passes over the whole vector; wide ones are split by their most significant digit first and every bucket
+// is then sorted by the rest of its digits on its own, while it stays in cache
+typedef struct __sort_radix_ctx_t {
+    obj_p vec;
+    i64_t *rows;     // rows to sort, NULL for the whole vector
+    u64_t flip;      // all ones for descending sorts
+    i64_t chunks;
+    b8_t whole;      // one chunk, the digits of all the passes are counted at once
+    i64_t bits;      // digit width
+    i64_t passes;
+    i64_t shift;     // digit of the current pass
+    b8_t last;       // the last pass, keys are not needed anymore
+    u64_t min;
+    u64_t *mins;     // per chunk
+    u64_t *maxs;     // per chunk
+    i64_t *counts;   // per chunk digits, then their write cursors
+    i64_t *starts;   // buckets of the most significant digit
+    u64_t *keys;
+    i64_t *ids;
+    u64_t *tkeys;
+    i64_t *tids;
+}* sort_radix_ctx_p;
+
+#define SORT_RADIX_BITS 11          // buckets of a chunk fit in L1 alongside their write streams
+#define SORT_RADIX_MSD 65536        // shorter vectors are not worth splitting by the most significant digit
+#define SORT_RADIX_BUCKET_BITS 8    // digit width within a bucket
+#define SORT_RADIX_INSERT 32        // buckets up to this long are sorted by insertion
+#define SORT_RADIX_CACHE 16384      // buckets up to this long stay in cache through their passes
+#define SORT_RADIX_DIGIT(ctx, k) ((((k) - (ctx)->min) >> (ctx)->shift) & ((1ull << (ctx)->bits) - 1))
+
+#define SORT_RADIX_LOAD(key)                                 \
+    for (i = offset; i < l; i++) {                           \
+        r = (ctx->rows == NULL) ? i : ctx->rows[i];          \
+        u = (u64_t)(key) ^ ctx->flip;                        \
+        ctx->keys[i] = u;                                    \
+        ctx->ids[i] = r;                                     \
+        lo = (u < lo) ? u : lo;                              \
+        hi = (u > hi) ? u : hi;                              \
     }
 
-    for (i = 0; i < len; i++) {
-        ov[pos[iv[i] + 32768]++] = i;
+static obj_p sort_radix_load(sort_radix_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, r, l;
+    u64_t u, lo, hi;
+    obj_p vec;
+
+    vec = ctx->vec;
+    l = offset + len;
+    lo = ~0ull;
+    hi = 0;
+
+    switch (vec->type) {
+        case TYPE_B8:
+        case TYPE_U8:
+        case TYPE_C8:
+            SORT_RADIX_LOAD(AS_U8(vec)[r]);
+            break;
+        case TYPE_I16:
+            SORT_RADIX_LOAD((u16_t)AS_I16(vec)[r] ^ 0x8000);
+            break;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            SORT_RADIX_LOAD((u32_t)AS_I32(vec)[r] ^ 0x80000000);
+            break;
+        case TYPE_F64:
+            SORT_RADIX_LOAD(f64_to_sortable_u64(AS_F64(vec)[r]));
+            break;
+        default:
+            SORT_RADIX_LOAD((u64_t)AS_I64(vec)[r] ^ 0x8000000000000000ull);
+            break;
     }
 
-    return indices;
+    ctx->mins[chunk] = lo;
+    ctx->maxs[chunk] = hi;
+
+    return NULL_OBJ;
 }
 
-obj_p ray_sort_asc_i32(obj_p vec) {
-    i64_t i, t, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    i32_t* iv = AS_I32(vec);
-    i64_t* ti = AS_I64(temp);
+// With one chunk the order of keys does not matter to their counts, so all the passes are counted at once
+static obj_p sort_radix_count(sort_radix_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, p, l, passes, *counts;
+    u64_t k, m;
+
+    l = offset + len;
+    m = (1ull << ctx->bits) - 1;
 
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
+    if (!ctx->whole) {
+        counts = ctx->counts + (chunk << ctx->bits);
+        memset(counts, 0, sizeof(i64_t) << ctx->bits);
 
-    for (i = 0; i < len; i++) {
-        t = (u32_t)iv[i] ^ 0x80000000;
-        pos1[(t & 0xffff) + 1]++;
-        pos2[(t >> 16) + 1]++;
+        for (i = offset; i < l; i++)
+            counts[((ctx->keys[i] - ctx->min) >> ctx->shift) & m]++;
+
+        return NULL_OBJ;
     }
-    for (i = 2; i <= 65536; i++) {
-        pos1[i] += pos1[i - 1];
-        pos2[i] += pos2[i - 1];
+
+    passes = ctx->passes;
+    counts = ctx->counts;
+    memset(counts, 0, (sizeof(i64_t) * passes) << ctx->bits);
+
+    for (i = offset; i < l; i++) {
+        k = ctx->keys[i] - ctx->min;
+        for (p = 0; p < passes; p++)
+            counts[(p << ctx->bits) + ((k >> (p * ctx->bits)) & m)]++;
     }
-    for (i = 0; i < len; i++) {
-        t = (u32_t)iv[i];
-        ti[pos1[iv[i] & 0xffff]++] = i;
+
+    return NULL_OBJ;
+}
+
+static obj_p sort_radix_scatter(sort_radix_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, l, p, *counts;
+    u64_t k;
+
+    l = offset + len;
+    counts = ctx->counts + ((ctx->whole ? ctx->shift / ctx->bits : chunk) << ctx->bits);
+
+    if (ctx->last) {
+        for (i = offset; i < l; i++)
+            ctx->tids[counts[SORT_RADIX_DIGIT(ctx, ctx->keys[i])]++] = ctx->ids[i];
+
+        return NULL_OBJ;
     }
-    for (i = 0; i < len; i++) {
-        t = (u32_t)iv[ti[i]] ^ 0x80000000;
-        ov[pos2[t >> 16]++] = ti[i];
+
+    for (i = offset; i < l; i++) {
+        k = ctx->keys[i];
+        p = counts[SORT_RADIX_DIGIT(ctx, k)]++;
+        ctx->tkeys[p] = k;
+        ctx->tids[p] = ctx->ids[i];
     }
 
-    drop_obj(temp);
-    return indices;
+    return NULL_OBJ;
 }
 
-// Helper inline function to convert f64 to sortable u64
-static inline u64_t f64_to_sortable_u64(f64_t value) {
-    union {
-        f64_t f;
-        u64_t u;
-    } u;
+// Keys of a bucket sorted by the digits below the most significant one, rows follow them. True if they end up in
+// the scratch arrays rather than in place
+static b8_t sort_radix_bucket(u64_t *keys, i64_t *ids, u64_t *tkeys, i64_t *tids, i64_t n, b8_t keep) {
+    i64_t i, j, p, c, r, passes, done, width, shift, counts[64 / SORT_RADIX_BUCKET_BITS][1 << SORT_RADIX_BUCKET_BITS];
+    b8_t skip[64 / SORT_RADIX_BUCKET_BITS] = {0};
+    u64_t k, lo, hi, *sk, *tk;
+    i64_t *si, *ti;
+
+    if (n <= SORT_RADIX_INSERT) {
+        for (i = 1; i < n; i++) {
+            k = keys[i];
+            r = ids[i];
+            for (j = i; j > 0 && keys[j - 1] > k; j--) {
+                keys[j] = keys[j - 1];
+                ids[j] = ids[j - 1];
+            }
+            keys[j] = k;
+            ids[j] = r;
+        }
 
-    if (ISNANF64(value)) {
-        return 0ull;
+        return B8_FALSE;
     }
-    u.f = value;
 
-    // Flip sign bit for negative values to maintain correct ordering
-    if (u.u & 0x8000000000000000ULL) {
-        u.u = ~u.u;
-    } else {
-        u.u |= 0x8000000000000000ULL;
+    lo = ~0ull;
+    hi = 0;
+    for (i = 0; i < n; i++) {
+        lo = (keys[i] < lo) ? keys[i] : lo;
+        hi = (keys[i] > hi) ? keys[i] : hi;
     }
 
-    return u.u;
-}
+    if (lo == hi)
+        return B8_FALSE;
 
-obj_p ray_sort_asc_i64(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    i64_t* iv = AS_I64(vec);
-    i64_t* t = AS_I64(temp);
+    width = 64 - __builtin_clzll(hi - lo);
 
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-    u64_t pos3[65537] = {0};
-    u64_t pos4[65537] = {0};
+    // too long to stay in cache: split by the next most significant digit and sort the parts
+    if (n > SORT_RADIX_CACHE && width > 2 * SORT_RADIX_BUCKET_BITS) {
+        shift = width - SORT_RADIX_BUCKET_BITS;
+        memset(counts[0], 0, sizeof(counts[0]));
 
-    // Count occurrences of each 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[i] ^ 0x8000000000000000ULL;
-        pos1[(u & 0xffff) + 1]++;
-        pos2[((u >> 16) & 0xffff) + 1]++;
-        pos3[((u >> 32) & 0xffff) + 1]++;
-        pos4[(u >> 48) + 1]++;
+        for (i = 0; i < n; i++)
+            counts[0][(keys[i] - lo) >> shift]++;
+
+        for (i = 0, r = 0; i < (1 << SORT_RADIX_BUCKET_BITS); i++) {
+            c = counts[0][i];
+            counts[0][i] = r;
+            counts[1][i] = r;
+            r += c;
+        }
+
+        for (i = 0; i < n; i++) {
+            j = counts[0][(keys[i] - lo) >> shift]++;
+            tkeys[j] = keys[i];
+            tids[j] = ids[i];
+        }
+
+        // the parts are copied back only when they are sorted into the scratch arrays, still in cache then
+        for (i = 0; i < (1 << SORT_RADIX_BUCKET_BITS); i++) {
+            c = counts[1][i];
+            r = counts[0][i] - c;
+            if (!sort_radix_bucket(tkeys + c, tids + c, keys + c, ids + c, r, keep)) {
+                memcpy(ids + c, tids + c, r * sizeof(i64_t));
+                if (keep)
+                    memcpy(keys + c, tkeys + c, r * sizeof(u64_t));
+            }
+        }
+
+        return B8_FALSE;
     }
 
-    // Calculate cumulative positions for each pass
-    for (i = 2; i <= 65536; i++) {
-        pos1[i] += pos1[i - 1];
-        pos2[i] += pos2[i - 1];
-        pos3[i] += pos3[i - 1];
-        pos4[i] += pos4[i - 1];
+    passes = (width + SORT_RADIX_BUCKET_BITS - 1) / SORT_RADIX_BUCKET_BITS;
+    memset(counts, 0, sizeof(counts[0]) * passes);
+
+    for (i = 0; i < n; i++) {
+        k = keys[i] - lo;
+        for (p = 0; p < passes; p++)
+            counts[p][(k >> (p * SORT_RADIX_BUCKET_BITS)) & ((1 << SORT_RADIX_BUCKET_BITS) - 1)]++;
     }
 
-    // First pass: sort by least significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[i] ^ 0x8000000000000000ULL;
-        t[pos1[u & 0xffff]++] = i;
+    // a digit all the keys share orders nothing, its pass is skipped
+    for (p = 0, done = 0; p < passes; p++) {
+        for (i = 0, r = 0; i < (1 << SORT_RADIX_BUCKET_BITS); i++) {
+            c = counts[p][i];
+            counts[p][i] = r;
+            r += c;
+            skip[p] = (c == n) ? B8_TRUE : skip[p];
+        }
     }
 
-    // Second pass: sort by second 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[t[i]] ^ 0x8000000000000000ULL;
-        ov[pos2[(u >> 16) & 0xffff]++] = t[i];
+    sk = keys;
+    si = ids;
+    tk = tkeys;
+    ti = tids;
+
+    for (p = 0; p < passes; p++) {
+        if (skip[p])
+            continue;
+
+        shift = p * SORT_RADIX_BUCKET_BITS;
+        for (i = 0; i < n; i++) {
+            k = sk[i];
+            j = counts[p][((k - lo) >> shift) & ((1 << SORT_RADIX_BUCKET_BITS) - 1)]++;
+            tk[j] = k;
+            ti[j] = si[i];
+        }
+
+        tk = sk;
+        sk = (tk == keys) ? tkeys : keys;
+        ti = si;
+        si = (ti == ids) ? tids : ids;
+        done++;
     }
 
-    // Third pass: sort by third 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[ov[i]] ^ 0x8000000000000000ULL;
-        t[pos3[(u >> 32) & 0xffff]++] = ov[i];
+    return (done & 1);
+}
+
+static obj_p sort_radix_buckets(sort_radix_ctx_p ctx, i64_t from, i64_t to) {
+    i64_t b, s, n;
+
+    for (b = from; b < to; b++) {
+        s = ctx->starts[b];
+        n = ctx->starts[b + 1] - s;
+        if (sort_radix_bucket(ctx->keys + s, ctx->ids + s, ctx->tkeys + s, ctx->tids + s, n, !ctx->last)) {
+            memcpy(ctx->ids + s, ctx->tids + s, n * sizeof(i64_t));
+            if (!ctx->last)
+                memcpy(ctx->keys + s, ctx->tkeys + s, n * sizeof(u64_t));
+        }
     }
 
-    // Fourth pass: sort by most significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[t[i]] ^ 0x8000000000000000ULL;
-        ov[pos4[u >> 48]++] = t[i];
+    return NULL_OBJ;
+}
+
+static nil_t sort_radix_run(pool_p pool, raw_p fn, sort_radix_ctx_p ctx, i64_t chunks, i64_t len) {
+    i64_t c, chunk;
+
+    if (chunks == 1) {
+        ((obj_p(*)(sort_radix_ctx_p, i64_t, i64_t, i64_t))fn)(ctx, 0, len, 0);
+        return;
     }
 
-    drop_obj(temp);
-    return indices;
+    chunk = len / chunks;
+
+    pool_prepare(pool);
+    for (c = 0; c < chunks - 1; c++)
+        pool_add_task(pool, fn, 4, ctx, c, chunk, c * chunk);
+    pool_add_task(pool, fn, 4, ctx, c, len - c * chunk, c * chunk);
+    drop_obj(pool_run(pool));
 }
 
-obj_p ray_sort_asc_f64(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    f64_t* fv = AS_F64(vec);
-    i64_t* t = AS_I64(temp);
+// Equal symbols are adjacent once sorted by their addresses, so the runs only need to be put in the order of
+// their strings, which takes one comparison sort of the distinct ones
+static obj_p sort_radix_symbols(u64_t *keys, obj_p ids, i64_t asc) {
+    i64_t i, j, n, d, o, *starts, *order, *out;
+    obj_p runs, syms, ord, res;
+
+    n = ids->len;
 
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-    u64_t pos3[65537] = {0};
-    u64_t pos4[65537] = {0};
+    for (i = 0, d = 0; i < n; i++)
+        d += (i == 0 || keys[i] != keys[i - 1]);
 
-    // Count occurrences of each 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[i]);
+    runs = I64(d + 1);
+    syms = SYMBOL(d);
+    starts = AS_I64(runs);
 
-        pos1[(u & 0xffff) + 1]++;
-        pos2[((u >> 16) & 0xffff) + 1]++;
-        pos3[((u >> 32) & 0xffff) + 1]++;
-        pos4[(u >> 48) + 1]++;
+    for (i = 0, d = 0; i < n; i++) {
+        if (i == 0 || keys[i] != keys[i - 1]) {
+            starts[d] = i;
+            AS_SYMBOL(syms)[d++] = (i64_t)(keys[i] ^ 0x8000000000000000ull);
+        }
     }
+    starts[d] = n;
+
+    ord = mergesort_generic_obj(syms, asc);
+    order = AS_I64(ord);
 
-    // Calculate cumulative positions for each pass
-    for (i = 2; i <= 65536; i++) {
-        pos1[i] += pos1[i - 1];
-        pos2[i] += pos2[i - 1];
-        pos3[i] += pos3[i - 1];
-        pos4[i] += pos4[i - 1];
+    for (j = 0; j < d && order[j] == j; j++)
+        ;
+
+    if (j == d) {
+        drop_obj(runs);
+        drop_obj(syms);
+        drop_obj(ord);
+        return ids;
     }
 
-    // First pass: sort by least significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[i]);
-        t[pos1[u & 0xffff]++] = i;
+    res = I64(n);
+    out = AS_I64(res);
+
+    for (j = 0; j < d; j++) {
+        o = order[j];
+        memcpy(out, AS_I64(ids) + starts[o], (starts[o + 1] - starts[o]) * sizeof(i64_t));
+        out += starts[o + 1] - starts[o];
     }
 
-    // Second pass: sort by second 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[t[i]]);
-        ov[pos2[(u >> 16) & 0xffff]++] = t[i];
+    drop_obj(runs);
+    drop_obj(syms);
+    drop_obj(ord);
+    drop_obj(ids);
+
+    return res;
+}
+
+static obj_p sort_radix(obj_p vec, obj_p rows, i64_t asc) {
+    i64_t c, b, i, n, p, len, chunks, buckets, width, from;
+    u64_t max, *tk;
+    i64_t *ti, *counts;
+    obj_p keys, tkeys, ids, tids, cnts, starts, bounds, t;
+    b8_t sym, msd;
+    pool_p pool;
+    struct __sort_radix_ctx_t ctx;
+
+    len = (rows == NULL_OBJ) ? vec->len : rows->len;
+    sym = (vec->type == TYPE_SYMBOL);
+    pool = pool_get();
+    chunks = pool_split_by(pool, len, 0);
+
+    ctx.vec = vec;
+    ctx.rows = (rows == NULL_OBJ) ? NULL : AS_I64(rows);
+    ctx.flip = (asc > 0 || sym) ? 0 : ~0ull;
+    ctx.chunks = chunks;
+
+    keys = I64(len);
+    ids = I64(len);
+    bounds = I64(chunks * 2);
+    ctx.keys = (u64_t *)AS_I64(keys);
+    ctx.ids = AS_I64(ids);
+    ctx.mins = (u64_t *)AS_I64(bounds);
+    ctx.maxs = ctx.mins + chunks;
+
+    sort_radix_run(pool, (raw_p)sort_radix_load, &ctx, chunks, len);
+
+    ctx.min = ~0ull;
+    max = 0;
+    for (c = 0; c < chunks; c++) {
+        ctx.min = (ctx.mins[c] < ctx.min) ? ctx.mins[c] : ctx.min;
+        max = (ctx.maxs[c] > max) ? ctx.maxs[c] : max;
     }
 
-    // Third pass: sort by third 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[ov[i]]);
-        t[pos3[(u >> 32) & 0xffff]++] = ov[i];
+    drop_obj(bounds);
+
+    if (len == 0 || max == ctx.min) {
+        drop_obj(keys);
+        return ids;
     }
 
-    // Fourth pass: sort by most significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[t[i]]);
-        ov[pos4[u >> 48]++] = t[i];
+    // digits are evened out over the passes the range needs, so the histograms are no wider than they have to be
+    width = 64 - __builtin_clzll(max - ctx.min);
+    msd = (width > 2 * SORT_RADIX_BITS && len >= SORT_RADIX_MSD);
+    ctx.passes = msd ? 1 : (width + SORT_RADIX_BITS - 1) / SORT_RADIX_BITS;
+    ctx.bits = msd ? SORT_RADIX_BITS : (width + ctx.passes - 1) / ctx.passes;
+    ctx.whole = (chunks == 1 && !msd);
+    buckets = 1ll << ctx.bits;
+
+    tkeys = I64(len);
+    tids = I64(len);
+    cnts = I64((ctx.whole ? ctx.passes : chunks) * buckets);
+    starts = I64(buckets + 1);
+    ctx.tkeys = (u64_t *)AS_I64(tkeys);
+    ctx.tids = AS_I64(tids);
+    ctx.counts = counts = AS_I64(cnts);
+    ctx.starts = AS_I64(starts);
+
+    if (ctx.whole) {
+        ctx.shift = 0;
+        sort_radix_count(&ctx, 0, len, 0);
+        for (p = 0; p < ctx.passes; p++) {
+            for (b = 0, n = 0; b < buckets; b++) {
+                i = counts[(p << ctx.bits) + b];
+                counts[(p << ctx.bits) + b] = n;
+                n += i;
+            }
+        }
     }
 
-    drop_obj(temp);
-    return indices;
+    for (p = 0; p < ctx.passes; p++) {
+        ctx.shift = msd ? width - ctx.bits : p * ctx.bits;
+        ctx.last = !sym && !msd && (p == ctx.passes - 1);
+
+        if (!ctx.whole) {
+            sort_radix_run(pool, (raw_p)sort_radix_count, &ctx, chunks, len);
+
+            for (b = 0, n = 0; b < buckets; b++) {
+                ctx.starts[b] = n;
+                for (c = 0; c < chunks; c++) {
+                    i = counts[(c << ctx.bits) + b];
+                    counts[(c << ctx.bits) + b] = n;
+                    n += i;
+                }
+            }
+            ctx.starts[buckets] = n;
+        }
+
+        sort_radix_run(pool, (raw_p)sort_radix_scatter, &ctx, chunks, len);
+
+        tk = ctx.keys;
+        ctx.keys = ctx.tkeys;
+        ctx.tkeys = tk;
+        ti = ctx.ids;
+        ctx.ids = ctx.tids;
+        ctx.tids = ti;
+        t = ids;
+        ids = tids;
+        tids = t;
+        t = keys;
+        keys = tkeys;
+        tkeys = t;
+    }
+
+    // buckets go to tasks in runs of about the same number of rows
+    if (msd) {
+        ctx.last = !sym;
+
+        if (chunks == 1) {
+            sort_radix_buckets(&ctx, 0, buckets);
+        } else {
+            pool_prepare(pool);
+            for (b = 0, from = 0, c = 1; b < buckets; b++) {
+                if (ctx.starts[b + 1] >= c * (len / chunks) || b == buckets - 1) {
+                    pool_add_task(pool, (raw_p)sort_radix_buckets, 3, &ctx, from, b + 1);
+                    from = b + 1;
+                    c = ctx.starts[b + 1] / (len / chunks) + 1;
+                }
+            }
+            drop_obj(pool_run(pool));
+        }
+    }
+
+    if (sym)
+        ids = sort_radix_symbols(ctx.keys, ids, asc);
+
+    drop_obj(keys);
+    drop_obj(tkeys);
+    drop_obj(tids);
+    drop_obj(cnts);
+    drop_obj(starts);
+
+    return ids;
 }
 
 obj_p ray_sort_asc(obj_p vec) {
@@ -408,19 +705,14 @@ obj_p ray_sort_asc(obj_p vec) {
         case TYPE_C8:
             return ray_sort_asc_u8(vec);
         case TYPE_I16:
-            return ray_sort_asc_i16(vec);
         case TYPE_I32:
         case TYPE_DATE:
         case TYPE_TIME:
-            return ray_sort_asc_i32(vec);
         case TYPE_I64:
         case TYPE_TIMESTAMP:
-            return ray_sort_asc_i64(vec);
         case TYPE_F64:
-            return ray_sort_asc_f64(vec);
         case TYPE_SYMBOL:
-            // Use optimized sorting
-            return ray_iasc_optimized(vec);
+            return sort_radix(vec, NULL_OBJ, 1);
         case TYPE_LIST:
             return mergesort_generic_obj(vec, 1);
         case TYPE_DICT:
@@ -450,163 +742,6 @@ obj_p ray_sort_desc_u8(obj_p vec) {
     return indices;
 }
 
-obj_p ray_sort_desc_i16(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    i64_t* ov = AS_I64(indices);
-    i16_t* iv = AS_I16(vec);
-
-    u64_t pos[65537] = {0};
-
-    for (i = 0; i < len; i++)
-        pos[(u16_t)(iv[i] + 32768)]++;
-
-    for (i = 65534; i >= 0; i--)
-        pos[i] += pos[i + 1];
-
-    for (i = 0; i < len; i++)
-        ov[pos[(u64_t)(iv[i] + 32769)]++] = i;
-
-    return indices;
-}
-
-obj_p ray_sort_desc_i32(obj_p vec) {
-    i64_t i, t, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    i32_t* iv = AS_I32(vec);
-    i64_t* ti = AS_I64(temp);
-
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-
-    for (i = 0; i < len; i++) {
-        t = (u32_t)iv[i] ^ 0x80000000;
-        pos1[t & 0xffff]++;
-        pos2[t >> 16]++;
-    }
-    for (i = 65534; i >= 0; i--) {
-        pos1[i] += pos1[i + 1];
-        pos2[i] += pos2[i + 1];
-    }
-    for (i = 0; i < len; i++) {
-        t = (u32_t)iv[i];
-        ti[pos1[(t & 0xffff) + 1]++] = i;
-    }
-    for (i = 0; i < len; i++) {
-        t = (u32_t)iv[ti[i]] ^ 0x80000000;
-        ov[pos2[(t >> 16) + 1]++] = ti[i];
-    }
-
-    drop_obj(temp);
-    return indices;
-}
-
-obj_p ray_sort_desc_i64(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    i64_t* iv = AS_I64(vec);
-    i64_t* t = AS_I64(temp);
-
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-    u64_t pos3[65537] = {0};
-    u64_t pos4[65537] = {0};
-
-    // Count occurrences of each 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[i] ^ 0x8000000000000000ULL;  // invert bits for descending order
-        pos1[u & 0xffff]++;
-        pos2[(u >> 16) & 0xffff]++;
-        pos3[(u >> 32) & 0xffff]++;
-        pos4[u >> 48]++;
-    }
-    for (i = 65534; i >= 0; i--) {
-        pos1[i] += pos1[i + 1];
-        pos2[i] += pos2[i + 1];
-        pos3[i] += pos3[i + 1];
-        pos4[i] += pos4[i + 1];
-    }
-    // First pass: sort by least significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[i] ^ 0x8000000000000000ULL;
-        t[pos1[(u & 0xffff) + 1]++] = i;
-    }
-    // Second pass: sort by second 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[t[i]] ^ 0x8000000000000000ULL;
-        ov[pos2[((u >> 16) & 0xffff) + 1]++] = t[i];
-    }
-    // Third pass: sort by third 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[ov[i]] ^ 0x8000000000000000ULL;
-        t[pos3[((u >> 32) & 0xffff) + 1]++] = ov[i];
-    }
-    // Fourth pass: sort by most significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = iv[t[i]] ^ 0x8000000000000000ULL;
-        ov[pos4[(u >> 48) + 1]++] = t[i];
-    }
-
-    drop_obj(temp);
-    return indices;
-}
-
-obj_p ray_sort_desc_f64(obj_p vec) {
-    i64_t i, len = vec->len;
-    obj_p indices = I64(len);
-    obj_p temp = I64(len);
-    i64_t* ov = AS_I64(indices);
-    f64_t* fv = AS_F64(vec);
-    i64_t* t = AS_I64(temp);
-
-    u64_t pos1[65537] = {0};
-    u64_t pos2[65537] = {0};
-    u64_t pos3[65537] = {0};
-    u64_t pos4[65537] = {0};
-
-    // Count occurrences for each 16-bit chunk (descending)
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[i]);
-        pos1[u & 0xffff]++;
-        pos2[(u >> 16) & 0xffff]++;
-        pos3[(u >> 32) & 0xffff]++;
-        pos4[u >> 48]++;
-    }
-    for (i = 65534; i >= 0; i--) {
-        pos1[i] += pos1[i + 1];
-        pos2[i] += pos2[i + 1];
-        pos3[i] += pos3[i + 1];
-        pos4[i] += pos4[i + 1];
-    }
-    // First pass: sort by least significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[i]);
-        t[pos1[(u & 0xffff) + 1]++] = i;
-    }
-    // Second pass: sort by second 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[t[i]]);
-        ov[pos2[((u >> 16) & 0xffff) + 1]++] = t[i];
-    }
-    // Third pass: sort by third 16-bit chunk
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[ov[i]]);
-        t[pos3[((u >> 32) & 0xffff) + 1]++] = ov[i];
-    }
-    // Fourth pass: sort by most significant 16 bits
-    for (i = 0; i < len; i++) {
-        u64_t u = f64_to_sortable_u64(fv[t[i]]);
-        ov[pos4[(u >> 48) + 1]++] = t[i];
-    }
-
-    drop_obj(temp);
-    return indices;
-}
-
 obj_p ray_sort_desc(obj_p vec) {
     i64_t i, len = vec->len;
     obj_p indices;
@@ -637,19 +772,14 @@ obj_p ray_sort_desc(obj_p vec) {
         case TYPE_C8:
             return ray_sort_desc_u8(vec);
         case TYPE_I16:
-            return ray_sort_desc_i16(vec);
         case TYPE_I32:
         case TYPE_DATE:
         case TYPE_TIME:
-            return ray_sort_desc_i32(vec);
         case TYPE_I64:
         case TYPE_TIMESTAMP:
-            return ray_sort_desc_i64(vec);
         case TYPE_F64:
-            return ray_sort_desc_f64(vec);
         case TYPE_SYMBOL:
-            // Use optimized sorting
-            return ray_idesc_optimized(vec);
+            return sort_radix(vec, NULL_OBJ, -1);
         case TYPE_LIST:
             return mergesort_generic_obj(vec, -1);
         case TYPE_DICT:
@@ -659,194 +789,246 @@ obj_p ray_sort_desc(obj_p vec) {
     }
 }
 
-// Optimized sorting implementations
+obj_p sort_rows(obj_p vec, obj_p rows, i64_t asc) {
+    i64_t i, l;
+    obj_p col, idx, res;
+
+    switch (vec->type) {
+        case TYPE_B8:
+        case TYPE_U8:
+        case TYPE_C8:
+        case TYPE_I16:
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+        case TYPE_I64:
+        case TYPE_TIMESTAMP:
+        case TYPE_F64:
+        case TYPE_SYMBOL:
+            return sort_radix(vec, rows, asc);
+        default:
+            break;
+    }
+
+    if (rows == NULL_OBJ)
+        return (asc > 0) ? ray_sort_asc(vec) : ray_sort_desc(vec);
 
-// Fast binary insertion sort for small arrays with proper symbol comparison
-static void binary_insertion_sort_symbols(i64_t* indices, obj_p vec, i64_t len, i64_t asc) {
-    for (i64_t i = 1; i < len; i++) {
-        i64_t key_idx = indices[i];
+    col = at_obj(vec, rows);
+    if (IS_ERR(col))
+        return col;
 
-        // Binary search for insertion position
-        i64_t left = 0, right = i;
-        while (left < right) {
-            i64_t mid = (left + right) / 2;
-            i64_t cmp = compare_symbols(vec, key_idx, indices[mid]);
+    idx = (asc > 0) ? ray_sort_asc(col) : ray_sort_desc(col);
+    drop_obj(col);
+    if (IS_ERR(idx))
+        return idx;
 
-            if ((asc > 0 && cmp < 0) || (asc <= 0 && cmp > 0)) {
-                right = mid;
-            } else {
-                left = mid + 1;
-            }
-        }
+    l = idx->len;
+    res = I64(l);
+    for (i = 0; i < l; i++)
+        AS_I64(res)[i] = AS_I64(rows)[AS_I64(idx)[i]];
 
-        // Shift elements and insert
-        for (i64_t j = i; j > left; j--) {
-            indices[j] = indices[j - 1];
-        }
-        indices[left] = key_idx;
-    }
+    drop_obj(idx);
+
+    return res;
 }
 
-// Fast binary insertion sort for small arrays with numeric comparison
-static void binary_insertion_sort_numeric(i64_t* indices, i64_t* data, i64_t len, i64_t asc) {
-    for (i64_t i = 1; i < len; i++) {
-        i64_t key_idx = indices[i];
-        i64_t key_val = data[key_idx];
-
-        // Binary search for insertion position
-        i64_t left = 0, right = i;
-        while (left < right) {
-            i64_t mid = (left + right) / 2;
-            i64_t mid_val = data[indices[mid]];
-
-            if ((asc > 0 && key_val < mid_val) || (asc <= 0 && key_val > mid_val)) {
-                right = mid;
-            } else {
-                left = mid + 1;
-            }
+// The first (or last) rows of an order without sorting them all: every chunk keeps the k best rows it sees in a
+// heap, the heaps of the chunks are then narrowed down to k and sorted. Rows equal on all the columns keep their
+// order, so the result is the one a full sort would start (or end) with
+typedef struct __sort_top_ctx_t {
+    obj_p *vecs;     // columns, the most significant one first
+    i64_t n;
+    i64_t dir;       // 1 for ascending, -1 for descending columns
+    i64_t side;      // 1 to keep the first rows of the order, -1 for the last ones
+    i64_t k;
+    i64_t *heaps;    // per chunk, k rows each
+    i64_t *sizes;    // per chunk
+}* sort_top_ctx_p;
+
+#define SORT_TOP_MAX 16  // a top of more than one row in that many is left to a full sort
+
+static inline i64_t sort_top_cmp(sort_top_ctx_p ctx, i64_t i, i64_t j) {
+    i64_t c, r;
+    u64_t a, b;
+    obj_p v;
+
+    for (c = 0; c < ctx->n; c++) {
+        v = ctx->vecs[c];
+
+        switch (v->type) {
+            case TYPE_B8:
+            case TYPE_U8:
+            case TYPE_C8:
+                a = AS_U8(v)[i];
+                b = AS_U8(v)[j];
+                break;
+            case TYPE_I16:
+                a = (u16_t)AS_I16(v)[i] ^ 0x8000;
+                b = (u16_t)AS_I16(v)[j] ^ 0x8000;
+                break;
+            case TYPE_I32:
+            case TYPE_DATE:
+            case TYPE_TIME:
+                a = (u32_t)AS_I32(v)[i] ^ 0x80000000;
+                b = (u32_t)AS_I32(v)[j] ^ 0x80000000;
+                break;
+            case TYPE_F64:
+                a = f64_to_sortable_u64(AS_F64(v)[i]);
+                b = f64_to_sortable_u64(AS_F64(v)[j]);
+                break;
+            case TYPE_SYMBOL:
+                r = compare_symbols(v, i, j);
+                if (r != 0)
+                    return (r < 0) ? -ctx->dir : ctx->dir;
+                continue;
+            default:
+                a = (u64_t)AS_I64(v)[i] ^ 0x8000000000000000ull;
+                b = (u64_t)AS_I64(v)[j] ^ 0x8000000000000000ull;
+                break;
         }
 
-        // Shift elements and insert
-        for (i64_t j = i; j > left; j--) {
-            indices[j] = indices[j - 1];
-        }
-        indices[left] = key_idx;
+        if (a != b)
+            return (a < b) ? -ctx->dir : ctx->dir;
     }
-}
-
-// General counting sort for integer vectors when range is reasonable
-static obj_p counting_sort_i64(obj_p vec, i64_t asc) {
-    i64_t len = vec->len;
-    if (len == 0)
-        return I64(0);
 
-    i64_t* data = AS_I64(vec);
+    return (i < j) ? -1 : (i > j);
+}
 
-    // Find min/max symbol IDs
-    i64_t min_sym = data[0], max_sym = data[0];
-    for (i64_t i = 1; i < len; i++) {
-        if (data[i] < min_sym)
-            min_sym = data[i];
-        if (data[i] > max_sym)
-            max_sym = data[i];
-    }
+// Heap of rows with the worst one kept at the top, side turns a max heap into a min one
+static inline nil_t sort_top_sift(sort_top_ctx_p ctx, i64_t *heap, i64_t size, i64_t i) {
+    i64_t l, m, row;
 
-    i64_t range = max_sym - min_sym + 1;
+    row = heap[i];
 
-    // Use counting sort only if range is reasonable
-    // Don't use if too sparse (range > len) or exceeds maximum range
-    if (range > len || range > COUNTING_SORT_MAX_RANGE)
-        return NULL;  // Fall back to other sorting
+    for (;;) {
+        l = 2 * i + 1;
+        if (l >= size)
+            break;
 
-    // Allocate counting array
-    i64_t* counts = (i64_t*)heap_alloc(range * sizeof(i64_t));
-    if (!counts)
-        return NULL;
-    memset(counts, 0, range * sizeof(i64_t));
+        m = (l + 1 < size && ctx->side * sort_top_cmp(ctx, heap[l + 1], heap[l]) > 0) ? l + 1 : l;
+        if (ctx->side * sort_top_cmp(ctx, heap[m], row) <= 0)
+            break;
 
-    // Create buckets to store indices for each symbol
-    i64_t** buckets = (i64_t**)heap_alloc(range * sizeof(i64_t*));
-    if (!buckets) {
-        heap_free(counts);
-        return NULL;
+        heap[i] = heap[m];
+        i = m;
     }
 
-    // Count occurrences and allocate buckets
-    for (i64_t i = 0; i < len; i++)
-        counts[data[i] - min_sym]++;
+    heap[i] = row;
+}
 
-    // Allocate memory for each bucket
-    for (i64_t i = 0; i < range; i++)
-        buckets[i] = (counts[i] > 0) ? (i64_t*)heap_alloc(counts[i] * sizeof(i64_t)) : NULL;
+static i64_t sort_top_push(sort_top_ctx_p ctx, i64_t *heap, i64_t size, i64_t row) {
+    i64_t i, p;
 
-    // Reset counts to use as bucket indices
-    memset(counts, 0, range * sizeof(i64_t));
+    if (size == ctx->k) {
+        if (ctx->side * sort_top_cmp(ctx, row, heap[0]) < 0) {
+            heap[0] = row;
+            sort_top_sift(ctx, heap, size, 0);
+        }
 
-    // Fill buckets with indices
-    for (i64_t i = 0; i < len; i++) {
-        i64_t bucket_idx = data[i] - min_sym;
-        buckets[bucket_idx][counts[bucket_idx]++] = i;
+        return size;
     }
 
-    // Create result indices array
-    obj_p indices = I64(len);
-    i64_t* result = AS_I64(indices);
-    i64_t pos = 0;
-
-    if (asc > 0) {
-        // Ascending: iterate symbols from min to max
-        for (i64_t sym = 0; sym < range; sym++) {
-            i64_t count = counts[sym];
-            for (i64_t i = 0; i < count; i++) {
-                result[pos++] = buckets[sym][i];
-            }
-        }
-    } else {
-        // Descending: iterate symbols from max to min
-        for (i64_t sym = range - 1; sym >= 0; sym--) {
-            i64_t count = counts[sym];
-            for (i64_t i = 0; i < count; i++) {
-                result[pos++] = buckets[sym][i];
-            }
-        }
+    for (i = size; i > 0; i = p) {
+        p = (i - 1) / 2;
+        if (ctx->side * sort_top_cmp(ctx, heap[p], row) >= 0)
+            break;
+        heap[i] = heap[p];
     }
+    heap[i] = row;
 
-    // Cleanup buckets
-    for (i64_t i = 0; i < range; i++)
-        heap_free(buckets[i]);
-
-    heap_free(buckets);
-    heap_free(counts);
-    return indices;
+    return size + 1;
 }
 
-// Optimized sort dispatcher
-static obj_p optimized_sort(obj_p vec, i64_t asc) {
-    obj_p res;
-    i64_t len = vec->len;
+static obj_p sort_top_chunk(sort_top_ctx_p ctx, i64_t chunk, i64_t len, i64_t offset) {
+    i64_t i, l, size, *heap;
 
-    if (len <= 1)
-        return I64(len);
+    l = offset + len;
+    heap = ctx->heaps + chunk * ctx->k;
 
-    // Small arrays: use insertion sort
-    if (len <= 32) {
-        obj_p indices = I64(len);
-        i64_t* result = AS_I64(indices);
+    for (i = offset, size = 0; i < l; i++)
+        size = sort_top_push(ctx, heap, size, i);
 
-        // Initialize indices
-        for (i64_t i = 0; i < len; i++) {
-            result[i] = i;
-        }
+    ctx->sizes[chunk] = size;
 
-        switch (vec->type) {
-            case TYPE_I64:
+    return NULL_OBJ;
+}
+
+obj_p sort_top(obj_p *vecs, i64_t n, i64_t k, i64_t asc) {
+    i64_t c, i, len, size, chunks, *heap, *out;
+    obj_p heaps, sizes, res;
+    pool_p pool;
+    struct __sort_top_ctx_t ctx;
+
+    len = vecs[0]->len;
+
+    for (c = 0; c < n; c++) {
+        switch (vecs[c]->type) {
+            case TYPE_B8:
+            case TYPE_U8:
+            case TYPE_C8:
+            case TYPE_I16:
+            case TYPE_I32:
+            case TYPE_DATE:
             case TYPE_TIME:
-                binary_insertion_sort_numeric(result, AS_I64(vec), len, asc);
-                return indices;
+            case TYPE_I64:
+            case TYPE_TIMESTAMP:
+            case TYPE_F64:
             case TYPE_SYMBOL:
-                // For symbols, use proper symbol comparison
-                binary_insertion_sort_symbols(result, vec, len, asc);
-                return indices;
+                if (vecs[c]->len != len)
+                    return NULL_OBJ;
+                break;
+            default:
+                return NULL_OBJ;
         }
     }
 
-    // For larger arrays: try counting sort first for integer types
-    switch (vec->type) {
-        case TYPE_I64:
-        case TYPE_TIME:
-        case TYPE_SYMBOL:
-            res = counting_sort_i64(vec, asc);
-            if (res)
-                return res;
-            break;
-        default:
-            break;
+    ctx.vecs = vecs;
+    ctx.n = n;
+    ctx.dir = (asc > 0) ? 1 : -1;
+    ctx.side = (k < 0) ? -1 : 1;
+    ctx.k = (k < 0) ? -k : k;
+
+    if (ctx.k == 0 || ctx.k * SORT_TOP_MAX > len)
+        return NULL_OBJ;
+
+    pool = pool_get();
+    chunks = pool_split_by(pool, len, 0);
+
+    heaps = I64(chunks * ctx.k);
+    sizes = I64(chunks);
+    ctx.heaps = AS_I64(heaps);
+    ctx.sizes = AS_I64(sizes);
+
+    if (chunks == 1) {
+        sort_top_chunk(&ctx, 0, len, 0);
+    } else {
+        pool_prepare(pool);
+        for (c = 0; c < chunks - 1; c++)
+            pool_add_task(pool, (raw_p)sort_top_chunk, 4, &ctx, c, len / chunks, c * (len / chunks));
+        pool_add_task(pool, (raw_p)sort_top_chunk, 4, &ctx, c, len - c * (len / chunks), c * (len / chunks));
+        drop_obj(pool_run(pool));
+
+        // the first heap takes the best rows of the others
+        for (c = 1; c < chunks; c++) {
+            for (i = 0; i < ctx.sizes[c]; i++)
+                ctx.sizes[0] = sort_top_push(&ctx, ctx.heaps, ctx.sizes[0], ctx.heaps[c * ctx.k + i]);
+        }
     }
 
-    // Fall back to merge sort for larger arrays
-    return mergesort_generic_obj(vec, asc);
-}
+    // popping the worst row first fills the result from its far end
+    heap = ctx.heaps;
+    size = ctx.sizes[0];
+    res = I64(size);
+    out = AS_I64(res);
 
-// Optimized sorting functions
-static obj_p ray_iasc_optimized(obj_p x) { return optimized_sort(x, 1); }
-static obj_p ray_idesc_optimized(obj_p x) { return optimized_sort(x, -1); }
+    for (i = size; i > 0; i--) {
+        out[(ctx.side > 0) ? i - 1 : size - i] = heap[0];
+        heap[0] = heap[i - 1];
+        sort_top_sift(&ctx, heap, i - 1, 0);
+    }
+
+    drop_obj(heaps);
+    drop_obj(sizes);
+
+    return res;
+}
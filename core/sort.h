@@ -32,4 +32,10 @@ obj_p ray_sort_desc(obj_p vec);
 // Internal merge sort function
 obj_p mergesort_generic_obj(obj_p vec, i64_t asc);
 
+// Given rows of a vector (NULL_OBJ for all of them) in the order of their values, equal ones keep their order
+obj_p sort_rows(obj_p vec, obj_p rows, i64_t asc);
+
+// Rows of the first k (the last -k for a negative one) in the order of the columns, NULL_OBJ when a full sort suits
+obj_p sort_top(obj_p *vecs, i64_t n, i64_t k, i64_t asc);
+
 #endif  // SORT_H
@@ -24,6 +24,10 @@
 #include "string.h"
 #include "ops.h"
 #include "error.h"
+#include "util.h"
+#include "symbols.h"
+#include "runtime.h"
+#include "pool.h"
 
 #define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
 #define IS_SPACE(c) ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
@@ -373,8 +377,14 @@ b8_t str_match(str_p str, i64_t str_len, str_p pat, i64_t pat_len) {
     i64_t last_star_str_pos = 0;         // Track corresponding string position
 
     while (str_pos < str_len) {
-        if (pat_pos >= pat_len)
-            return B8_FALSE;
+        if (pat_pos >= pat_len) {
+            // Pattern used up before the string - retry the last '*' one character further
+            if (last_star_pat_pos == NULL_I64)
+                return B8_FALSE;
+            pat_pos = last_star_pat_pos + 1;
+            str_pos = ++last_star_str_pos;
+            continue;
+        }
 
         switch (pat[pat_pos]) {
             case '*':
@@ -457,6 +467,134 @@ b8_t str_match(str_p str, i64_t str_len, str_p pat, i64_t pat_len) {
     return (pat_pos == pat_len);
 }
 
+// Does a string contain a literal: candidates are found by memchr on the literal first character
+static b8_t str_contains(str_p str, i64_t str_len, str_p lit, i64_t len) {
+    i64_t i, last;
+    str_p p;
+
+    if (len == 0)
+        return B8_TRUE;
+
+    last = str_len - len;
+    for (i = 0; i <= last; i++) {
+        p = memchr(str + i, lit[0], last - i + 1);
+        if (p == NULL)
+            return B8_FALSE;
+        i = p - str;
+        if (memcmp(p + 1, lit + 1, len - 1) == 0)
+            return B8_TRUE;
+    }
+
+    return B8_FALSE;
+}
+
+/*
+ * Compiles a like pattern once for matching many strings. Patterns of a literal between optional stars compare
+ * the literal at the ends of a string or look it up; patterns without stars match a set of characters at every
+ * position, a string of a different length never matching them. The rest go through str_match.
+ */
+nil_t str_pat_compile(str_pat_t *p, str_p pat, i64_t pat_len) {
+    i64_t i, j, from, to, n;
+    b8_t inv;
+
+    p->kind = STR_PAT_GLOB;
+    p->pat = pat;
+    p->pat_len = pat_len;
+    p->lit = pat;
+    p->len = pat_len;
+
+    for (from = 0; from < pat_len && pat[from] == '*'; from++)
+        ;
+    for (to = pat_len; to > from && pat[to - 1] == '*'; to--)
+        ;
+
+    if (from == to) {
+        p->kind = (pat_len == 0) ? STR_PAT_EXACT : STR_PAT_ANY;
+        return;
+    }
+
+    for (i = from; i < to; i++) {
+        if (pat[i] == '*' || pat[i] == '?' || pat[i] == '[')
+            break;
+    }
+
+    if (i == to) {
+        p->lit = pat + from;
+        p->len = to - from;
+        if (from == 0)
+            p->kind = (to == pat_len) ? STR_PAT_EXACT : STR_PAT_PREFIX;
+        else
+            p->kind = (to == pat_len) ? STR_PAT_SUFFIX : STR_PAT_INFIX;
+        return;
+    }
+
+    if (from > 0 || to < pat_len)
+        return;
+
+    for (j = i; j < to; j++) {
+        if (pat[j] == '*')
+            return;
+    }
+
+    for (i = 0, n = 0; i < pat_len; i++, n++) {
+        if (n == STR_PAT_MAX_CLASSES)
+            return;
+
+        switch (pat[i]) {
+            case '?':
+                memset(p->cls[n], 0xff, sizeof(p->cls[n]));
+                break;
+            case '[':
+                inv = (i + 1 < pat_len && pat[i + 1] == '^');
+                memset(p->cls[n], 0, sizeof(p->cls[n]));
+                for (j = i + 1 + inv; j < pat_len && pat[j] != ']'; j++)
+                    p->cls[n][(u8_t)pat[j] >> 6] |= 1ull << ((u8_t)pat[j] & 63);
+                if (j == pat_len)
+                    return;  // unmatched '[' never matches, str_match tells
+                i = j;
+                if (inv) {
+                    for (j = 0; j < 4; j++)
+                        p->cls[n][j] = ~p->cls[n][j];
+                }
+                break;
+            default:
+                memset(p->cls[n], 0, sizeof(p->cls[n]));
+                p->cls[n][(u8_t)pat[i] >> 6] |= 1ull << ((u8_t)pat[i] & 63);
+                break;
+        }
+    }
+
+    p->kind = STR_PAT_CLASSES;
+    p->len = n;
+}
+
+b8_t str_pat_match(str_pat_t *p, str_p str, i64_t str_len) {
+    i64_t i;
+
+    switch (p->kind) {
+        case STR_PAT_ANY:
+            return B8_TRUE;
+        case STR_PAT_EXACT:
+            return str_len == p->len && memcmp(str, p->lit, p->len) == 0;
+        case STR_PAT_PREFIX:
+            return str_len >= p->len && memcmp(str, p->lit, p->len) == 0;
+        case STR_PAT_SUFFIX:
+            return str_len >= p->len && memcmp(str + str_len - p->len, p->lit, p->len) == 0;
+        case STR_PAT_INFIX:
+            return str_contains(str, str_len, p->lit, p->len);
+        case STR_PAT_CLASSES:
+            if (str_len != p->len)
+                return B8_FALSE;
+            for (i = 0; i < str_len; i++) {
+                if (!(p->cls[i][(u8_t)str[i] >> 6] & (1ull << ((u8_t)str[i] & 63))))
+                    return B8_FALSE;
+            }
+            return B8_TRUE;
+        default:
+            return str_match(str, str_len, p->pat, p->pat_len);
+    }
+}
+
 i64_t str_len(str_p s, i64_t n) {
     i64_t i;
     for (i = 0; i < n && s[i] != '\0'; ++i)
@@ -660,3 +798,171 @@ obj_p str_split(lit_p str, i64_t str_len, lit_p delim, i64_t delim_len) {
     push_obj(&result, last_part);
     return result;
 }
+
+/*
+ * String vectors keep the offsets of their strings followed by all their bytes: string i spans the bytes
+ * offs[i]..offs[i + 1] and offs[len] is the size of them all. Rows out of range read as empty strings.
+ */
+obj_p strings_from_list(obj_p x) {
+    i64_t i, l, size;
+    obj_p e, res;
+    i64_t *offs;
+    str_p data;
+
+    l = x->len;
+    for (i = 0, size = 0; i < l; i++) {
+        e = AS_LIST(x)[i];
+        if (e->type != TYPE_C8)
+            THROW(ERR_TYPE, "strings: expected a list of 'String, got: '%s at %lld", type_name(e->type), i);
+        size += e->len;
+    }
+
+    res = strings(l, size);
+    offs = STRINGS_OFFS(res);
+    data = STRINGS_DATA(res);
+
+    for (i = 0; i < l; i++) {
+        e = AS_LIST(x)[i];
+        memcpy(data + offs[i], AS_C8(e), e->len);
+        offs[i + 1] = offs[i] + e->len;
+    }
+
+    return res;
+}
+
+obj_p strings_from_symbols(obj_p x) {
+    i64_t i, l, n, size;
+    obj_p res;
+    i64_t *offs;
+    str_p data;
+
+    l = x->len;
+    for (i = 0, size = 0; i < l; i++)
+        size += SYMBOL_STRLEN(AS_SYMBOL(x)[i]);
+
+    res = strings(l, size);
+    offs = STRINGS_OFFS(res);
+    data = STRINGS_DATA(res);
+
+    for (i = 0; i < l; i++) {
+        n = SYMBOL_STRLEN(AS_SYMBOL(x)[i]);
+        memcpy(data + offs[i], str_from_symbol(AS_SYMBOL(x)[i]), n);
+        offs[i + 1] = offs[i] + n;
+    }
+
+    return res;
+}
+
+// Collects strings given as pairs of a pointer and a length
+obj_p strings_from_slices(i64_t slices[], i64_t len) {
+    i64_t i, size;
+    obj_p res;
+    i64_t *offs;
+    str_p data;
+
+    for (i = 0, size = 0; i < len; i++)
+        size += slices[2 * i + 1];
+
+    res = strings(len, size);
+    offs = STRINGS_OFFS(res);
+    data = STRINGS_DATA(res);
+
+    for (i = 0; i < len; i++) {
+        if (slices[2 * i + 1] > 0)
+            memcpy(data + offs[i], (str_p)slices[2 * i], slices[2 * i + 1]);
+        offs[i + 1] = offs[i] + slices[2 * i + 1];
+    }
+
+    return res;
+}
+
+obj_p strings_to_list(obj_p x) {
+    i64_t i, l;
+    obj_p res;
+    i64_t *offs;
+    str_p data;
+
+    l = x->len;
+    offs = STRINGS_OFFS(x);
+    data = STRINGS_DATA(x);
+    res = LIST(l);
+
+    for (i = 0; i < l; i++)
+        AS_LIST(res)[i] = string_from_str(data + offs[i], offs[i + 1] - offs[i]);
+
+    return res;
+}
+
+obj_p strings_to_symbols(obj_p x) {
+    i64_t i, l;
+    obj_p res;
+    i64_t *offs;
+    str_p data;
+
+    l = x->len;
+    offs = STRINGS_OFFS(x);
+    data = STRINGS_DATA(x);
+    res = SYMBOL(l);
+
+    for (i = 0; i < l; i++)
+        AS_SYMBOL(res)[i] = symbols_intern(data + offs[i], offs[i + 1] - offs[i]);
+
+    return res;
+}
+
+static obj_p strings_at_ids_partial(obj_p x, i64_t ids[], i64_t len, i64_t offset, obj_p out) {
+    i64_t i, n, *xo, *oo;
+    str_p xd, od;
+
+    xo = STRINGS_OFFS(x);
+    xd = STRINGS_DATA(x);
+    oo = STRINGS_OFFS(out);
+    od = STRINGS_DATA(out);
+
+    for (i = offset; i < offset + len; i++) {
+        n = oo[i + 1] - oo[i];
+        if (n > 0)
+            memcpy(od + oo[i], xd + xo[ids[i]], n);
+    }
+
+    return NULL_OBJ;
+}
+
+obj_p strings_at_ids(obj_p x, i64_t ids[], i64_t len) {
+    i64_t i, n, chunk, size, *xo;
+    obj_p res;
+    pool_p pool;
+
+    xo = STRINGS_OFFS(x);
+    for (i = 0, size = 0; i < len; i++) {
+        if ((u64_t)ids[i] < (u64_t)x->len)
+            size += xo[ids[i] + 1] - xo[ids[i]];
+    }
+
+    res = strings(len, size);
+
+    // offsets first, then the bytes of every row are copied to their place independently
+    for (i = 0, size = 0; i < len; i++) {
+        STRINGS_OFFS(res)[i] = size;
+        if ((u64_t)ids[i] < (u64_t)x->len)
+            size += xo[ids[i] + 1] - xo[ids[i]];
+    }
+
+    pool = runtime_get()->pool;
+    n = pool_split_by(pool, len, 0);
+
+    if (n == 1) {
+        strings_at_ids_partial(x, ids, len, 0, res);
+        return res;
+    }
+
+    chunk = len / n;
+
+    pool_prepare(pool);
+    for (i = 0; i < n - 1; i++)
+        pool_add_task(pool, (raw_p)strings_at_ids_partial, 5, x, ids, chunk, i * chunk, res);
+    pool_add_task(pool, (raw_p)strings_at_ids_partial, 5, x, ids, len - i * chunk, i * chunk, res);
+    drop_obj(pool_run(pool));
+
+    return res;
+}
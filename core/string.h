@@ -28,10 +28,34 @@
 #include <stdarg.h>
 #include "rayforce.h"
 
+// Shapes of like patterns matched without the backtracking of str_match
+typedef enum str_pat_kind_t {
+    STR_PAT_GLOB = 0,  // anything else, left to str_match
+    STR_PAT_ANY,       // stars only
+    STR_PAT_EXACT,     // literal
+    STR_PAT_PREFIX,    // literal*
+    STR_PAT_SUFFIX,    // *literal
+    STR_PAT_INFIX,     // *literal*
+    STR_PAT_CLASSES,   // no stars: a set of characters per position, out of literals, ? and [...]
+} str_pat_kind_t;
+
+#define STR_PAT_MAX_CLASSES 64
+
+typedef struct str_pat_t {
+    str_pat_kind_t kind;
+    str_p pat;  // the whole pattern
+    i64_t pat_len;
+    str_p lit;  // the literal of the pattern, or the count of its classes
+    i64_t len;
+    u64_t cls[STR_PAT_MAX_CLASSES][4];
+} str_pat_t;
+
 str_p str_chk_from_end(str_p pat);
 b8_t str_starts_with(str_p str, str_p pat);
 b8_t str_ends_with(str_p str, str_p pat);
 b8_t str_match(str_p str, i64_t str_len, str_p pat, i64_t pat_len);
+nil_t str_pat_compile(str_pat_t *p, str_p pat, i64_t pat_len);
+b8_t str_pat_match(str_pat_t *p, str_p str, i64_t str_len);
 obj_p string_from_str(lit_p str, i64_t len);
 obj_p cstring_from_str(lit_p str, i64_t len);
 obj_p cstring_from_obj(obj_p obj);
@@ -48,4 +72,12 @@ u64_t str_hash(lit_p str, i64_t len);
 obj_p vn_vc8(lit_p fmt, va_list args);
 obj_p str_split(lit_p str, i64_t str_len, lit_p delim, i64_t delim_len);
 
+// String vectors
+obj_p strings_from_list(obj_p x);
+obj_p strings_from_symbols(obj_p x);
+obj_p strings_from_slices(i64_t slices[], i64_t len);
+obj_p strings_to_list(obj_p x);
+obj_p strings_to_symbols(obj_p x);
+obj_p strings_at_ids(obj_p x, i64_t ids[], i64_t len);
+
 #endif  // STRING_H
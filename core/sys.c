@@ -28,6 +28,8 @@
 #include "runtime.h"
 #include "error.h"
 #include "ipc.h"
+#include "compress.h"
+#include "fuse.h"
 
 #if defined(OS_WINDOWS)
 #include <windows.h>
@@ -139,6 +141,8 @@ command_entry_t commands[] = {
     COMMAND("set-fpr", sys_set_fpr),
     COMMAND("set-display-width", sys_set_display_width),
     COMMAND("timeit", sys_timeit),
+    COMMAND("compress-columns", sys_compress_columns),
+    COMMAND("fuse", sys_fuse),
     COMMAND("listen", sys_listen),
     COMMAND("exit", sys_exit),
 };
@@ -212,6 +216,36 @@ obj_p sys_timeit(i32_t argc, str_p argv[]) {
     return i64(res);
 }
 
+obj_p sys_compress_columns(i32_t argc, str_p argv[]) {
+    i64_t res;
+
+    if (argc != 1)
+        THROW(ERR_LENGTH, "compress-columns: expected 1 argument");
+
+    i64_from_str(argv[0], strlen(argv[0]), &res);
+    if (res < 0)
+        THROW(ERR_LENGTH, "compress-columns: expected a positive integer");
+
+    compress_set_columns(res);
+
+    return i64(res);
+}
+
+obj_p sys_fuse(i32_t argc, str_p argv[]) {
+    i64_t res;
+
+    if (argc != 1)
+        THROW(ERR_LENGTH, "fuse: expected 1 argument");
+
+    i64_from_str(argv[0], strlen(argv[0]), &res);
+    if (res < 0)
+        THROW(ERR_LENGTH, "fuse: expected a positive integer");
+
+    fuse_set_enabled(res);
+
+    return i64(res);
+}
+
 obj_p sys_listen(i32_t argc, str_p argv[]) {
     UNUSED(argc);
     UNUSED(argv);
@@ -43,6 +43,8 @@ obj_p sys_set_fpr(i32_t argc, str_p argv[]);
 obj_p sys_use_unicode(i32_t argc, str_p argv[]);
 obj_p sys_set_display_width(i32_t argc, str_p argv[]);
 obj_p sys_timeit(i32_t argc, str_p argv[]);
+obj_p sys_compress_columns(i32_t argc, str_p argv[]);
+obj_p sys_fuse(i32_t argc, str_p argv[]);
 obj_p sys_listen(i32_t argc, str_p argv[]);
 obj_p sys_exit(i32_t argc, str_p argv[]);
 obj_p ray_internal_command(obj_p cmd);
@@ -94,6 +94,8 @@ ray_thread_t thread_self() {
     return t;
 }
 
+nil_t thread_yield() { SwitchToThread(); }
+
 i32_t thread_pin(ray_thread_t thread, i64_t core) {
     DWORD_PTR mask = 1ULL << core;
     if (SetThreadAffinityMask(thread.handle, mask) == 0) {
@@ -170,6 +172,8 @@ ray_thread_t thread_self() {
     return t;
 }
 
+nil_t thread_yield() { sched_yield(); }
+
 #if defined(OS_LINUX)
 
 i32_t thread_pin(ray_thread_t thread, i64_t core) {
@@ -76,6 +76,7 @@ i32_t thread_join(ray_thread_t thread);
 i32_t thread_detach(ray_thread_t thread);
 nil_t thread_exit(raw_p res);
 ray_thread_t thread_self();
+nil_t thread_yield();
 i32_t thread_pin(ray_thread_t thread, i64_t core);
 
 #endif  // THREAD_H
@@ -34,6 +34,7 @@
 #include "string.h"
 #include "fdmap.h"
 #include "iter.h"
+#include "compress.h"
 
 obj_p unary_call(obj_p f, obj_p x) {
     unary_f fn;
@@ -83,7 +84,11 @@ obj_p ray_get(obj_p x) {
 
             if (IS_EXTERNAL_SERIALIZED(res)) {
                 sz = size - ISIZEOF(struct obj_t);
-                v = de_raw((u8_t *)res + ISIZEOF(struct obj_t), &sz);
+                // a file saved over a longer one keeps its tail, the header tells where the frame ends
+                if (((ipc_header_t *)res)->flags & SERDE_FLAG_COMPRESSED)
+                    v = decompress_obj((u8_t *)res + ISIZEOF(struct obj_t), MINI64(((ipc_header_t *)res)->size, sz));
+                else
+                    v = de_raw((u8_t *)res + ISIZEOF(struct obj_t), &sz);
                 mmap_free(res, size);
                 fs_fclose(fd);
                 drop_obj(path);
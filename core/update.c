@@ -35,6 +35,7 @@
 #include "query.h"
 #include "aggr.h"
 #include "compose.h"
+#include "grouped.h"
 
 #define UNCOW_OBJ(o, v, r)            \
     {                                 \
@@ -284,8 +285,8 @@ obj_p ray_modify(obj_p *x, i64_t n) {
  * inserts for tables
  */
 obj_p ray_insert(obj_p *x, i64_t n) {
-    i64_t i, m, l;
-    obj_p lst, col, *val = NULL, obj, res;
+    i64_t i, m, l, from;
+    obj_p lst, col, g, *val = NULL, obj, res;
     b8_t need_drop;
 
     if (n != 2)
@@ -325,12 +326,16 @@ insert:
 
                 // Insert the record now
                 for (i = 0; i < l; i++) {
+                    g = grouped_take(AS_LIST(AS_LIST(obj)[1])[i]);
+                    from = ops_count(AS_LIST(AS_LIST(obj)[1])[i]);
                     col = cow_obj(AS_LIST(AS_LIST(obj)[1])[i]);
                     need_drop = (col != AS_LIST(AS_LIST(obj)[1])[i]);
                     push_obj(&col, clone_obj(AS_LIST(lst)[i]));
                     if (need_drop)
                         drop_obj(AS_LIST(AS_LIST(obj)[1])[i]);
                     AS_LIST(AS_LIST(obj)[1])[i] = col;
+                    if (g != NULL_OBJ)
+                        grouped_extend(col, g, from);
                 }
             } else {
                 // There are multiple records to be inserted
@@ -356,8 +361,10 @@ insert:
                     }
                 }
 
-                // Insert all the records now
+                // Insert all the records now, group indexes are extended with the new rows only
                 for (i = 0; i < l; i++) {
+                    g = grouped_take(AS_LIST(AS_LIST(obj)[1])[i]);
+                    from = ops_count(AS_LIST(AS_LIST(obj)[1])[i]);
                     col = cow_obj(AS_LIST(AS_LIST(obj)[1])[i]);
                     need_drop = (col != AS_LIST(AS_LIST(obj)[1])[i]);
                     append_list(&col, AS_LIST(lst)[i]);
@@ -365,6 +372,8 @@ insert:
                         drop_obj(AS_LIST(AS_LIST(obj)[1])[i]);
 
                     AS_LIST(AS_LIST(obj)[1])[i] = col;
+                    if (g != NULL_OBJ)
+                        grouped_extend(col, g, from);
                 }
             }
 
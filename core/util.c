@@ -125,6 +125,7 @@ b8_t is_valid(obj_p obj) {
            || obj->type == TYPE_LAMBDA          || obj->type == TYPE_UNARY 
            || obj->type == TYPE_BINARY          || obj->type == TYPE_VARY   
            || obj->type == TYPE_ENUM            || obj->type == TYPE_MAPLIST       
+           || obj->type == TYPE_STRINGS
            || obj->type == TYPE_MAPFILTER       || obj->type == TYPE_MAPGROUP
            || obj->type == TYPE_MAPFD           || (obj->type >= TYPE_PARTEDB8 && obj->type <= TYPE_PARTEDGUID)
            || obj->type == TYPE_LIST            
@@ -110,6 +110,9 @@ nil_t dump_stack(nil_t);
 #define MAPLIST_KEY(x) (((obj_p)((str_p)x - RAY_PAGE_SIZE))->obj)
 #define MAPLIST_VAL(x) (x)
 
+#define STRINGS_OFFS(x) AS_I64(x)
+#define STRINGS_DATA(x) (AS_C8(x) + ((x)->len + 1) * ISIZEOF(i64_t))
+
 #define __TYPE_u8 TYPE_U8
 #define __TYPE_b8 TYPE_B8
 #define __TYPE_c8 TYPE_C8
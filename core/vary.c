@@ -184,17 +184,24 @@ obj_p ray_set_parted(obj_p *x, i64_t n) {
 
 obj_p ray_get_parted(obj_p *x, i64_t n) {
     i8_t type;
+    b8_t eager;
     i64_t i, j, l, wide;
     obj_p path, dir, sym, dirs, gcol, ord, t1, t2, eq, fmaps, virtcol, v, keys, vals, res;
 
     switch (n) {
         case 2:
+        case 3:
             if (x[0]->type != TYPE_C8)
                 THROW(ERR_TYPE, "get parted: expected string as 1st argument, got %s", type_name(x[0]->type));
 
             if (x[1]->type != -TYPE_SYMBOL)
                 THROW(ERR_TYPE, "get parted: expected symbol as 2nd argument, got %s", type_name(x[1]->type));
 
+            if (n == 3 && x[2]->type != -TYPE_B8)
+                THROW(ERR_TYPE, "get parted: expected b8 as 3rd argument, got %s", type_name(x[2]->type));
+
+            eager = (n == 3) ? x[2]->b8 : B8_FALSE;
+
             // Try to get symfile
             res = io_get_symfile(x[0]);
             if (IS_ERR(res))
@@ -365,6 +372,14 @@ obj_p ray_get_parted(obj_p *x, i64_t n) {
                 AS_I64(AS_LIST(virtcol)[1])[i] = n;
             }
 
+            // Columns are mapped lazily, eager loading faults every partition in upfront
+            if (eager) {
+                for (i = 0; i < wide; i++) {
+                    for (j = 0; j < gcol->len; j++)
+                        io_advise(AS_LIST(AS_LIST(fmaps)[i])[j], MMAP_ADVICE_POPULATE);
+                }
+            }
+
             AS_LIST(vals)[0] = virtcol;
             for (i = 0; i < wide; i++) {
                 AS_LIST(vals)[i + 1] = clone_obj(AS_LIST(fmaps)[i]);
@@ -387,6 +402,6 @@ obj_p ray_get_parted(obj_p *x, i64_t n) {
             return table(keys, vals);
 
         default:
-            THROW(ERR_LENGTH, "get parted: expected 2 arguments, got %lld", n);
+            THROW(ERR_LENGTH, "get parted: expected 2 or 3 arguments, got %lld", n);
     }
 }
\ No newline at end of file
@@ -0,0 +1,558 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+
+#include "vm.h"
+#include "eval.h"
+#include "runtime.h"
+#include "unary.h"
+#include "binary.h"
+#include "vary.h"
+#include "items.h"
+#include "cond.h"
+#include "error.h"
+#include "filter.h"
+#include "aggr.h"
+#include "ops.h"
+#include "fuse.h"
+
+/*
+ * Lambdas are compiled once, when they are created, into instructions over registers living on the interpreter
+ * stack right above the frame of the call (arguments, then the local environment). Arguments are read from their
+ * slots instead of being looked up by name, globals remember where they were found last, and builtins known at
+ * parse time are called directly. `if` and `do` are compiled, other special forms and anything the compiler does
+ * not know are handed to the tree walker node by node, so the semantics stay those of eval.
+ *
+ * Names bound with `let` anywhere in the body are always looked up through resolve, since they may shadow
+ * arguments and globals once bound.
+ */
+
+// Compiled code: register count, instructions, constants, and the spans of `if` forms adding their location to
+// errors raised within them
+#define VM_CODE_REGS 0
+#define VM_CODE_INS 1
+#define VM_CODE_CONSTS 2
+#define VM_CODE_SPANS 3
+
+typedef struct vm_compiler_t {
+    obj_p args;    // names of the arguments
+    obj_p lets;    // names bound with let in the body
+    obj_p ins;     // instructions
+    obj_p consts;  // constants
+    obj_p spans;   // start, end and node of every compiled `if`
+    i64_t regs;    // registers used so far
+} vm_compiler_t;
+
+static nil_t vm_compile_expr(vm_compiler_t *c, obj_p node, i64_t dst);
+
+// ============================================================================
+// Compiler
+// ============================================================================
+
+static nil_t vm_find_lets(obj_p node, obj_p *lets) {
+    i64_t i, l;
+    obj_p *items;
+
+    switch (node->type) {
+        case TYPE_LIST:
+            l = node->len;
+            items = AS_LIST(node);
+
+            if (l == 3 && items[0]->type == TYPE_BINARY && items[0]->i64 == (i64_t)ray_let &&
+                items[1]->type == -TYPE_SYMBOL)
+                push_raw(lets, &items[1]->i64);
+
+            for (i = 0; i < l; i++)
+                vm_find_lets(items[i], lets);
+
+            return;
+        case TYPE_DICT:
+        case TYPE_TABLE:
+            vm_find_lets(AS_LIST(node)[1], lets);
+            return;
+        default:
+            return;
+    }
+}
+
+static i64_t vm_emit(vm_compiler_t *c, i64_t op, i64_t a, i64_t b, i64_t d, i64_t e, i64_t f) {
+    i64_t i, pc, w[VM_WIDTH] = {op, a, b, d, e, f};
+
+    pc = c->ins->len / VM_WIDTH;
+    for (i = 0; i < VM_WIDTH; i++)
+        push_raw(&c->ins, &w[i]);
+
+    return pc;
+}
+
+static nil_t vm_patch(vm_compiler_t *c, i64_t pc, i64_t operand, i64_t val) {
+    AS_I64(c->ins)[pc * VM_WIDTH + operand] = val;
+}
+
+static i64_t vm_pc(vm_compiler_t *c) { return c->ins->len / VM_WIDTH; }
+
+static nil_t vm_reserve(vm_compiler_t *c, i64_t r) {
+    if (r + 1 > c->regs)
+        c->regs = r + 1;
+}
+
+static nil_t vm_compile_const(vm_compiler_t *c, obj_p val, i64_t dst) {
+    vm_emit(c, VM_CONST, dst, c->consts->len, 0, 0, 0);
+    push_obj(&c->consts, val);
+}
+
+static nil_t vm_compile_symbol(vm_compiler_t *c, i64_t sym, i64_t dst, obj_p node) {
+    i64_t i;
+
+    if (sym == SYMBOL_SELF || find_raw(c->lets, &sym) != NULL_I64) {
+        vm_emit(c, VM_RESOLVE, dst, sym, (i64_t)node, 0, 0);
+        return;
+    }
+
+    i = find_raw(c->args, &sym);
+    if (i != NULL_I64)
+        vm_emit(c, VM_ARG, dst, i, 0, 0, 0);
+    else
+        vm_emit(c, VM_GLOBAL, dst, sym, (i64_t)node, -1, -1);
+}
+
+static nil_t vm_compile_args(vm_compiler_t *c, obj_p *args, i64_t n, i64_t dst) {
+    i64_t i;
+
+    for (i = 0; i < n; i++)
+        vm_compile_expr(c, args[i], dst + i);
+}
+
+static nil_t vm_compile_if(vm_compiler_t *c, obj_p node, obj_p *args, i64_t n, i64_t dst) {
+    i64_t start, jf, j, end;
+
+    start = vm_pc(c);
+
+    vm_compile_expr(c, args[0], dst);
+    jf = vm_emit(c, VM_JMPF, dst, 0, 0, 0, 0);
+    vm_compile_expr(c, args[1], dst);
+    j = vm_emit(c, VM_JMP, 0, 0, 0, 0, 0);
+    vm_patch(c, jf, 2, vm_pc(c));
+
+    if (n == 3)
+        vm_compile_expr(c, args[2], dst);
+    else
+        vm_compile_const(c, NULL_OBJ, dst);
+
+    end = vm_pc(c);
+    vm_patch(c, j, 1, end);
+
+    push_raw(&c->spans, &start);
+    push_raw(&c->spans, &end);
+    push_raw(&c->spans, &node);
+}
+
+static nil_t vm_compile_call(vm_compiler_t *c, obj_p node, i64_t dst) {
+    i64_t i, n, prep;
+    obj_p car, *args;
+
+    car = AS_LIST(node)[0];
+    args = AS_LIST(node) + 1;
+    n = node->len - 1;
+
+    switch (car->type) {
+        case TYPE_UNARY:
+            if ((car->attrs & FN_SPECIAL_FORM) || n != 1)
+                break;
+
+            vm_compile_args(c, args, n, dst);
+            vm_emit(c, VM_UNARY, dst, (i64_t)car, dst, (i64_t)node, 0);
+            return;
+
+        case TYPE_BINARY:
+            // take of a sort is planned on the unevaluated arguments, as are fused operators
+            if ((car->attrs & FN_SPECIAL_FORM) || n != 2 || car->i64 == (i64_t)ray_take || fuse_tree(node))
+                break;
+
+            vm_compile_args(c, args, n, dst);
+            vm_emit(c, VM_BINARY, dst, (i64_t)car, dst, (i64_t)node, 0);
+            return;
+
+        case TYPE_VARY:
+            if (car->i64 == (i64_t)ray_cond && (n == 2 || n == 3)) {
+                vm_compile_if(c, node, args, n, dst);
+                return;
+            }
+
+            if (car->i64 == (i64_t)ray_do && n > 0) {
+                for (i = 0; i < n; i++) {
+                    vm_compile_expr(c, args[i], dst);
+                    if (i < n - 1)
+                        vm_emit(c, VM_DROP, dst, 0, 0, 0, 0);
+                }
+                return;
+            }
+
+            if (car->attrs & FN_SPECIAL_FORM)
+                break;
+
+            vm_compile_args(c, args, n, dst);
+            vm_emit(c, VM_VARY, dst, (i64_t)car, dst, n, (i64_t)node);
+            return;
+
+        case TYPE_LAMBDA:
+            if (n != AS_LAMBDA(car)->args->len)
+                break;
+
+            vm_compile_const(c, clone_obj(car), dst);
+            vm_compile_args(c, args, n, dst + 1);
+            vm_emit(c, VM_CALL, dst, dst, n, (i64_t)node, 0);
+            return;
+
+        case -TYPE_SYMBOL:
+            // what the name holds is only known at run time, special forms among others
+            vm_compile_symbol(c, car->i64, dst, node);
+            prep = vm_emit(c, VM_PREP, dst, dst, n, (i64_t)node, 0);
+            vm_compile_args(c, args, n, dst + 1);
+            vm_emit(c, VM_CALL, dst, dst, n, (i64_t)node, 0);
+            vm_patch(c, prep, 5, vm_pc(c));
+            return;
+
+        default:
+            break;
+    }
+
+    vm_emit(c, VM_EVAL, dst, (i64_t)node, 0, 0, 0);
+}
+
+static nil_t vm_compile_expr(vm_compiler_t *c, obj_p node, i64_t dst) {
+    vm_reserve(c, dst);
+
+    switch (node->type) {
+        case -TYPE_SYMBOL:
+            if (node->attrs & ATTR_QUOTED)
+                vm_compile_const(c, symboli64(node->i64), dst);
+            else
+                vm_compile_symbol(c, node->i64, dst, node);
+            return;
+        case TYPE_LIST:
+            if (node->len == 0)
+                vm_compile_const(c, NULL_OBJ, dst);
+            else
+                vm_compile_call(c, node, dst);
+            return;
+        default:
+            vm_compile_const(c, clone_obj(node), dst);
+            return;
+    }
+}
+
+/*
+ * Compile the body of a lambda taking args.
+ */
+obj_p vm_compile(obj_p args, obj_p body) {
+    vm_compiler_t c;
+
+    c.args = args;
+    c.lets = SYMBOL(0);
+    c.ins = I64(0);
+    c.consts = LIST(0);
+    c.spans = I64(0);
+    c.regs = 0;
+
+    vm_find_lets(body, &c.lets);
+    vm_compile_expr(&c, body, 0);
+    vm_emit(&c, VM_RET, 0, 0, 0, 0, 0);
+
+    drop_obj(c.lets);
+
+    return vn_list(4, i64(c.regs), c.ins, c.consts, c.spans);
+}
+
+// ============================================================================
+// Execution
+// ============================================================================
+
+// Collect a mapped group or filter into the values a plain function expects
+static inline nil_t vm_collect(obj_p fn, obj_p *x) {
+    obj_p y;
+
+    if (!(fn->attrs & FN_AGGR) && (*x)->type == TYPE_MAPGROUP) {
+        y = aggr_collect(AS_LIST(*x)[0], AS_LIST(*x)[1]);
+        drop_obj(*x);
+        *x = y;
+    } else if ((*x)->type == TYPE_MAPFILTER) {
+        y = filter_collect(AS_LIST(*x)[0], AS_LIST(*x)[1]);
+        drop_obj(*x);
+        *x = y;
+    }
+}
+
+// Whether a call of f with n arguments may go without the tree walker
+static inline b8_t vm_plain(obj_p f, i64_t n) {
+    switch (f->type) {
+        case TYPE_UNARY:
+            return !(f->attrs & FN_SPECIAL_FORM) && n == 1;
+        case TYPE_BINARY:
+            return !(f->attrs & FN_SPECIAL_FORM) && n == 2 && f->i64 != (i64_t)ray_take;
+        case TYPE_VARY:
+            return !(f->attrs & FN_SPECIAL_FORM);
+        case TYPE_LAMBDA:
+            return AS_LAMBDA(f)->args->len == n;
+        default:
+            return B8_FALSE;
+    }
+}
+
+/*
+ * Run compiled code within the context of the lambda it belongs to, the frame of the call being on the stack.
+ */
+__attribute__((hot)) obj_p vm_exec(obj_p code) {
+    i64_t i, j, l, n, pc, bp, rb, regs, *ins, *op, *spans;
+    obj_p f, res, *r, *consts;
+    env_t *env;
+    ctx_p ctx;
+
+    regs = AS_LIST(code)[VM_CODE_REGS]->i64;
+    ins = AS_I64(AS_LIST(code)[VM_CODE_INS]);
+    consts = AS_LIST(AS_LIST(code)[VM_CODE_CONSTS]);
+
+    if (!stack_enough(regs))
+        return error_str(ERR_STACK_OVERFLOW, "stack overflow");
+
+    ctx = ctx_get();
+    bp = ctx->sp;
+    rb = __INTERPRETER->sp;
+
+    for (i = 0; i < regs; i++)
+        stack_push(NULL_OBJ);
+
+    r = &__INTERPRETER->stack[rb];
+    pc = 0;
+
+    for (;;) {
+        op = ins + pc * VM_WIDTH;
+
+        switch (op[0]) {
+            case VM_CONST:
+                r[op[1]] = clone_obj(consts[op[2]]);
+                pc++;
+                continue;
+
+            case VM_ARG:
+                r[op[1]] = clone_obj(__INTERPRETER->stack[bp + op[2]]);
+                pc++;
+                continue;
+
+            case VM_GLOBAL:
+                // the slot cached along with the instruction holds while the environment keeps its layout
+                env = &runtime_get()->env;
+                if (__atomic_load_n(&op[5], __ATOMIC_ACQUIRE) != env->version) {
+                    j = env_find(env, op[2]);
+                    if (j == NULL_I64) {
+                        r[op[1]] = unwrap(error(ERR_EVAL, "undefined symbol: '%s", str_from_symbol(op[2])), op[3]);
+                        break;
+                    }
+
+                    op[4] = j;
+                    __atomic_store_n(&op[5], env->version, __ATOMIC_RELEASE);
+                }
+
+                r[op[1]] = clone_obj(AS_LIST(AS_LIST(env->variables)[1])[op[4]]);
+                pc++;
+                continue;
+
+            case VM_RESOLVE: {
+                obj_p *val = resolve(op[2]);
+
+                if (val == NULL) {
+                    r[op[1]] = unwrap(error(ERR_EVAL, "undefined symbol: '%s", str_from_symbol(op[2])), op[3]);
+                    break;
+                }
+
+                r[op[1]] = clone_obj(*val);
+                pc++;
+                continue;
+            }
+
+            case VM_UNARY:
+                f = (obj_p)op[2];
+                vm_collect(f, &r[op[3]]);
+                res = unary_call(f, r[op[3]]);
+                drop_obj(r[op[3]]);
+                r[op[3]] = NULL_OBJ;
+                r[op[1]] = unwrap(res, op[4]);
+                if (IS_ERR(res))
+                    break;
+                pc++;
+                continue;
+
+            case VM_BINARY:
+                f = (obj_p)op[2];
+                vm_collect(f, &r[op[3]]);
+                vm_collect(f, &r[op[3] + 1]);
+                res = binary_call(f, r[op[3]], r[op[3] + 1]);
+                drop_obj(r[op[3]]);
+                drop_obj(r[op[3] + 1]);
+                r[op[3]] = NULL_OBJ;
+                r[op[3] + 1] = NULL_OBJ;
+                r[op[1]] = unwrap(res, op[4]);
+                if (IS_ERR(res))
+                    break;
+                pc++;
+                continue;
+
+            case VM_VARY:
+                f = (obj_p)op[2];
+                n = op[4];
+                for (i = 0; i < n; i++)
+                    vm_collect(f, &r[op[3] + i]);
+                res = vary_call(f, &r[op[3]], n);
+                for (i = 0; i < n; i++) {
+                    drop_obj(r[op[3] + i]);
+                    r[op[3] + i] = NULL_OBJ;
+                }
+                r[op[1]] = unwrap(res, op[5]);
+                if (IS_ERR(res))
+                    break;
+                pc++;
+                continue;
+
+            case VM_PREP:
+                if (vm_plain(r[op[2]], op[3])) {
+                    pc++;
+                    continue;
+                }
+
+                drop_obj(r[op[2]]);
+                r[op[2]] = NULL_OBJ;
+                r[op[1]] = eval((obj_p)op[4]);
+                if (IS_ERR(r[op[1]]))
+                    break;
+                pc = op[5];
+                continue;
+
+            case VM_CALL:
+                f = r[op[2]];
+                n = op[3];
+
+                switch (f->type) {
+                    case TYPE_LAMBDA:
+                        if (!stack_enough(n)) {
+                            res = error_str(ERR_STACK_OVERFLOW, "stack overflow");
+                            break;
+                        }
+
+                        // arguments move to the top of the stack, where the callee frame starts
+                        j = __INTERPRETER->sp;
+                        for (i = 1; i <= n; i++) {
+                            stack_push(r[op[2] + i]);
+                            r[op[2] + i] = NULL_OBJ;
+                        }
+
+                        res = lambda_call(f, stack_peek(n - 1), n);
+
+                        while (__INTERPRETER->sp > j)
+                            drop_obj(stack_pop());
+                        break;
+                    case TYPE_UNARY:
+                        vm_collect(f, &r[op[2] + 1]);
+                        res = unary_call(f, r[op[2] + 1]);
+                        break;
+                    case TYPE_BINARY:
+                        vm_collect(f, &r[op[2] + 1]);
+                        vm_collect(f, &r[op[2] + 2]);
+                        res = binary_call(f, r[op[2] + 1], r[op[2] + 2]);
+                        break;
+                    default:
+                        for (i = 1; i <= n; i++)
+                            vm_collect(f, &r[op[2] + i]);
+                        res = vary_call(f, &r[op[2] + 1], n);
+                        break;
+                }
+
+                for (i = 0; i <= n; i++) {
+                    drop_obj(r[op[2] + i]);
+                    r[op[2] + i] = NULL_OBJ;
+                }
+
+                // a failed `do` is not located, its failing item is
+                if (f->type != TYPE_VARY || f->i64 != (i64_t)ray_do)
+                    res = unwrap(res, op[4]);
+
+                r[op[1]] = res;
+                if (IS_ERR(res))
+                    break;
+                pc++;
+                continue;
+
+            case VM_EVAL:
+                r[op[1]] = eval((obj_p)op[2]);
+                if (IS_ERR(r[op[1]]))
+                    break;
+                pc++;
+                continue;
+
+            case VM_DROP:
+                drop_obj(r[op[1]]);
+                r[op[1]] = NULL_OBJ;
+                pc++;
+                continue;
+
+            case VM_JMP:
+                pc = op[1];
+                continue;
+
+            case VM_JMPF:
+                j = ops_as_b8(r[op[1]]);
+                drop_obj(r[op[1]]);
+                r[op[1]] = NULL_OBJ;
+                pc = j ? pc + 1 : op[2];
+                continue;
+
+            case VM_RET:
+                res = r[op[1]];
+                r[op[1]] = NULL_OBJ;
+                goto done;
+
+            default:
+                __builtin_unreachable();
+        }
+
+        // an error: the `if` forms around the failed instruction add their locations, innermost first
+        res = r[op[1]];
+        r[op[1]] = NULL_OBJ;
+
+        spans = AS_I64(AS_LIST(code)[VM_CODE_SPANS]);
+        l = AS_LIST(code)[VM_CODE_SPANS]->len;
+        for (i = 0; i < l; i += 3) {
+            if (pc >= spans[i] && pc < spans[i + 1])
+                unwrap(res, spans[i + 2]);
+        }
+
+        goto done;
+    }
+
+done:
+    for (i = 0; i < regs; i++)
+        drop_obj(r[i]);
+
+    __INTERPRETER->sp = rb;
+
+    return res;
+}
@@ -0,0 +1,56 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+
+#ifndef VM_H
+#define VM_H
+
+#include "rayforce.h"
+
+#define VM_WIDTH 6  // words per instruction: the opcode and up to 5 operands
+
+/*
+ * Instructions of a compiled lambda. Operands are registers (r), constants (k), argument slots, instruction
+ * indexes (pc) or the node of the body an instruction stands for, used for error locations and fallbacks.
+ */
+typedef enum vm_op_t {
+    VM_CONST = 0,  // r k            r = k
+    VM_ARG,        // r i            r = argument i
+    VM_GLOBAL,     // r sym node s v r = global sym, s caches its slot in the environment as of version v
+    VM_RESOLVE,    // r sym node     r = sym looked up through locals, arguments and globals
+    VM_UNARY,      // r fn a node    r = fn(a)
+    VM_BINARY,     // r fn a node    r = fn(a, a + 1)
+    VM_VARY,       // r fn a n node  r = fn(a .. a + n)
+    VM_PREP,       // r f n node pc  unless f is a plain function of n arguments: r = eval(node), jump to pc
+    VM_CALL,       // r f n node     r = f(f + 1 .. f + n)
+    VM_EVAL,       // r node         r = eval(node), for forms that are not compiled
+    VM_DROP,       // r              drop r
+    VM_JMP,        // pc             jump to pc
+    VM_JMPF,       // r pc           drop r, jump to pc if it was false
+    VM_RET,        // r              return r
+} vm_op_t;
+
+obj_p vm_compile(obj_p args, obj_p body);
+obj_p vm_exec(obj_p code);
+
+#endif  // VM_H
@@ -0,0 +1,296 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#include "zone.h"
+#include "ops.h"
+#include "util.h"
+#include "runtime.h"
+#include "serde.h"
+
+/*
+ * Zone maps: min and max of every ZONE_BLOCK rows of a column, stored next to splayed tables and consulted by
+ * comparisons to skip blocks whose outcome is known upfront. Nulls are the smallest values of a type for the
+ * comparisons, so they take part in min/max as is and the bounds stay valid for every operator.
+ */
+
+typedef enum zone_domain_t {
+    ZONE_DOMAIN_NONE = 0,
+    ZONE_DOMAIN_I64,
+    ZONE_DOMAIN_F64,
+    ZONE_DOMAIN_TIMESTAMP,
+} zone_domain_t;
+
+#define ZONE_SCAN(t, isnull, lt)                                  \
+    ({                                                            \
+        t##_t *$in = (t##_t *)AS_U8(col), $lo, $hi;               \
+        for (b = 0; b < n; b++) {                                 \
+            s = b * ZONE_BLOCK;                                   \
+            e = (s + ZONE_BLOCK < l) ? s + ZONE_BLOCK : l;        \
+            $lo = $hi = $in[s];                                   \
+            c = 0;                                                \
+            for (i = s; i < e; i++) {                             \
+                if (lt($in[i], $lo))                              \
+                    $lo = $in[i];                                 \
+                if (lt($hi, $in[i]))                              \
+                    $hi = $in[i];                                 \
+                c += isnull($in[i]);                              \
+            }                                                     \
+            ((t##_t *)AS_U8(mins))[b] = $lo;                      \
+            ((t##_t *)AS_U8(maxs))[b] = $hi;                      \
+            AS_I64(nulls)[b] = c;                                 \
+        }                                                         \
+    })
+
+#define ZONE_LT(x, y) ((x) < (y))
+#define ZONE_NULLI16(x) ((x) == NULL_I16)
+#define ZONE_NULLI32(x) ((x) == NULL_I32)
+#define ZONE_NULLI64(x) ((x) == NULL_I64)
+
+obj_p zone_build(obj_p col) {
+    i64_t i, b, s, e, c, l, n;
+    obj_p mins, maxs, nulls;
+
+    switch (col->type) {
+        case TYPE_I16:
+        case TYPE_I32:
+        case TYPE_I64:
+        case TYPE_DATE:
+        case TYPE_TIME:
+        case TYPE_TIMESTAMP:
+        case TYPE_F64:
+            break;
+        default:
+            return NULL_OBJ;
+    }
+
+    l = col->len;
+    n = (l + ZONE_BLOCK - 1) / ZONE_BLOCK;
+    mins = vector(col->type, n);
+    maxs = vector(col->type, n);
+    nulls = I64(n);
+
+    switch (col->type) {
+        case TYPE_I16:
+            ZONE_SCAN(i16, ZONE_NULLI16, ZONE_LT);
+            break;
+        case TYPE_I32:
+        case TYPE_DATE:
+        case TYPE_TIME:
+            ZONE_SCAN(i32, ZONE_NULLI32, ZONE_LT);
+            break;
+        case TYPE_I64:
+        case TYPE_TIMESTAMP:
+            ZONE_SCAN(i64, ZONE_NULLI64, ZONE_LT);
+            break;
+        default:
+            ZONE_SCAN(f64, ISNANF64, LTF64);
+            break;
+    }
+
+    return table(vn_symbol(3, "min", "max", "nulls"), vn_list(3, mins, maxs, nulls));
+}
+
+obj_p zone_get(obj_p col) {
+    if (!IS_EXTERNAL_SIMPLE(col))
+        return NULL_OBJ;
+
+    return runtime_zone_get(runtime_get(), col);
+}
+
+// Common domain both the column and the value convert to, keeping the order the comparisons use
+static zone_domain_t zone_domain(i8_t col, i8_t val) {
+    switch (MTYPE2(col, val)) {
+        case MTYPE2(TYPE_I16, TYPE_I16):
+        case MTYPE2(TYPE_I16, TYPE_I32):
+        case MTYPE2(TYPE_I16, TYPE_I64):
+        case MTYPE2(TYPE_I32, TYPE_I16):
+        case MTYPE2(TYPE_I32, TYPE_I32):
+        case MTYPE2(TYPE_I32, TYPE_I64):
+        case MTYPE2(TYPE_I64, TYPE_I16):
+        case MTYPE2(TYPE_I64, TYPE_I32):
+        case MTYPE2(TYPE_I64, TYPE_I64):
+        case MTYPE2(TYPE_DATE, TYPE_DATE):
+        case MTYPE2(TYPE_TIME, TYPE_TIME):
+        case MTYPE2(TYPE_TIMESTAMP, TYPE_TIMESTAMP):
+            return ZONE_DOMAIN_I64;
+        case MTYPE2(TYPE_DATE, TYPE_TIMESTAMP):
+        case MTYPE2(TYPE_TIMESTAMP, TYPE_DATE):
+            return ZONE_DOMAIN_TIMESTAMP;
+        case MTYPE2(TYPE_F64, TYPE_I16):
+        case MTYPE2(TYPE_F64, TYPE_I32):
+        case MTYPE2(TYPE_F64, TYPE_I64):
+        case MTYPE2(TYPE_F64, TYPE_F64):
+        case MTYPE2(TYPE_I16, TYPE_F64):
+        case MTYPE2(TYPE_I32, TYPE_F64):
+        case MTYPE2(TYPE_I64, TYPE_F64):
+            return ZONE_DOMAIN_F64;
+        default:
+            return ZONE_DOMAIN_NONE;
+    }
+}
+
+static i64_t zone_i64(i8_t type, raw_p p, zone_domain_t domain) {
+    switch (type) {
+        case TYPE_I16:
+            return i16_to_i64(*(i16_t *)p);
+        case TYPE_I32:
+            return i32_to_i64(*(i32_t *)p);
+        case TYPE_DATE:
+            return (domain == ZONE_DOMAIN_TIMESTAMP) ? date_to_timestamp(*(i32_t *)p) : date_to_i64(*(i32_t *)p);
+        case TYPE_TIME:
+            return time_to_i64(*(i32_t *)p);
+        default:
+            return *(i64_t *)p;
+    }
+}
+
+static f64_t zone_f64(i8_t type, raw_p p) {
+    switch (type) {
+        case TYPE_I16:
+            return i16_to_f64(*(i16_t *)p);
+        case TYPE_I32:
+            return i32_to_f64(*(i32_t *)p);
+        case TYPE_I64:
+            return i64_to_f64(*(i64_t *)p);
+        default:
+            return *(f64_t *)p;
+    }
+}
+
+#define ZONE_EQI64(x, y) ((x) == (y))
+
+#define ZONE_HIT(op, lo, hi, v, lt, eq)                        \
+    ({                                                          \
+        zone_hit_t $h;                                          \
+        switch (op) {                                           \
+            case ZONE_OP_EQ:                                    \
+                $h = (lt(v, lo) || lt(hi, v)) ? ZONE_NONE       \
+                     : (eq(lo, hi))           ? ZONE_ALL        \
+                                              : ZONE_SOME;      \
+                break;                                          \
+            case ZONE_OP_NE:                                    \
+                $h = (lt(v, lo) || lt(hi, v)) ? ZONE_ALL        \
+                     : (eq(lo, hi))           ? ZONE_NONE       \
+                                              : ZONE_SOME;      \
+                break;                                          \
+            case ZONE_OP_LT:                                    \
+                $h = lt(hi, v) ? ZONE_ALL : !lt(lo, v) ? ZONE_NONE : ZONE_SOME; \
+                break;                                          \
+            case ZONE_OP_GT:                                    \
+                $h = lt(v, lo) ? ZONE_ALL : !lt(v, hi) ? ZONE_NONE : ZONE_SOME; \
+                break;                                          \
+            case ZONE_OP_LE:                                    \
+                $h = !lt(v, hi) ? ZONE_ALL : lt(v, lo) ? ZONE_NONE : ZONE_SOME; \
+                break;                                          \
+            default:                                            \
+                $h = !lt(lo, v) ? ZONE_ALL : lt(hi, v) ? ZONE_NONE : ZONE_SOME; \
+                break;                                          \
+        }                                                       \
+        $h;                                                     \
+    })
+
+// Block of values compared against an atom
+zone_hit_t zone_cmp(obj_p zone, i64_t block, zone_op_t op, obj_p val) {
+    i64_t size;
+    zone_domain_t domain;
+    obj_p mins, maxs;
+
+    mins = AS_LIST(AS_LIST(zone)[1])[0];
+    maxs = AS_LIST(AS_LIST(zone)[1])[1];
+    domain = zone_domain(mins->type, -val->type);
+    size = size_of_type(mins->type);
+
+    switch (domain) {
+        case ZONE_DOMAIN_I64:
+        case ZONE_DOMAIN_TIMESTAMP:
+            return ZONE_HIT(op, zone_i64(mins->type, AS_U8(mins) + block * size, domain),
+                            zone_i64(maxs->type, AS_U8(maxs) + block * size, domain),
+                            zone_i64(-val->type, &val->i64, domain), ZONE_LT, ZONE_EQI64);
+        case ZONE_DOMAIN_F64:
+            return ZONE_HIT(op, zone_f64(mins->type, AS_U8(mins) + block * size),
+                            zone_f64(maxs->type, AS_U8(maxs) + block * size), zone_f64(-val->type, &val->i64), LTF64,
+                            EQF64);
+        default:
+            return ZONE_SOME;
+    }
+}
+
+// Block of values checked against an inclusive [from to] range
+zone_hit_t zone_within(obj_p zone, i64_t block, obj_p range) {
+    zone_hit_t from, to;
+    obj_p v;
+
+    if (range->len != 2)
+        return ZONE_SOME;
+
+    v = at_idx(range, 0);
+    from = zone_cmp(zone, block, ZONE_OP_GE, v);
+    drop_obj(v);
+
+    v = at_idx(range, 1);
+    to = zone_cmp(zone, block, ZONE_OP_LE, v);
+    drop_obj(v);
+
+    if (from == ZONE_NONE || to == ZONE_NONE)
+        return ZONE_NONE;
+
+    return (from == ZONE_ALL && to == ZONE_ALL) ? ZONE_ALL : ZONE_SOME;
+}
+
+// Block of values looked up in a vector of values
+zone_hit_t zone_in(obj_p zone, i64_t block, obj_p vals) {
+    i64_t i, l;
+    zone_hit_t hit, res = ZONE_NONE;
+    obj_p v;
+
+    l = vals->len;
+    for (i = 0; i < l && res != ZONE_ALL; i++) {
+        v = at_idx(vals, i);
+        hit = zone_cmp(zone, block, ZONE_OP_EQ, v);
+        drop_obj(v);
+
+        if (hit != ZONE_NONE)
+            res = hit;
+    }
+
+    return res;
+}
+
+// Outcome over several blocks
+zone_hit_t zone_reduce(zone_hit_t acc, zone_hit_t hit) { return (acc == hit) ? acc : ZONE_SOME; }
+
+// Operator giving the same outcome with its operands swapped
+zone_op_t zone_flip(zone_op_t op) {
+    switch (op) {
+        case ZONE_OP_LT:
+            return ZONE_OP_GT;
+        case ZONE_OP_GT:
+            return ZONE_OP_LT;
+        case ZONE_OP_LE:
+            return ZONE_OP_GE;
+        case ZONE_OP_GE:
+            return ZONE_OP_LE;
+        default:
+            return op;
+    }
+}
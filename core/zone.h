@@ -0,0 +1,56 @@
+/*
+ *   Copyright (c) 2024 Anton Kundenko <singaraiona@gmail.com>
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#ifndef ZONE_H
+#define ZONE_H
+
+#include "rayforce.h"
+
+#define ZONE_BLOCK 65536  // rows covered by a zone map entry
+#define ZONE_IN_MAX 64    // longest list of values checked against zone maps, each value costs a pass over them
+
+typedef enum zone_op_t {
+    ZONE_OP_EQ = 0,
+    ZONE_OP_NE,
+    ZONE_OP_LT,
+    ZONE_OP_GT,
+    ZONE_OP_LE,
+    ZONE_OP_GE,
+} zone_op_t;
+
+// What a block of values may yield for a predicate
+typedef enum zone_hit_t {
+    ZONE_NONE = 0,  // no value satisfies it
+    ZONE_SOME,      // unknown, values need to be checked
+    ZONE_ALL,       // every value satisfies it
+} zone_hit_t;
+
+obj_p zone_build(obj_p col);
+obj_p zone_get(obj_p col);
+zone_hit_t zone_cmp(obj_p zone, i64_t block, zone_op_t op, obj_p val);
+zone_hit_t zone_within(obj_p zone, i64_t block, obj_p range);
+zone_hit_t zone_in(obj_p zone, i64_t block, obj_p vals);
+zone_hit_t zone_reduce(zone_hit_t acc, zone_hit_t hit);
+zone_op_t zone_flip(zone_op_t op);
+
+#endif  // ZONE_H
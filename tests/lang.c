@@ -2476,6 +2476,14 @@ test_result_t test_lang_math() {
     TEST_ASSERT_EQ("(dev [0Nl 1 2 3 4 50 0Nl])", "19.0263");
     TEST_ASSERT_EQ("(dev [0Nf -2.0 10.0 11.0 5.0 0Nf])", "5.147815");
 
+    TEST_ASSERT_EQ(
+        "(set t (table [k v f] (list [a b a b a c] [5 1 0Nl 2 4 7] [5.0 1.0 3.0 0Nf 4.0 7.0])))"
+        "(select {m: (med v) d: (dev v) from: t by: k})",
+        "(table [k m d] (list [a b c] [4.5 1.5 7.0] [0.5 0.5 0.0]))");
+    TEST_ASSERT_EQ("(select {m: (med f) d: (dev f) from: t by: k})",
+                   "(table [k m d] (list [a b c] [4.0 1.0 7.0] [0.816497 0.0 0.0]))");
+    TEST_ASSERT_EQ("(select {m: (med v) from: t where: (> v 4) by: k})", "(table [k m] (list [a c] [5.0 7.0]))");
+
     TEST_ASSERT_EQ("((fn [x y] (+ x y)) 1 [2.3 4])", "[3.3 5.0]");
     TEST_ASSERT_EQ("(map count (list (list \"aaa\" \"bbb\")))", "[2]");
 
@@ -2728,6 +2736,24 @@ test_result_t test_lang_query() {
                    "(table [Symbol s]"
                    "(list [apll good msfk ibmd amznt fbad baba]"
                    "[7.00 9.00 11.00 3.00 4.00 5.00 6.00]))");
+    TEST_ASSERT_EQ("(select {c: (count v) from: (table [d v] (list [2024.01.02 2024.01.01 2024.01.02] [1 2 3])) by: d})",
+                   "(table [d c] (list [2024.01.02 2024.01.01] [2 1]))");
+    TEST_ASSERT_EQ("(select {a: a b: b from: (table [a b] (list (til 10) (take 10 [1 2])))"
+                   " where: (and (within a [2 7]) (== b 1) (> 6 a))})",
+                   "(table [a b] (list [2 4] [1 1]))");
+    TEST_ASSERT_EQ("(select {a: a from: (table [a] (list (til 10))) where: (> a 20)})", "(table [a] (list []))");
+    TEST_ASSERT_EQ("(set t (table [s v] (list (grouped [a b a c b]) (til 5))))"
+                   "(insert 't (list [c a] [5 6]))"
+                   "(select {v: v from: t where: (and (in s [a c]) (> v 1))})",
+                   "(table [v] (list [2 3 5 6]))");
+    TEST_ASSERT_EQ("(select {c: (count v) from: t by: s where: (> v 0)})", "(table [s c] (list [b a c] [2 2 2]))");
+    TEST_ASSERT_EQ("(set t (table [a b] (list (til 10) (% (til 10) 3))))"
+                   "(select {a: a c: (* 2 b) from: t where: (> b 0) take: 2})",
+                   "(table [a c] (list [1 2] [2 4]))");
+    TEST_ASSERT_EQ("(select {a: a from: t where: (> b 0) take: -3})", "(table [a] (list [5 7 8]))");
+    TEST_ASSERT_EQ("(select {a: a from: t where: (== b 0) take: 6})", "(table [a] (list [0 3 6 9 0 3]))");
+    TEST_ASSERT_EQ("(select {from: t take: -2})", "(table [a b] (list [8 9] [2 0]))");
+    TEST_ASSERT_EQ("(select {s: (sum a) from: t where: (> b 0) take: 2})", "(table [s] (list [27 27]))");
 
     // Test and with select - this exposes the parallel processing bug
     TEST_ASSERT_EQ(
@@ -3211,6 +3237,9 @@ test_result_t test_lang_cmp() {
         "(set t1 (enlist (as 'guid \"d49f18a4-1969-49e9-9b8a-6bb9a4832eea\"))) "
         "(set t2 (enlist (as 'guid \"d49f18a4-1969-49e9-9b8a-6bb9a4832eea\"))) (>= t1 t2)",
         "[true]");
+    TEST_ASSERT_EQ("(<= (til 5) 2)", "[true true true false false]");
+    TEST_ASSERT_EQ("(!= 2.5 (til 4))", "[true true true true]");
+    TEST_ASSERT_EQ("(== 'a (grouped [a b a c]))", "[true false true false]");
 
     PASS();
 }
@@ -3377,6 +3406,7 @@ test_result_t test_lang_in() {
     TEST_ASSERT_EQ("(in [3h 2h 5h 0Nh] [1 0Nl 2 3])", "[true true false true]");
     TEST_ASSERT_EQ("(in [3 2 5 0Nl -2147483648] [1i 0Ni 2i 3i])", "[true true false true false]");
     TEST_ASSERT_EQ("(in [3i 2i 0Ni] [1 0Nl 2 3])", "[true true true]");
+    TEST_ASSERT_EQ("(in (grouped [a b 0Ns a]) [a 0Ns z])", "[true false true true]");
     TEST_ASSERT_EQ("(in [3 2 5 0Nl] [1 0Nl 2 3])", "[true true false true]");
     TEST_ASSERT_EQ("(in (list 3h 2i 5 0Nl) [1 0Nl 2 3])", "(list true true false true)");
     TEST_ASSERT_EQ("(in [0 1 0Nl] 0Nl)", "[false false true]");
@@ -3466,3 +3496,63 @@ test_result_t test_lang_bin() {
     
     PASS();
 }
+
+test_result_t test_lang_join() {
+    TEST_ASSERT_EQ(
+        "(set t1 (table [k v] (list [1 2 3 2] [10 20 30 40])))"
+        "(set t2 (table [k w] (list [2 2 3 5] [100 200 300 500])))"
+        "(inner-join [k] t1 t2)",
+        "(table [k v w] (list [2 2 3 2 2] [20 20 30 40 40] [100 200 300 100 200]))");
+    TEST_ASSERT_EQ(
+        "(set t3 (table [k s v] (list [1 2 2 2] [a b b c] [10 20 30 40])))"
+        "(set t4 (table [k s w] (list [2 2 1 2] [b c a b] [100 200 300 400])))"
+        "(inner-join [k s] t3 t4)",
+        "(table [k s v w] (list [1 2 2 2 2 2] [a b b b b c] [10 20 20 30 30 40] [300 100 400 100 400 200]))");
+    TEST_ASSERT_EQ("(left-join [k s] t3 t4)",
+                   "(table [k s v w] (list [1 2 2 2] [a b b c] [10 20 30 40] [300 100 100 200]))");
+
+    PASS();
+}
+
+test_result_t test_lang_asof_join() {
+    TEST_ASSERT_EQ(
+        "(set t (table [s ts q] (list [a b a c a] [1 5 10 3 20] [1 2 3 4 5])))"
+        "(set u (table [s ts b] (list [a a b a b] [2 8 4 15 6] [10 20 30 40 50])))"
+        "(asof-join [s ts] t u)",
+        "(table [s ts q b] (list [a b a c a] [1 5 10 3 20] [1 2 3 4 5] (list null 30 20 null 40)))");
+    TEST_ASSERT_EQ(
+        "(set t (table [s ts q] (list [a a a b] (as 'Timestamp [1 3 9 4]) [1 2 3 4])))"
+        "(set u (table [s ts b] (list [a a b a] (as 'Timestamp [2 3 1 8]) [10 20 30 40])))"
+        "(at (asof-join [s ts] t u) 'b)",
+        "(list null 20 40 30)");
+    TEST_ASSERT_EQ(
+        "(set t (table [s ts q] (list [a b a] [1.5 2.5 3.5] [1 2 3])))"
+        "(set u (table [s ts b] (list [a b a] [1.0 3.0 3.5] [10 20 30])))"
+        "(at (asof-join [s ts] t u) 'b)",
+        "(list 10 null 30)");
+    TEST_ASSERT_EQ(
+        "(set t (table [s ts q] (list [a b a c a] [1 5 10 3 20] [1 2 3 4 5])))"
+        "(set u (table [s ts b] (list [a a b a b] [2 8 4 15 6] [10 20 30 40 50])))"
+        "(set w (list (- (at t 'ts) 5) (+ (at t 'ts) 5)))"
+        "(at (window-join [s ts] w t u {b: (sum b)}) 'b)",
+        "[10 80 70 0Nl 40]");
+    TEST_ASSERT_EQ("(at (window-join1 [s ts] w t u {b: (sum b)}) 'b)", "[10 80 60 0Nl 40]");
+
+    PASS();
+}
+
+test_result_t test_lang_lambda() {
+    TEST_ASSERT_EQ("(set fib (fn [n] (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))) (fib 15)", "610");
+    TEST_ASSERT_EQ("((fn [n] (if (== n 0) 0 (+ n (self (- n 1))))) 100)", "5050");
+    TEST_ASSERT_EQ("((fn [x] (let y (* x 2)) (let x 100) (+ x y)) 5)", "110");
+    TEST_ASSERT_EQ("((fn [x] (if (> x 0) 'pos)) -1)", "null");
+    TEST_ASSERT_EQ("(set f (fn [x] (if (> x 0) (return 42)) 7)) (list (f 1) (f 0))", "(list 42 7)");
+    TEST_ASSERT_EQ("(set f (fn [x] (set g x) (+ g 1))) (f 9)", "10");
+    TEST_ASSERT_EQ("(set f (fn [x] (and (> x 0) (< x 9)))) (list (f 1) (f 10))", "(list true false)");
+    TEST_ASSERT_EQ("(fold (fn [a x] (+ a (* x 2))) (til 10))", "90");
+    TEST_ASSERT_EQ("(set f (fn [x] (+ x zz))) (set zz 1) (f 1) (set zz0 0) (set zz 10) (f 1)", "11");
+    TEST_ASSERT_ER("((fn [x] (undefinedfn x)) 1)", "undefined symbol");
+    TEST_ASSERT_ER("((fn [x] (if (> x 0) (+ x 'a) 0)) 1)", "type");
+
+    PASS();
+}
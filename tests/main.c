@@ -37,6 +37,7 @@
 #include "../core/parse.h"
 #include "../core/runtime.h"
 #include "../core/cmp.h"
+#include "../core/compress.h"
 #include "../core/eval.h"
 
 typedef enum test_status_t { TEST_PASS = 0, TEST_FAIL } test_status_t;
@@ -187,7 +188,10 @@ test_entry_t tests[] = {
     {"test_asc_desc", test_asc_desc},
     {"test_sort_xasc", test_sort_xasc},
     {"test_sort_xdesc", test_sort_xdesc},
+    {"test_sort_take", test_sort_take},
     {"test_str_match", test_str_match},
+    {"test_str_pat_match", test_str_pat_match},
+    {"test_strings", test_strings},
     {"test_lang_basic", test_lang_basic},
     {"test_lang_math", test_lang_math},
     {"test_lang_take", test_lang_take},
@@ -198,6 +202,8 @@ test_entry_t tests[] = {
     {"test_lang_cmp", test_lang_cmp},
     {"test_lang_split", test_lang_split},
     {"test_serde_different_sizes", test_serde_different_sizes},
+    {"test_serde_symdict", test_serde_symdict},
+    {"test_serde_compress", test_serde_compress},
     {"test_lang_distinct", test_lang_distinct},
     {"test_lang_concat", test_lang_concat},
     {"test_lang_filter", test_lang_filter},
@@ -206,6 +212,9 @@ test_entry_t tests[] = {
     {"test_lang_or", test_lang_or},
     {"test_lang_and", test_lang_and},
     {"test_lang_bin", test_lang_bin},
+    {"test_lang_join", test_lang_join},
+    {"test_lang_asof_join", test_lang_asof_join},
+    {"test_lang_lambda", test_lang_lambda},
 };
 // ---
 
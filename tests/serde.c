@@ -36,4 +36,96 @@ test_result_t test_serde_different_sizes() {
     TEST_ASSERT(size == size1, "size != size1");
 
     PASS();
-}
\ No newline at end of file
+}
+
+test_result_t test_serde_symdict() {
+    u8_t buf[4096];
+    i64_t i, size, size1;
+    obj_p x, y;
+
+    x = SYMBOL(100);
+    for (i = 0; i < 100; i++)
+        AS_SYMBOL(x)[i] = symbols_intern((i % 3) ? "banana" : "apple", (i % 3) ? 6 : 5);
+
+    // plain strings
+    size = size_obj_with(x, 0);
+    size1 = ser_raw_with(buf, x, 0);
+    TEST_ASSERT(size == size1, "plain: size != size1");
+    TEST_ASSERT(buf[1] == 0, "plain: attrs should be 0");
+
+    // dictionary and byte codes
+    size = size_obj_with(x, SERDE_FLAG_SYMDICT);
+    size1 = ser_raw_with(buf, x, SERDE_FLAG_SYMDICT);
+    TEST_ASSERT(size == size1, "symdict: size != size1");
+    TEST_ASSERT(buf[1] == 1, "symdict: codes should be 1 byte wide");
+    TEST_ASSERT(size == 1 + 1 + 8 + 8 + 6 + 7 + 100, "symdict: unexpected size");
+
+    y = de_raw(buf, &size1);
+    TEST_ASSERT(size1 == 0, "symdict: buffer should be consumed");
+    TEST_ASSERT(cmp_obj(x, y) == 0, "symdict: x != de(ser(x))");
+
+    drop_obj(y);
+    drop_obj(x);
+
+    TEST_ASSERT_EQ("(de (ser (at [a b c] (% (til 1000) 3))))", "(at [a b c] (% (til 1000) 3))");
+    TEST_ASSERT_EQ("(de (ser (table [s v] (list (take 50 [x y]) (til 50)))))",
+                   "(table [s v] (list (take 50 [x y]) (til 50)))");
+
+    PASS();
+}
+
+test_result_t test_serde_compress() {
+    i64_t i, n;
+    obj_p x, y, z, buf;
+
+    // one vector per filter, spanning a few blocks, plus a serialized object
+    n = 3 * COMPRESS_BLOCK_SIZE / ISIZEOF(i64_t) + 17;
+
+    x = LIST(6);
+    AS_LIST(x)[0] = I64(n);
+    AS_LIST(x)[1] = vector(TYPE_TIMESTAMP, n);
+    AS_LIST(x)[2] = F64(n);
+    AS_LIST(x)[3] = I64(n);
+    AS_LIST(x)[4] = vector(TYPE_I32, n);
+    AS_LIST(x)[5] = U8(n);
+
+    for (i = 0; i < n; i++) {
+        AS_I64(AS_LIST(x)[0])[i] = i * 3;
+        AS_TIMESTAMP(AS_LIST(x)[1])[i] = 1000000000ll * i + (i % 7);
+        AS_F64(AS_LIST(x)[2])[i] = (f64_t)(i % 1000) / 7.0;
+        AS_I64(AS_LIST(x)[3])[i] = -5000 + (i * 7919) % 10007;
+        AS_I32(AS_LIST(x)[4])[i] = (i32_t)((i * 31) % 100);
+        AS_U8(AS_LIST(x)[5])[i] = (u8_t)(i * i);
+    }
+
+    AS_LIST(x)[0]->attrs |= ATTR_ASC;
+
+    for (i = 0; i < x->len; i++) {
+        buf = compress_vector(AS_LIST(x)[i]);
+        TEST_ASSERT(buf->type == TYPE_U8, "compress: expected a byte vector");
+        y = decompress_obj(AS_U8(buf), buf->len);
+        TEST_ASSERT(!IS_ERR(y), "decompress: unexpected error");
+        TEST_ASSERT(cmp_obj(AS_LIST(x)[i], y) == 0, "decompress: x != decompress(compress(x))");
+        TEST_ASSERT(y->attrs == AS_LIST(x)[i]->attrs, "decompress: attributes are lost");
+        drop_obj(y);
+
+        // a truncated frame yields an error rather than garbage
+        y = decompress_obj(AS_U8(buf), buf->len - 1);
+        TEST_ASSERT(IS_ERR(y), "decompress: a truncated frame should fail");
+        drop_obj(y);
+        drop_obj(buf);
+    }
+
+    z = ser_obj(x);
+    buf = compress_bytes(AS_U8(z) + ISIZEOF(struct ipc_header_t), z->len - ISIZEOF(struct ipc_header_t));
+    TEST_ASSERT(buf->len < z->len, "compress: serialized vectors should shrink");
+    y = decompress_obj(AS_U8(buf), buf->len);
+    TEST_ASSERT(cmp_obj(x, y) == 0, "decompress: x != de(decompress(compress(ser(x))))");
+
+    drop_obj(y);
+    drop_obj(buf);
+    drop_obj(z);
+    drop_obj(x);
+
+    PASS();
+}
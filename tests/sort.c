@@ -94,6 +94,15 @@ test_result_t test_sort_asc() {
 
     TEST_ASSERT_EQ("(iasc ['d 'b 'aa 'ab 'a 'bc 'c])", "[4 2 3 1 5 6 0]");
     TEST_ASSERT_EQ("(asc ['d 'b 'aa 'ab 'a 'bc 'c])", "['a 'aa 'ab 'b 'bc 'c 'd]");
+    TEST_ASSERT_EQ("(take 4 (asc (take 1000 [zz bb 0Ns aa])))", "[0Ns 0Ns 0Ns 0Ns]");
+    TEST_ASSERT_EQ("(take 3 (desc (take 1000 [bb zz aa])))", "[zz zz zz]");
+
+    // results of arithmetic on sorted vectors are sorted again
+    TEST_ASSERT_EQ("(iasc (% (til 6) 3))", "[0 3 1 4 2 5]");
+
+    // wide keys are split by their most significant digit first
+    TEST_ASSERT_EQ("(take 3 (iasc (* -1.5 (til 100000))))", "[99999 99998 99997]");
+    TEST_ASSERT_EQ("(take 3 (iasc (* (% (til 100000) 3) 1000000000000)))", "[0 3 6]");
 
     PASS();
 }
@@ -181,6 +190,8 @@ test_result_t test_sort_xasc() {
     TEST_ASSERT_EQ("(xasc (table ['a 'b] (list [2 1 2] [20 10 10])) ['b 'a])",
                    "(table ['a 'b] (list [1 2 2] [10 10 20]))");
     TEST_ASSERT_EQ("(xasc (table ['a 'b] (list [1 1 1] [3 2 1])) ['a 'b])", "(table ['a 'b] (list [1 1 1] [1 2 3]))");
+    TEST_ASSERT_EQ("(xasc (table [s v] (list [b a b a] [2.0 1.0 1.0 2.0])) [s v])",
+                   "(table [s v] (list [a a b b] [1.0 2.0 1.0 2.0]))");
 
     // Test sorting by time column
     TEST_ASSERT_EQ(
@@ -280,6 +291,19 @@ test_result_t test_sort_xdesc() {
     PASS();
 }
 
+test_result_t test_sort_take() {
+    TEST_ASSERT_EQ("(set v (% (* 7 (til 100)) 31)) (take 3 (iasc v))", "[0 31 62]");
+    TEST_ASSERT_EQ("(take -3 (iasc v))", "[22 53 84]");
+    TEST_ASSERT_EQ("(take 4 (desc v))", "[30 30 30 29]");
+    TEST_ASSERT_EQ("(take 5 (asc [3 1 2]))", "[1 2 3 1 2]");
+    TEST_ASSERT_EQ("(take 2 (xasc (table [a b] (list (% (til 100) 4) (- 100 (til 100)))) [a b]))",
+                   "(table [a b] (list [0 0] [4 8]))");
+    TEST_ASSERT_EQ("(take -2 (xdesc (table [a b] (list (% (til 100) 4) (- 100 (til 100)))) [a b]))",
+                   "(table [a b] (list [0 0] [8 4]))");
+
+    PASS();
+}
+
 test_result_t test_sort_timsort_symbols() {
     TEST_ASSERT_EQ("(iasc (list 'zebra 'apple 'banana 'cherry))", "[1 2 3 0]");
     TEST_ASSERT_EQ("(asc (list 'zebra 'apple 'banana 'cherry))", "(list 'apple 'banana 'cherry 'zebra)");
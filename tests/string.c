@@ -42,6 +42,72 @@ test_result_t test_str_match() {
     TEST_ASSERT(str_match("abcdefg", 7, "*c*g", 4), "abcdefg should match *c*g");
     TEST_ASSERT(str_match("abcdefg", 7, "a*d*g", 5), "abcdefg should match a*d*g");
     TEST_ASSERT(!str_match("abcdefg", 7, "a*x*g", 5), "abcdefg should not match a*x*g");
+    TEST_ASSERT(str_match("xabcabc", 7, "*abc", 4), "xabcabc should match *abc");
+    TEST_ASSERT(str_match("abab", 4, "*a?", 3), "abab should match *a?");
+
+    PASS();
+}
+
+test_result_t test_str_pat_match() {
+    str_pat_t p;
+
+    str_pat_compile(&p, "*abc", 4);
+    TEST_ASSERT(p.kind == STR_PAT_SUFFIX, "*abc should compile to a suffix");
+    TEST_ASSERT(str_pat_match(&p, "xabcabc", 7), "xabcabc should match *abc");
+    TEST_ASSERT(!str_pat_match(&p, "bc", 2), "bc should not match *abc");
+
+    str_pat_compile(&p, "ab**", 4);
+    TEST_ASSERT(p.kind == STR_PAT_PREFIX, "ab** should compile to a prefix");
+    TEST_ASSERT(str_pat_match(&p, "abc", 3), "abc should match ab**");
+
+    str_pat_compile(&p, "*35=0*", 6);
+    TEST_ASSERT(p.kind == STR_PAT_INFIX, "*35=0* should compile to an infix");
+    TEST_ASSERT(str_pat_match(&p, "8=FIX.4.29=004835=049=TR", 24), "FIX message should match *35=0*");
+    TEST_ASSERT(!str_pat_match(&p, "8=FIX.4.29=004835=A49=TR", 24), "FIX message should not match *35=0*");
+
+    str_pat_compile(&p, "[^wertf]ro?n", 12);
+    TEST_ASSERT(p.kind == STR_PAT_CLASSES, "[^wertf]ro?n should compile to classes");
+    TEST_ASSERT(str_pat_match(&p, "brown", 5), "brown should match [^wertf]ro?n");
+    TEST_ASSERT(!str_pat_match(&p, "frown", 5), "frown should not match [^wertf]ro?n");
+    TEST_ASSERT(!str_pat_match(&p, "brow", 4), "brow should not match [^wertf]ro?n");
+
+    str_pat_compile(&p, "br[?*]wn", 8);
+    TEST_ASSERT(!str_pat_match(&p, "brown", 5), "brown should not match br[?*]wn");
+
+    str_pat_compile(&p, "a*d*g", 5);
+    TEST_ASSERT(p.kind == STR_PAT_GLOB, "a*d*g should be left to str_match");
+    TEST_ASSERT(str_pat_match(&p, "abcdefg", 7), "abcdefg should match a*d*g");
+
+    TEST_ASSERT_EQ("(like [apple apricot banana] \"ap*\")", "[true true false]");
+    TEST_ASSERT_EQ("(like (grouped [apple banana apple]) \"*an*\")", "[false true false]");
+    TEST_ASSERT_EQ("(set d [apple apricot banana]) (like (enum 'd [banana apple banana]) \"?????\")",
+                   "[false true false]");
+    TEST_ASSERT_EQ("(like 'apple \"a*e\")", "true");
+
+    PASS();
+}
+
+test_result_t test_strings() {
+    TEST_ASSERT_EQ("(type (as 'Strings (list \"apple\" \"banana\")))", "'Strings");
+    TEST_ASSERT_EQ("(count (as 'Strings (list \"apple\" \"\" \"banana\")))", "3");
+    TEST_ASSERT_EQ("(at (as 'Strings (list \"apple\" \"\" \"banana\")) -1)", "\"banana\"");
+    TEST_ASSERT_EQ("(at (as 'Strings (list \"apple\" \"\" \"banana\")) [2 0])",
+                   "(as 'Strings (list \"banana\" \"apple\"))");
+    TEST_ASSERT_EQ("(type (at (as 'Strings (list \"apple\" \"banana\")) [1 1 0]))", "'Strings");
+    TEST_ASSERT_EQ("(== (as 'Strings (list \"apple\" \"\" \"apple\")) \"apple\")", "[true false true]");
+    TEST_ASSERT_EQ("(like (as 'Strings (list \"apple\" \"banana\" \"apricot\")) \"ap*\")", "[true false true]");
+    TEST_ASSERT_EQ("(distinct (as 'Strings (list \"b\" \"a\" \"b\" \"\" \"a\")))",
+                   "(as 'Strings (list \"b\" \"a\" \"\"))");
+    TEST_ASSERT_EQ("(value (group (as 'Strings (list \"b\" \"a\" \"b\"))))", "(list [0 2] [1])");
+    TEST_ASSERT_EQ("(take 3 (as 'Strings (list \"a\" \"b\")))", "(as 'Strings (list \"a\" \"b\" \"a\"))");
+    TEST_ASSERT_EQ("(as 'List (de (ser (as 'Strings (list \"apple\" \"\" \"banana\")))))",
+                   "(list \"apple\" \"\" \"banana\")");
+    TEST_ASSERT_EQ("(as 'Symbol (as 'Strings [apple banana]))", "[apple banana]");
+    TEST_ASSERT_EQ(
+        "(set t (table [k v] (list (as 'Strings (list \"x\" \"y\" \"x\")) [1 2 3])))"
+        "(select {v: (sum v) from: t by: k})",
+        "(table [k v] (list (as 'Strings (list \"x\" \"y\")) [4 2]))");
+    TEST_ASSERT_ER("(as 'Strings (list \"a\" 1))", "expected a list of 'String");
 
     PASS();
 }